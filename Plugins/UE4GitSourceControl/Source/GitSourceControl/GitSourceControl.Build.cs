@@ -27,6 +27,10 @@ public class GitSourceControl : ModuleRules
 				"UnrealEd",
 				"SourceControl",
 				"Projects",
+				"DirectoryWatcher",
+				"HTTP",
+				"HTTPServer",
+				"Json",
                 "Engine",
 			}
 		);
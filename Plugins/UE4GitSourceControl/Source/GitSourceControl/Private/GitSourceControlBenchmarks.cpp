@@ -0,0 +1,677 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/FileManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "ISourceControlModule.h"
+#include "SourceControlOperations.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlLfsLocksClient.h"
+#include "GitSourceControlLfsLocksStubServer.h"
+#include "GitSourceControlProcessPool.h"
+#include "GitSourceControlOutputReader.h"
+#include "GitSourceControlUtils.h"
+#include "GitSourceControlStateCache.h"
+
+/**
+ * Console commands measuring the cost of the Git operations of the plugin, to be run in the Editor with the Git provider connected.
+ */
+namespace GitSourceControlBenchmarks
+{
+
+/**
+ * Run one synchronous "UpdateStatus" operation and return the number of Git processes spawned:
+ * a plain one (like a refresh of the Content Browser), or with the history (like the "History" and "Diff" windows).
+ * All the files are made dirty first, so that their status is queried and not served from the cache.
+ */
+static int32 RunUpdateStatusCycle(const TArray<FString>& InFiles, const bool bInUpdateHistory, double& OutSeconds)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	GitSourceControl.GetProvider().GetChangeTracker().MarkAllDirty();
+
+	TSharedRef<FUpdateStatus, ESPMode::ThreadSafe> UpdateStatusOperation = ISourceControlOperation::Create<FUpdateStatus>();
+	UpdateStatusOperation->SetUpdateHistory(bInUpdateHistory);
+
+	FGitProcessPool::ResetCounters();
+	const double StartTime = FPlatformTime::Seconds();
+	GitSourceControl.GetProvider().Execute(UpdateStatusOperation, InFiles, EConcurrency::Synchronous);
+	OutSeconds = FPlatformTime::Seconds() - StartTime;
+	return FGitProcessPool::GetNumProcessSpawns();
+}
+
+/**
+ * "Git.Benchmark.UpdateStatusSpawns [MaxFiles]"
+ *
+ * Count the Git processes spawned by a plain UpdateStatus cycle and by one with the history on the assets of the project,
+ * first with one process per query, then with the long-lived helper processes (cold, then warm).
+ */
+static void UpdateStatusSpawns(const TArray<FString>& InArgs)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	if(!GitSourceControl.GetProvider().IsAvailable())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git.Benchmark.UpdateStatusSpawns: the Git source control provider is not connected"));
+		return;
+	}
+
+	const int32 MaxFiles = (InArgs.Num() > 0) ? FCString::Atoi(*InArgs[0]) : 100;
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFilesRecursive(Files, *FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()), TEXT("*.uasset"), true, false);
+	if(MaxFiles > 0 && Files.Num() > MaxFiles)
+	{
+		Files.SetNum(MaxFiles);
+	}
+
+	FGitProcessPool& ProcessPool = FGitProcessPool::Get();
+	const bool bWasEnabled = ProcessPool.IsEnabled();
+
+	for(const bool bUpdateHistory : { false, true })
+	{
+		double SpawnSeconds, PooledColdSeconds, PooledWarmSeconds;
+		ProcessPool.SetEnabled(false);
+		const int32 SpawnCount = RunUpdateStatusCycle(Files, bUpdateHistory, SpawnSeconds);
+		ProcessPool.SetEnabled(true);
+		ProcessPool.Shutdown();
+		const int32 PooledColdCount = RunUpdateStatusCycle(Files, bUpdateHistory, PooledColdSeconds);
+		const int32 PooledWarmCount = RunUpdateStatusCycle(Files, bUpdateHistory, PooledWarmSeconds);
+		const int32 PooledRequests = FGitProcessPool::GetNumPooledRequests();
+
+		UE_LOG(LogSourceControl, Display, TEXT("UpdateStatus of %d files%s:"), Files.Num(), bUpdateHistory ? TEXT(" with history") : TEXT(""));
+		UE_LOG(LogSourceControl, Display, TEXT("  one process per query:  %4d processes spawned in %.3lfs"), SpawnCount, SpawnSeconds);
+		UE_LOG(LogSourceControl, Display, TEXT("  helper processes, cold: %4d processes spawned in %.3lfs"), PooledColdCount, PooledColdSeconds);
+		UE_LOG(LogSourceControl, Display, TEXT("  helper processes, warm: %4d processes spawned in %.3lfs (%d requests served by helpers)"), PooledWarmCount, PooledWarmSeconds, PooledRequests);
+	}
+	ProcessPool.SetEnabled(bWasEnabled);
+}
+
+static FAutoConsoleCommand UpdateStatusSpawnsCommand(
+	TEXT("Git.Benchmark.UpdateStatusSpawns"),
+	TEXT("Count the Git processes spawned by a plain UpdateStatus cycle and by one with the history, with and without the long-lived helper processes. Usage: Git.Benchmark.UpdateStatusSpawns [MaxFiles=100]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&UpdateStatusSpawns));
+
+/**
+ * Count the heap allocations made by the current thread while in scope, by putting a proxy in front of the global allocator.
+ * Only for the benchmarks: the proxy stays installed until the end of the scope, and forwards everything to the real allocator.
+ */
+class FScopedAllocationCounter : public FMalloc
+{
+public:
+	FScopedAllocationCounter()
+		: InnerMalloc(GMalloc)
+		, ThreadId(FPlatformTLS::GetCurrentThreadId())
+	{
+		GMalloc = this;
+	}
+	virtual ~FScopedAllocationCounter()
+	{
+		GMalloc = InnerMalloc;
+	}
+
+	/** Number of allocations and reallocations made by the thread that created the counter */
+	int64 GetNumAllocations() const
+	{
+		return NumAllocations.GetValue();
+	}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if(Count > 0)
+		{
+			CountAllocation();
+		}
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		InnerMalloc->Trim(bTrimThreadCaches);
+	}
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return InnerMalloc->GetDescriptiveName();
+	}
+
+private:
+	void CountAllocation()
+	{
+		if(FPlatformTLS::GetCurrentThreadId() == ThreadId)
+		{
+			NumAllocations.Increment();
+		}
+	}
+
+	FMalloc* InnerMalloc;
+	uint32 ThreadId;
+	FThreadSafeCounter64 NumAllocations;
+};
+
+/** Run one command both ways and log the allocations made to gather its output */
+static void CompareOutputParsing(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InCommand, const TArray<FString>& InParameters)
+{
+	// Previous path: the whole output in one FString, then one FString per line
+	double StartTime = FPlatformTime::Seconds();
+	TArray<FString> Results;
+	TArray<FString> ErrorMessages;
+	int64 StringsAllocations;
+	{
+		FScopedAllocationCounter AllocationCounter;
+		GitSourceControlUtils::RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, TArray<FString>(), Results, ErrorMessages);
+		StringsAllocations = AllocationCounter.GetNumAllocations();
+	}
+	const double StringsSeconds = FPlatformTime::Seconds() - StartTime;
+
+	// Streaming path: one arena and one array of views
+	StartTime = FPlatformTime::Seconds();
+	FGitOutputReader Reader;
+	TArray<FString> StreamedErrorMessages;
+	int64 ReaderAllocations;
+	{
+		FScopedAllocationCounter AllocationCounter;
+		GitSourceControlUtils::RunCommandStreamed(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, TArray<FString>(), Reader, StreamedErrorMessages);
+		ReaderAllocations = AllocationCounter.GetNumAllocations();
+	}
+	const double ReaderSeconds = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogSourceControl, Display, TEXT("git %s %s: %d lines, %lld bytes"), *InCommand, *FString::Join(InParameters, TEXT(" ")), Reader.GetRecords().Num(), Reader.GetNumBytes());
+	UE_LOG(LogSourceControl, Display, TEXT("  FString per line: %6lld allocations in %.3lfs"), StringsAllocations, StringsSeconds);
+	UE_LOG(LogSourceControl, Display, TEXT("  streaming reader: %6lld allocations in %.3lfs (%d by the reader itself)"), ReaderAllocations, ReaderSeconds, Reader.GetNumAllocations());
+}
+
+/**
+ * "Git.Benchmark.OutputParsing"
+ *
+ * Compare the heap allocations made to gather the output of "status" and "ls-files" on the whole repository,
+ * with one FString per line, and with the streaming reader.
+ */
+static void OutputParsing(const TArray<FString>& InArgs)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	if(!GitSourceControl.GetProvider().IsAvailable())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git.Benchmark.OutputParsing: the Git source control provider is not connected"));
+		return;
+	}
+
+	const FString PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
+	const FString& RepositoryRoot = GitSourceControl.GetProvider().GetPathToRepositoryRoot();
+
+	TArray<FString> StatusParameters;
+	StatusParameters.Add(TEXT("--porcelain"));
+	StatusParameters.Add(TEXT("--ignored"));
+	CompareOutputParsing(PathToGitBinary, RepositoryRoot, TEXT("status"), StatusParameters);
+	CompareOutputParsing(PathToGitBinary, RepositoryRoot, TEXT("ls-files"), TArray<FString>());
+}
+
+static FAutoConsoleCommand OutputParsingCommand(
+	TEXT("Git.Benchmark.OutputParsing"),
+	TEXT("Compare the heap allocations made to gather the output of git status and ls-files, with one string per line and with the streaming reader."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&OutputParsing));
+
+/** Worker thread of the StateCacheStress benchmark: add, look up and remove random files until told to stop, and return the number of operations */
+static int64 HammerStateCache(FGitSourceControlStateCache& InStateCache, const TArray<FString>& InFiles, const int32 InSeed, const FThreadSafeBool& bInStop)
+{
+	FRandomStream Random(InSeed);
+	int64 NumOperations = 0;
+	while(!bInStop)
+	{
+		const FString& File = InFiles[Random.RandHelper(InFiles.Num())];
+		const int32 Operation = Random.RandHelper(100);
+		if(Operation < 30)
+		{
+			InStateCache.FindOrAdd(File, false); // like GetState()
+		}
+		else if(Operation < 60)
+		{
+			FGitSourceControlState State(File, false); // like UpdateCachedStates()
+			State.WorkingCopyState = (Random.RandHelper(10) == 0) ? EWorkingCopyState::Modified : EWorkingCopyState::Unchanged;
+			InStateCache.Update(State, FDateTime());
+		}
+		else if(Operation < 95)
+		{
+			InStateCache.Find(File);
+		}
+		else if(Operation < 99)
+		{
+			InStateCache.Remove(File); // like the Delete and Revert operations
+		}
+		else
+		{
+			TArray<FString> Filenames;
+			InStateCache.GetFilenames(Filenames); // like the Revert operation without files
+		}
+		++NumOperations;
+	}
+	return NumOperations;
+}
+
+/**
+ * "Git.Benchmark.StateCacheStress [Threads] [Files] [Seconds]"
+ *
+ * Hammer a standalone state cache from many worker threads while the game thread looks up files like the Content Browser does,
+ * and report the throughput of the workers and the latency of the game thread lookups.
+ */
+static void StateCacheStress(const TArray<FString>& InArgs)
+{
+	const int32 NumThreads = FMath::Max((InArgs.Num() > 0) ? FCString::Atoi(*InArgs[0]) : 8, 1);
+	const int32 NumFiles = FMath::Max((InArgs.Num() > 1) ? FCString::Atoi(*InArgs[1]) : 20000, 1);
+	const double Duration = FMath::Max((InArgs.Num() > 2) ? FCString::Atod(*InArgs[2]) : 2.0, 0.1);
+
+	const FString ContentDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir());
+	TArray<FString> Files;
+	Files.Reserve(NumFiles);
+	for(int32 Index = 0; Index < NumFiles; ++Index)
+	{
+		Files.Add(FString::Printf(TEXT("%sStress/Folder%d/Asset%d.uasset"), *ContentDir, Index % 100, Index));
+	}
+
+	FGitSourceControlStateCache StateCache;
+	for(int32 Index = 0; Index < NumFiles; Index += 2)
+	{
+		StateCache.FindOrAdd(Files[Index], false);
+	}
+
+	FThreadSafeBool bStop(false);
+	TArray<TFuture<int64>> Workers;
+	for(int32 Thread = 0; Thread < NumThreads; ++Thread)
+	{
+		Workers.Add(Async(EAsyncExecution::Thread, [&StateCache, &Files, &bStop, Thread]()
+		{
+			return HammerStateCache(StateCache, Files, Thread + 1, bStop);
+		}));
+	}
+
+	// Game thread: look up files like the Content Browser icons, and measure the worst case
+	FRandomStream Random(0);
+	int64 NumLookups = 0;
+	double MaxLookupSeconds = 0.0;
+	const double StartTime = FPlatformTime::Seconds();
+	double LookupsSeconds = 0.0;
+	while(LookupsSeconds < Duration)
+	{
+		const FString& File = Files[Random.RandHelper(NumFiles)];
+		const double LookupStartTime = FPlatformTime::Seconds();
+		StateCache.Find(File);
+		const double LookupEndTime = FPlatformTime::Seconds();
+		MaxLookupSeconds = FMath::Max(MaxLookupSeconds, LookupEndTime - LookupStartTime);
+		LookupsSeconds = LookupEndTime - StartTime;
+		++NumLookups;
+	}
+	bStop = true;
+
+	int64 NumOperations = 0;
+	for(TFuture<int64>& Worker : Workers)
+	{
+		NumOperations += Worker.Get();
+	}
+	const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogSourceControl, Display, TEXT("State cache hammered by %d threads on %d files for %.2lfs (%d files left in the cache):"), NumThreads, NumFiles, TotalSeconds, StateCache.Num());
+	UE_LOG(LogSourceControl, Display, TEXT("  worker threads: %10.0lf operations/s"), NumOperations / TotalSeconds);
+	UE_LOG(LogSourceControl, Display, TEXT("  game thread:    %10.0lf lookups/s, %.3lfus on average, %.3lfus at worst"), NumLookups / LookupsSeconds, LookupsSeconds * 1000000.0 / NumLookups, MaxLookupSeconds * 1000000.0);
+}
+
+static FAutoConsoleCommand StateCacheStressCommand(
+	TEXT("Git.Benchmark.StateCacheStress"),
+	TEXT("Hammer a state cache from many threads while the game thread looks up files, and report the throughput and the game thread latency. Usage: Git.Benchmark.StateCacheStress [Threads=8] [Files=20000] [Seconds=2]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StateCacheStress));
+
+/** Log the result of a check of the client of the locking API against the stub server */
+static bool CheckLfsLocks(const bool bInPassed, const TCHAR* InCheck)
+{
+	if(bInPassed)
+	{
+		UE_LOG(LogSourceControl, Display, TEXT("  passed: %s"), InCheck);
+	}
+	else
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("  FAILED: %s"), InCheck);
+	}
+	return bInPassed;
+}
+
+/**
+ * "Git.Benchmark.LfsLocks stub [Locks] [Iterations] [Port]"
+ *
+ * Check the client of the Git LFS locking API against a local stub server holding the given number of locks, half of them owned by another user,
+ * and measure the latency of listing them (without network and without Git LFS, so that it can run on any machine).
+ * The stub server is served by the game thread, so the client runs on a background thread and the results are logged when it completes.
+ */
+static void LfsLocksStub(const TArray<FString>& InArgs)
+{
+	const int32 NumLocks = FMath::Max((InArgs.Num() > 1) ? FCString::Atoi(*InArgs[1]) : 500, 2);
+	const int32 NumIterations = FMath::Max((InArgs.Num() > 2) ? FCString::Atoi(*InArgs[2]) : 5, 1);
+	const uint32 Port = (InArgs.Num() > 3) ? (uint32)FCString::Atoi(*InArgs[3]) : 18090;
+
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const FString PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
+	const FString UserName = GitSourceControl.AccessSettings().GetLfsUserName();
+	const FString OtherUserName = UserName + TEXT("-other");
+
+	TSharedRef<FGitLfsLocksStubServer, ESPMode::ThreadSafe> Server = MakeShared<FGitLfsLocksStubServer, ESPMode::ThreadSafe>(Port, UserName);
+	if(!Server->Start())
+	{
+		return;
+	}
+	TArray<FString> OurFiles;
+	TArray<FString> TheirFiles;
+	for(int32 Index = 0; Index < NumLocks; ++Index)
+	{
+		const FString File = FString::Printf(TEXT("Content/Stub/Asset_%05d.uasset"), Index);
+		if(Index % 2)
+		{
+			Server->AddLock(File, OtherUserName);
+			TheirFiles.Add(File);
+		}
+		else
+		{
+			OurFiles.Add(File);
+		}
+	}
+
+	// A repository of its own, that needs no Git LFS nor remote
+	const FString RepositoryRoot = FPaths::ProjectIntermediateDir() / TEXT("LfsLocksStub");
+	FGitLfsLocksClient& LocksClient = FGitLfsLocksClient::Get();
+	LocksClient.Reset();
+	LocksClient.SetEndpoint(RepositoryRoot, Server->GetUrl());
+	FGitLfsLocksClient::ResetCounters();
+	UE_LOG(LogSourceControl, Display, TEXT("Git LFS locking API stub on %s, %d locks:"), *Server->GetUrl(), NumLocks);
+
+	Async(EAsyncExecution::Thread, [Server, PathToGitBinary, RepositoryRoot, OurFiles, TheirFiles, NumLocks, NumIterations]()
+	{
+		FGitLfsLocksClient& LocksClient = FGitLfsLocksClient::Get();
+		bool bPassed = true;
+
+		TArray<FString> FailedFiles;
+		bPassed &= CheckLfsLocks(LocksClient.CreateLocks(PathToGitBinary, RepositoryRoot, OurFiles, FailedFiles) && FailedFiles.Num() == 0, TEXT("lock the files"));
+		FailedFiles.Reset();
+		bPassed &= CheckLfsLocks(!LocksClient.CreateLocks(PathToGitBinary, RepositoryRoot, { TheirFiles[0] }, FailedFiles) && FailedFiles.Num() == 1, TEXT("cannot lock a file locked by another user"));
+		FailedFiles.Reset();
+		bPassed &= CheckLfsLocks(LocksClient.CreateLocks(PathToGitBinary, RepositoryRoot, { OurFiles[0] }, FailedFiles) && FailedFiles.Num() == 0, TEXT("lock a file locked already"));
+
+		TArray<TArray<FGitLfsLock>> Locks;
+		const double StartTime = FPlatformTime::Seconds();
+		bool bListed = true;
+		for(int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			bListed &= LocksClient.ListLocks(PathToGitBinary, { RepositoryRoot }, Locks);
+		}
+		const double ListSeconds = (FPlatformTime::Seconds() - StartTime) / NumIterations;
+		bPassed &= CheckLfsLocks(bListed && Locks.Num() == 1 && Locks[0].Num() == NumLocks, TEXT("list all the locks, page by page"));
+
+		TArray<FGitLfsLock> Ours, Theirs;
+		bPassed &= CheckLfsLocks(LocksClient.VerifyLocks(PathToGitBinary, RepositoryRoot, Ours, Theirs) && Ours.Num() == OurFiles.Num() && Theirs.Num() == TheirFiles.Num(), TEXT("verify ours and theirs"));
+
+		// Without the identifiers of the locks, found again by path
+		LocksClient.Reset();
+		LocksClient.SetEndpoint(RepositoryRoot, Server->GetUrl());
+		FailedFiles.Reset();
+		bPassed &= CheckLfsLocks(LocksClient.DeleteLocks(PathToGitBinary, RepositoryRoot, OurFiles, FailedFiles) && FailedFiles.Num() == 0 && Server->GetNumLocks() == TheirFiles.Num(), TEXT("unlock the files"));
+
+		const int32 NumRequests = FGitLfsLocksClient::GetNumRequests();
+		AsyncTask(ENamedThreads::GameThread, [Server, bPassed, ListSeconds, NumRequests]()
+		{
+			Server->Stop();
+			FGitLfsLocksClient::Get().Reset();
+			UE_LOG(LogSourceControl, Display, TEXT("  locking API: %.3lfs per list, %d requests in total (%d served)"), ListSeconds, NumRequests, Server->GetNumRequests());
+			if(bPassed)
+			{
+				UE_LOG(LogSourceControl, Display, TEXT("Git LFS locking API stub: all checks passed"));
+			}
+			else
+			{
+				UE_LOG(LogSourceControl, Error, TEXT("Git LFS locking API stub: some checks failed"));
+			}
+		});
+	});
+}
+
+/**
+ * "Git.Benchmark.LfsLocks [Iterations]"
+ *
+ * Compare the latency of listing the locks of the repository and its submodules,
+ * with one "git lfs locks" command per repository, and with the client of the Git LFS locking API (cold, then warm).
+ */
+static void LfsLocks(const TArray<FString>& InArgs)
+{
+	if(InArgs.Num() > 0 && InArgs[0] == TEXT("stub"))
+	{
+		LfsLocksStub(InArgs);
+		return;
+	}
+
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	if(!GitSourceControl.GetProvider().IsAvailable() || !GitSourceControl.GetProvider().UsesCheckout())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git.Benchmark.LfsLocks: the Git source control provider is not connected with Git LFS locking"));
+		return;
+	}
+
+	const int32 NumIterations = FMath::Max((InArgs.Num() > 0) ? FCString::Atoi(*InArgs[0]) : 5, 1);
+	const FString PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
+
+	TArray<FString> RepositoryRoots;
+	GitSourceControlUtils::GetSubModulesRoots(RepositoryRoots);
+	RepositoryRoots.Add(TEXT(""));
+	for(FString& RepositoryRoot : RepositoryRoots)
+	{
+		RepositoryRoot = FPaths::ProjectDir() + RepositoryRoot;
+	}
+
+	// Git LFS commands, one after the other like before
+	int32 NumCliLocks = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for(int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		NumCliLocks = 0;
+		for(const FString& RepositoryRoot : RepositoryRoots)
+		{
+			FGitOutputReader Reader;
+			TArray<FString> ErrorMessages;
+			GitSourceControlUtils::RunCommandStreamed(TEXT("lfs locks"), PathToGitBinary, RepositoryRoot, TArray<FString>(), TArray<FString>(), Reader, ErrorMessages);
+			NumCliLocks += Reader.GetRecords().Num();
+		}
+	}
+	const double CliSeconds = (FPlatformTime::Seconds() - StartTime) / NumIterations;
+
+	// Locking API: the first time finds the endpoints and asks for the credentials
+	FGitLfsLocksClient& LocksClient = FGitLfsLocksClient::Get();
+	LocksClient.Reset();
+	FGitLfsLocksClient::ResetCounters();
+	TArray<TArray<FGitLfsLock>> Locks;
+	StartTime = FPlatformTime::Seconds();
+	bool bAvailable = true;
+	for(const FString& RepositoryRoot : RepositoryRoots)
+	{
+		bAvailable &= LocksClient.IsAvailable(PathToGitBinary, RepositoryRoot);
+	}
+	const bool bColdListed = bAvailable && LocksClient.ListLocks(PathToGitBinary, RepositoryRoots, Locks);
+	const double ColdSeconds = FPlatformTime::Seconds() - StartTime;
+	if(!bColdListed)
+	{
+		UE_LOG(LogSourceControl, Display, TEXT("Git LFS locks of %d repositories: %.3lfs per list with git lfs locks; the locking API is not available"), RepositoryRoots.Num(), CliSeconds);
+		return;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	for(int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		LocksClient.ListLocks(PathToGitBinary, RepositoryRoots, Locks);
+	}
+	const double WarmSeconds = (FPlatformTime::Seconds() - StartTime) / NumIterations;
+	int32 NumApiLocks = 0;
+	for(const TArray<FGitLfsLock>& RepositoryLocks : Locks)
+	{
+		NumApiLocks += RepositoryLocks.Num();
+	}
+
+	UE_LOG(LogSourceControl, Display, TEXT("Git LFS locks of %d repositories:"), RepositoryRoots.Num());
+	UE_LOG(LogSourceControl, Display, TEXT("  git lfs locks:     %.3lfs per list (%d locks)"), CliSeconds, NumCliLocks);
+	UE_LOG(LogSourceControl, Display, TEXT("  locking API, cold: %.3lfs (%d credentials looked up)"), ColdSeconds, FGitLfsLocksClient::GetNumCredentialFills());
+	UE_LOG(LogSourceControl, Display, TEXT("  locking API, warm: %.3lfs per list (%d locks, %d requests in total)"), WarmSeconds, NumApiLocks, FGitLfsLocksClient::GetNumRequests());
+}
+
+static FAutoConsoleCommand LfsLocksCommand(
+	TEXT("Git.Benchmark.LfsLocks"),
+	TEXT("Compare the latency of listing the Git LFS locks with git lfs locks and with the locking API, or check the locking API against a local stub server. Usage: Git.Benchmark.LfsLocks [Iterations=5] | Git.Benchmark.LfsLocks stub [Locks=500] [Iterations=5] [Port=18090]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&LfsLocks));
+
+/** Time a "status" of the whole repository, like the one of the Connect operation, with the given command (to override some config values) */
+static double MeasureStatusLatency(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InCommand)
+{
+	TArray<FString> InfoMessages;
+	TArray<FString> ErrorMessages;
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("--porcelain"));
+	Parameters.Add(TEXT("--ignored"));
+	const double StartTime = FPlatformTime::Seconds();
+	GitSourceControlUtils::RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+/**
+ * "Git.Benchmark.StatusAcceleration"
+ *
+ * Measure the latency of "git status" in the repository and each submodule, without the file system monitor and the untracked cache, then with them
+ * (as configured by ConfigureStatusAcceleration() when connecting, which does not measure anything so as not to delay the connection).
+ */
+static void StatusAcceleration(const TArray<FString>& InArgs)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	if(!GitSourceControl.GetProvider().IsAvailable())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git.Benchmark.StatusAcceleration: the Git source control provider is not connected"));
+		return;
+	}
+	const FString PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
+	const FString PathToRepositoryRoot = GitSourceControl.GetProvider().GetPathToRepositoryRoot();
+
+	TArray<FString> RepositoryRoots;
+	RepositoryRoots.Add(PathToRepositoryRoot);
+	TArray<FString> SubModules;
+	GitSourceControlUtils::GetSubModulesRoots(SubModules);
+	for(const FString& SubModule : SubModules)
+	{
+		RepositoryRoots.Add(PathToRepositoryRoot / SubModule);
+	}
+
+	UE_LOG(LogSourceControl, Display, TEXT("Latency of git status:"));
+	for(const FString& RepositoryRoot : RepositoryRoots)
+	{
+		const double LatencyWithout = MeasureStatusLatency(PathToGitBinary, RepositoryRoot, TEXT("-c core.fsmonitor=false -c core.untrackedCache=false status"));
+		// The first status populates the untracked cache and starts the file system monitor daemon: only measure the next one
+		MeasureStatusLatency(PathToGitBinary, RepositoryRoot, TEXT("status"));
+		const double LatencyWith = MeasureStatusLatency(PathToGitBinary, RepositoryRoot, TEXT("status"));
+		UE_LOG(LogSourceControl, Display, TEXT("  '%s': %.3lfs without the acceleration, %.3lfs with it (%.1fx faster)"),
+			*RepositoryRoot, LatencyWithout, LatencyWith, (LatencyWith > 0.0) ? LatencyWithout / LatencyWith : 0.0);
+	}
+}
+
+static FAutoConsoleCommand StatusAccelerationCommand(
+	TEXT("Git.Benchmark.StatusAcceleration"),
+	TEXT("Measure the latency of git status in the repository and its submodules, without and with the file system monitor and the untracked cache."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StatusAcceleration));
+
+/** Layout of FGitSourceControlState before it was made compact, only to compare the memory used per file (never instantiated) */
+struct FGitSourceControlStateLegacyLayout : public ISourceControlState, public TSharedFromThis<FGitSourceControlState, ESPMode::ThreadSafe>
+{
+	TGitSourceControlHistory History;
+	FString LocalFilename;
+	FString PendingMergeBaseFileHash;
+	int32 WorkingCopyState;
+	int32 LockState;
+	FString LockUser;
+	bool bUsingGitLfsLocking;
+	bool bNewerVersionOnServer;
+	FDateTime TimeStamp;
+};
+
+/** Heap memory of an FString holding a string of the given length */
+static SIZE_T GetStringSize(const int32 InLen)
+{
+	return (InLen > 0) ? (InLen + 1) * sizeof(TCHAR) : 0;
+}
+
+/**
+ * "Git.Benchmark.StateCacheMemory"
+ *
+ * Report the memory used per file by the state cache of the provider, with the current compact layout,
+ * and as estimated for the previous layout (a map keyed by a copy of the path, full strings for the lock user and the merge base, and an inline history array).
+ */
+static void StateCacheMemory(const TArray<FString>& InArgs)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const FGitSourceControlStateCache& StateCache = GitSourceControl.GetProvider().GetStateCache();
+
+	TArray<FGitSourceControlStateRef> States;
+	StateCache.GetStates(States);
+
+	// Both layouts allocate each state along with its reference controller (MakeShareable)
+	const SIZE_T ReferenceControllerSize = sizeof(SharedPointerInternals::FReferenceControllerBase);
+	SIZE_T LegacyFixedSize = States.Num() * (sizeof(FGitSourceControlStateLegacyLayout) + ReferenceControllerSize + sizeof(TSetElement<TPair<FString, FGitSourceControlStateRef>>));
+	SIZE_T CompactFixedSize = States.Num() * (sizeof(FGitSourceControlState) + ReferenceControllerSize + sizeof(TSetElement<FGitSourceControlStateRef>));
+	SIZE_T LegacyHeapSize = 0;
+	SIZE_T CompactHeapSize = 0;
+	for(const FGitSourceControlStateRef& State : States)
+	{
+		// The path was stored twice: as the key of the map, and in the state
+		LegacyHeapSize += 2 * GetStringSize(State->LocalFilename.Len()) + State->History.GetAllocatedSize() - (State->History.Num() > 0 ? sizeof(TGitSourceControlHistory) : 0);
+		if(!State->LockUser.IsNone())
+		{
+			LegacyHeapSize += GetStringSize(State->LockUser.ToString().Len());
+		}
+		if(State->PendingMergeBaseFileHash != FSHAHash())
+		{
+			LegacyHeapSize += GetStringSize(2 * sizeof(State->PendingMergeBaseFileHash.Hash));
+		}
+		CompactHeapSize += State->GetAllocatedSize();
+	}
+	const SIZE_T LegacyTotalSize = LegacyFixedSize + LegacyHeapSize;
+	const SIZE_T CompactTotalSize = CompactFixedSize + CompactHeapSize;
+	const int32 NumStates = FMath::Max(States.Num(), 1);
+
+	UE_LOG(LogSourceControl, Display, TEXT("State cache of %d files (%llu bytes allocated by the cache, including its indexes):"), States.Num(), (uint64)StateCache.GetAllocatedSize());
+	UE_LOG(LogSourceControl, Display, TEXT("  sizeof(state): %4llu bytes before, %4llu bytes now"), (uint64)sizeof(FGitSourceControlStateLegacyLayout), (uint64)sizeof(FGitSourceControlState));
+	UE_LOG(LogSourceControl, Display, TEXT("  per file:      %4llu bytes before (%llu fixed + %llu strings), %4llu bytes now (%llu fixed + %llu strings)"),
+		(uint64)(LegacyTotalSize / NumStates), (uint64)(LegacyFixedSize / NumStates), (uint64)(LegacyHeapSize / NumStates),
+		(uint64)(CompactTotalSize / NumStates), (uint64)(CompactFixedSize / NumStates), (uint64)(CompactHeapSize / NumStates));
+	UE_LOG(LogSourceControl, Display, TEXT("  total:         %.2lf MiB before, %.2lf MiB now"), LegacyTotalSize / (1024.0 * 1024.0), CompactTotalSize / (1024.0 * 1024.0));
+}
+
+static FAutoConsoleCommand StateCacheMemoryCommand(
+	TEXT("Git.Benchmark.StateCacheMemory"),
+	TEXT("Report the memory used per file by the state cache, with the compact layout and with the previous one."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StateCacheMemory));
+
+}
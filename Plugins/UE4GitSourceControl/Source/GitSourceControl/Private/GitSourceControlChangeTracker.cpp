@@ -0,0 +1,284 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlChangeTracker.h"
+
+#include "DirectoryWatcherModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Modules/ModuleManager.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlUtils.h"
+#include "GitSourceControlIndex.h"
+
+/** A file modified less than this long ago can still have a watcher event on its way: it is not marked clean */
+static const FTimespan RacyCleanTimespan = FTimespan::FromSeconds(2.0);
+
+FGitSourceControlChangeTracker::~FGitSourceControlChangeTracker()
+{
+	Stop();
+}
+
+void FGitSourceControlChangeTracker::Start(const FString& InRepositoryRoot)
+{
+	Stop();
+
+	FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+	if(DirectoryWatcher == nullptr)
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("No directory watcher available: the status of all files will be queried on each update"));
+		return;
+	}
+
+	TArray<FString> Directories;
+	Directories.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()));
+	Directories.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectConfigDir()));
+	TArray<FString> RepositoryRoots;
+	RepositoryRoots.Add(InRepositoryRoot);
+	TArray<FString> SubModules;
+	GitSourceControlUtils::GetSubModulesRoots(SubModules);
+	for(const FString& SubModule : SubModules)
+	{
+		const FString SubModuleRoot = InRepositoryRoot / SubModule;
+		Directories.Add(SubModuleRoot);
+		RepositoryRoots.Add(SubModuleRoot);
+	}
+
+	TMap<FString, FDelegateHandle> NewWatchedDirectories;
+	for(const FString& Directory : Directories)
+	{
+		FDelegateHandle Handle;
+		if(FPaths::DirectoryExists(Directory) && !NewWatchedDirectories.Contains(Directory)
+		   && DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(Directory, IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FGitSourceControlChangeTracker::OnDirectoryChanged), Handle, IDirectoryWatcher::WatchOptions::IncludeDirectoryChanges))
+		{
+			NewWatchedDirectories.Add(Directory, Handle);
+		}
+	}
+
+	FScopeLock ScopeLock(&CriticalSection);
+	WatchedDirectories = MoveTemp(NewWatchedDirectories);
+	for(const FString& RepositoryRoot : RepositoryRoots)
+	{
+		const FString IndexFile = FGitIndex::FindIndexFile(RepositoryRoot);
+		if(!IndexFile.IsEmpty())
+		{
+			IndexTimestamps.Add(IndexFile, IFileManager::Get().GetTimeStamp(*IndexFile));
+		}
+	}
+
+	UE_LOG(LogSourceControl, Log, TEXT("Watching %d directories and %d repository indexes for changes"), WatchedDirectories.Num(), IndexTimestamps.Num());
+}
+
+void FGitSourceControlChangeTracker::Stop()
+{
+	TMap<FString, FDelegateHandle> OldWatchedDirectories;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		OldWatchedDirectories = MoveTemp(WatchedDirectories);
+		WatchedDirectories.Reset();
+		IndexTimestamps.Reset();
+		CleanFiles.Reset();
+		ModifiedFiles.Reset();
+		LastChanges.Reset();
+	}
+
+	// The DirectoryWatcher module can already be unloaded when the Editor shuts down
+	FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = (DirectoryWatcherModule != nullptr) ? DirectoryWatcherModule->Get() : nullptr;
+	if(DirectoryWatcher != nullptr)
+	{
+		for(const TPair<FString, FDelegateHandle>& WatchedDirectory : OldWatchedDirectories)
+		{
+			DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(WatchedDirectory.Key, WatchedDirectory.Value);
+		}
+	}
+}
+
+bool FGitSourceControlChangeTracker::IsActive() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return WatchedDirectories.Num() > 0;
+}
+
+uint32 FGitSourceControlChangeTracker::GetSequence() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return Sequence;
+}
+
+void FGitSourceControlChangeTracker::SplitDirtyFiles(const TArray<FString>& InFiles, TArray<FString>& OutDirtyFiles, TArray<FString>& OutCleanFiles)
+{
+	TArray<TPair<FString, FCleanFileStat>> CleanCandidates;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		CheckIndexTimestamps();
+
+		for(const FString& File : InFiles)
+		{
+			if(const FCleanFileStat* CleanStat = CleanFiles.Find(File))
+			{
+				CleanCandidates.Emplace(File, *CleanStat);
+			}
+			else
+			{
+				OutDirtyFiles.Add(File);
+			}
+		}
+	}
+
+	// Modified without the watcher telling it yet: stat the files outside of the lock, which is also taken by the watcher events
+	for(const TPair<FString, FCleanFileStat>& Candidate : CleanCandidates)
+	{
+		const FFileStatData StatData = IFileManager::Get().GetStatData(*Candidate.Key);
+		if(StatData.bIsValid && StatData.FileSize == Candidate.Value.Size && StatData.ModificationTime == Candidate.Value.ModificationTime)
+		{
+			OutCleanFiles.Add(Candidate.Key);
+		}
+		else
+		{
+			OutDirtyFiles.Add(Candidate.Key);
+		}
+	}
+}
+
+void FGitSourceControlChangeTracker::GetModifiedFiles(const int32 InMaxFiles, TArray<FString>& OutFiles)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	CheckIndexTimestamps();
+
+	for(const FString& File : ModifiedFiles)
+	{
+		if(OutFiles.Num() >= InMaxFiles)
+		{
+			break;
+		}
+		OutFiles.Add(File);
+	}
+}
+
+void FGitSourceControlChangeTracker::MarkClean(const TArray<FString>& InFiles, const uint32 InSequence)
+{
+	// Stat the files outside of the lock; the ones modified too recently stay dirty, their watcher event can still be on its way
+	TArray<TPair<FString, FCleanFileStat>> CleanCandidates;
+	const FDateTime RacyCleanTime = FDateTime::UtcNow() - RacyCleanTimespan;
+	for(const FString& File : InFiles)
+	{
+		// Relative paths and directories are never reported as such by the watcher
+		if(FPaths::IsRelative(File) || File.EndsWith(TEXT("/")))
+		{
+			continue;
+		}
+		const FFileStatData StatData = IFileManager::Get().GetStatData(*File);
+		if(StatData.bIsValid && !StatData.bIsDirectory && StatData.ModificationTime < RacyCleanTime)
+		{
+			CleanCandidates.Emplace(File, FCleanFileStat{ StatData.FileSize, StatData.ModificationTime });
+		}
+	}
+
+	FScopeLock ScopeLock(&CriticalSection);
+	if(WatchedDirectories.Num() == 0 || LastAllDirty > InSequence)
+	{
+		return;
+	}
+
+	for(TPair<FString, FCleanFileStat>& Candidate : CleanCandidates)
+	{
+		// The changes of the files outside of the watched directories are not reported
+		if(!IsInWatchedDirectory(Candidate.Key))
+		{
+			continue;
+		}
+		const uint32* LastChange = LastChanges.Find(Candidate.Key);
+		if(LastChange == nullptr || *LastChange <= InSequence)
+		{
+			ModifiedFiles.Remove(Candidate.Key);
+			LastChanges.Remove(Candidate.Key);
+			CleanFiles.Add(MoveTemp(Candidate.Key), Candidate.Value);
+		}
+	}
+}
+
+bool FGitSourceControlChangeTracker::IsInWatchedDirectory(const FString& InFile) const
+{
+	for(const TPair<FString, FDelegateHandle>& WatchedDirectory : WatchedDirectories)
+	{
+		const FString& Directory = WatchedDirectory.Key;
+		if(InFile.StartsWith(Directory) && (Directory.EndsWith(TEXT("/")) || (InFile.Len() > Directory.Len() && InFile[Directory.Len()] == TEXT('/'))))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FGitSourceControlChangeTracker::MarkAllDirty()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	MarkAllDirtyInternal();
+}
+
+void FGitSourceControlChangeTracker::MarkAllDirtyInternal()
+{
+	// Forget clean files instead of moving them to the modified ones: the next UpdateStatus will query the files still of interest
+	LastAllDirty = ++Sequence;
+	CleanFiles.Reset();
+	ModifiedFiles.Reset();
+	LastChanges.Reset();
+}
+
+void FGitSourceControlChangeTracker::OnDirectoryChanged(const TArray<FFileChangeData>& InFileChanges)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	++Sequence;
+
+	for(const FFileChangeData& FileChange : InFileChanges)
+	{
+		FString Filename = FPaths::ConvertRelativePathToFull(FileChange.Filename);
+		FPaths::NormalizeFilename(Filename);
+
+		LastChanges.Add(Filename, Sequence);
+		if(CleanFiles.Remove(Filename) > 0)
+		{
+			ModifiedFiles.Add(Filename);
+		}
+
+		if(FPaths::GetExtension(Filename).IsEmpty())
+		{
+			// Most likely a directory renamed, moved or deleted: all the files it contained are dirty
+			const FString DirectoryPrefix = Filename + TEXT("/");
+			for(auto It = CleanFiles.CreateIterator(); It; ++It)
+			{
+				if(It->Key.StartsWith(DirectoryPrefix))
+				{
+					ModifiedFiles.Add(It->Key);
+					LastChanges.Add(It->Key, Sequence);
+					It.RemoveCurrent();
+				}
+			}
+		}
+	}
+}
+
+void FGitSourceControlChangeTracker::CheckIndexTimestamps()
+{
+	bool bIndexChanged = false;
+	for(TPair<FString, FDateTime>& IndexTimestamp : IndexTimestamps)
+	{
+		const FDateTime Timestamp = IFileManager::Get().GetTimeStamp(*IndexTimestamp.Key);
+		if(Timestamp != IndexTimestamp.Value)
+		{
+			IndexTimestamp.Value = Timestamp;
+			bIndexChanged = true;
+		}
+	}
+
+	if(bIndexChanged)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Git index changed: the status of all files will be queried again"));
+		MarkAllDirtyInternal();
+	}
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IDirectoryWatcher.h"
+
+/**
+ * Track the files modified on disk since their status was last queried, to avoid running "git status" on unchanged files.
+ *
+ * The Content/ and Config/ directories of the project, and the root of each submodule, are watched with the DirectoryWatcher module.
+ * A file is "clean" once its status has been queried, and becomes "dirty" again as soon as it is modified on disk;
+ * files never queried are always dirty. Any change of the index of a repository (commit, checkout, pull...) makes all files dirty.
+ * As the events of the watcher can arrive late, the size and the modification time of a clean file are also checked before serving it from the cache,
+ * and a file modified in the last seconds is not marked clean at all (like the "racily clean" entries of the Git index).
+ *
+ * Thread-safe: events are received on the game thread, while queries come from the worker threads.
+ */
+class FGitSourceControlChangeTracker
+{
+public:
+	~FGitSourceControlChangeTracker();
+
+	/** Start watching the project directories and the submodules of the repository (on the game thread) */
+	void Start(const FString& InRepositoryRoot);
+
+	/** Stop watching and forget all clean files */
+	void Stop();
+
+	/** Is the tracker watching the directories? If not, all files are dirty */
+	bool IsActive() const;
+
+	/** Get the current change sequence number, to be given to MarkClean() once the status query started now is complete */
+	uint32 GetSequence() const;
+
+	/**
+	 * Split files between those that need a new status query and those whose cached status is still valid
+	 *
+	 * @param	InFiles			Absolute paths of the files
+	 * @param	OutDirtyFiles	Files modified (or never queried) since their last status query
+	 * @param	OutCleanFiles	Files unchanged since their last status query
+	 */
+	void SplitDirtyFiles(const TArray<FString>& InFiles, TArray<FString>& OutDirtyFiles, TArray<FString>& OutCleanFiles);
+
+	/** Get the files that had their status queried, but have been modified since (at most InMaxFiles) */
+	void GetModifiedFiles(const int32 InMaxFiles, TArray<FString>& OutFiles);
+
+	/**
+	 * Mark files as clean after a status query, except the ones outside of the watched directories whose changes would go unnoticed
+	 *
+	 * @param	InFiles			Absolute paths of the files that had their status queried
+	 * @param	InSequence		The sequence number obtained before running the query: files modified after it stay dirty
+	 */
+	void MarkClean(const TArray<FString>& InFiles, const uint32 InSequence);
+
+	/** Make all files dirty */
+	void MarkAllDirty();
+
+private:
+	/** DirectoryWatcher callback */
+	void OnDirectoryChanged(const TArray<struct FFileChangeData>& InFileChanges);
+
+	/** Make all files dirty if the index of one of the repositories has changed (caller holds the critical section) */
+	void CheckIndexTimestamps();
+
+	/** Make all files dirty (caller holds the critical section) */
+	void MarkAllDirtyInternal();
+
+	/** Tell if a file is under one of the watched directories, the only ones whose changes are reported (caller holds the critical section) */
+	bool IsInWatchedDirectory(const FString& InFile) const;
+
+	/** Guards all the members below */
+	mutable FCriticalSection CriticalSection;
+
+	/** Watched directories and their DirectoryWatcher handles */
+	TMap<FString, FDelegateHandle> WatchedDirectories;
+
+	/** Index file of each repository, and its timestamp when last checked */
+	TMap<FString, FDateTime> IndexTimestamps;
+
+	/** Size and modification time of a file when it was marked clean */
+	struct FCleanFileStat
+	{
+		int64 Size;
+		FDateTime ModificationTime;
+	};
+
+	/** Files whose status was queried and is still up to date, with their stat data at that time */
+	TMap<FString, FCleanFileStat> CleanFiles;
+
+	/** Files whose status was queried and that have been modified since */
+	TSet<FString> ModifiedFiles;
+
+	/** Sequence number of the last change of each modified file, to not mark clean a file modified during a status query */
+	TMap<FString, uint32> LastChanges;
+
+	/** Sequence number of the last change making all files dirty */
+	uint32 LastAllDirty = 0;
+
+	/** Incremented on each change */
+	uint32 Sequence = 0;
+};
@@ -5,6 +5,7 @@
 
 #include "GitSourceControlCommand.h"
 
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
 #include "GitSourceControlModule.h"
 
@@ -12,6 +13,7 @@ FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourc
 	: Operation(InOperation)
 	, Worker(InWorker)
 	, OperationCompleteDelegate(InOperationCompleteDelegate)
+	, bExecuteStarted(0)
 	, bExecuteProcessed(0)
 	, bCommandSuccessful(false)
 	, bConnectionDropped(false)
@@ -29,6 +31,10 @@ FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourc
 
 bool FGitSourceControlCommand::DoWork()
 {
+	{
+		FScopeLock ScopeLock(&FilesCriticalSection);
+		FPlatformAtomics::InterlockedExchange(&bExecuteStarted, 1);
+	}
 	bCommandSuccessful = Worker->Execute(*this);
 	FPlatformAtomics::InterlockedExchange(&bExecuteProcessed, 1);
 
@@ -62,5 +68,73 @@ ECommandResult::Type FGitSourceControlCommand::ReturnResults()
 	ECommandResult::Type Result = bCommandSuccessful ? ECommandResult::Succeeded : ECommandResult::Failed;
 	OperationCompleteDelegate.ExecuteIfBound(Operation, Result);
 
+	// and the ones of the operations merged into this command
+	for(const auto& CoalescedOperation : CoalescedOperations)
+	{
+		for(const FString& String : InfoMessages)
+		{
+			CoalescedOperation.Key->AddInfoMessge(FText::FromString(String));
+		}
+		for(const FString& String : ErrorMessages)
+		{
+			CoalescedOperation.Key->AddErrorMessge(FText::FromString(String));
+		}
+		CoalescedOperation.Value.ExecuteIfBound(CoalescedOperation.Key, Result);
+	}
+
 	return Result;
 }
+
+bool FGitSourceControlCommand::CoversFiles(const TArray<FString>& InFiles)
+{
+	check(IsInGameThread());
+
+	if(Files.Num() == 0 || InFiles.Num() == 0)
+	{
+		// The status of the whole repository only lists modified files: it does not give a state to each requested file
+		return (Files.Num() == 0) && (InFiles.Num() == 0);
+	}
+	if(FileSet.Num() == 0)
+	{
+		FileSet.Append(Files);
+	}
+	for(const FString& File : InFiles)
+	{
+		if(!FileSet.Contains(File))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FGitSourceControlCommand::TryAddFiles(const TArray<FString>& InFiles)
+{
+	check(IsInGameThread());
+
+	FScopeLock ScopeLock(&FilesCriticalSection);
+	if(bExecuteStarted || Files.Num() == 0 || InFiles.Num() == 0)
+	{
+		return false;
+	}
+	if(FileSet.Num() == 0)
+	{
+		FileSet.Append(Files);
+	}
+	for(const FString& File : InFiles)
+	{
+		bool bIsAlreadyInSet = false;
+		FileSet.Add(File, &bIsAlreadyInSet);
+		if(!bIsAlreadyInSet)
+		{
+			Files.Add(File);
+		}
+	}
+	return true;
+}
+
+void FGitSourceControlCommand::AddCoalescedOperation(const TSharedRef<class ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const FSourceControlOperationComplete& InOperationCompleteDelegate)
+{
+	check(IsInGameThread());
+	CoalescedOperations.Emplace(InOperation, InOperationCompleteDelegate);
+}
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
 #include "ISourceControlProvider.h"
 #include "Misc/IQueuedWork.h"
 
@@ -41,6 +42,15 @@ public:
 	/** Save any results and call any registered callbacks. */
 	ECommandResult::Type ReturnResults();
 
+	/** Tell if this command queries the status of all the given files (or of the whole repository, like the request) */
+	bool CoversFiles(const TArray<FString>& InFiles);
+
+	/** Add files to query to this command, only if its worker did not start yet (game thread) */
+	bool TryAddFiles(const TArray<FString>& InFiles);
+
+	/** Share the results of this command with another operation, merged into it by the provider (game thread) */
+	void AddCoalescedOperation(const TSharedRef<class ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const FSourceControlOperationComplete& InOperationCompleteDelegate);
+
 public:
 	/** Path to the Git binary */
 	FString PathToGitBinary;
@@ -60,6 +70,9 @@ public:
 	/** Delegate to notify when this operation completes */
 	FSourceControlOperationComplete OperationCompleteDelegate;
 
+	/**If true, the worker of this command started, so its files cannot change anymore*/
+	volatile int32 bExecuteStarted;
+
 	/**If true, this command has been processed by the source control thread*/
 	volatile int32 bExecuteProcessed;
 
@@ -89,4 +102,14 @@ public:
 
 	/**Potential error message storage*/
 	TArray<FString> ErrorMessages;
+
+private:
+	/** Guards Files against the start of the worker, while the provider merges files into this command */
+	FCriticalSection FilesCriticalSection;
+
+	/** Set of the Files, built on first use to check which requests this command covers (game thread) */
+	TSet<FString> FileSet;
+
+	/** Operations merged into this one, completed along with it */
+	TArray<TPair<TSharedRef<class ISourceControlOperation, ESPMode::ThreadSafe>, FSourceControlOperationComplete>> CoalescedOperations;
 };
@@ -0,0 +1,42 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlFileExistenceCache.h"
+
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+
+bool FGitFileExistenceCache::FileExists(const FString& InFilename)
+{
+	const FString Filename = FPaths::ConvertRelativePathToFull(InFilename);
+	const FString DirectoryPath = FPaths::GetPath(Filename);
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FDirectory* Directory = Directories.Find(DirectoryPath);
+	if(Directory == nullptr)
+	{
+		// First file of the directory: a single stat is cheaper than a listing
+		Directories.Add(DirectoryPath);
+		++NumStats;
+		return PlatformFile.FileExists(*Filename);
+	}
+
+	if(!Directory->bListed)
+	{
+		// Second file of the directory: list it once for all the others (a missing directory lists no file)
+		PlatformFile.IterateDirectoryStat(*DirectoryPath, [Directory](const TCHAR* InFilenameOrDirectory, const FFileStatData& InStatData)
+		{
+			if(!InStatData.bIsDirectory)
+			{
+				Directory->Filenames.Add(FPaths::GetCleanFilename(InFilenameOrDirectory));
+			}
+			return true;
+		});
+		Directory->bListed = true;
+		++NumListings;
+	}
+
+	return Directory->Filenames.Contains(FPaths::GetCleanFilename(Filename));
+}
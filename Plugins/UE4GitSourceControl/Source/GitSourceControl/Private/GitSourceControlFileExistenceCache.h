@@ -0,0 +1,43 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Existence of files, answered by listing each directory once instead of one stat per file.
+ *
+ * Meant to live for the duration of one operation, on one thread: files created or deleted meanwhile are not seen.
+ * The first file queried in a directory is a single stat, so that looking up one file never lists a big directory;
+ * the directory is listed (IPlatformFile::IterateDirectoryStat) from its second file on.
+ * The number of system calls thus scales with the number of directories, not with the number of files times the number of repositories.
+ */
+class FGitFileExistenceCache
+{
+public:
+	/** Tell if a file exists (relative to the current directory, or absolute) */
+	bool FileExists(const FString& InFilename);
+
+	/** Number of system calls made: stats of single files plus listings of directories */
+	int32 GetNumSystemCalls() const
+	{
+		return NumStats + NumListings;
+	}
+
+private:
+	/** Files of a directory, once listed */
+	struct FDirectory
+	{
+		bool bListed = false;
+		TSet<FString> Filenames;
+	};
+
+	/** Known directories, by full path */
+	TMap<FString, FDirectory> Directories;
+
+	int32 NumStats = 0;
+	int32 NumListings = 0;
+};
@@ -0,0 +1,401 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlIndex.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/UniquePtr.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlUtils.h"
+
+namespace GitIndexConstants
+{
+
+/** Size of a SHA-1 object name */
+static const int32 HashSize = 20;
+
+/** Size of the fixed part of an entry, up to and including its 16 bits of flags */
+static const int32 EntryHeaderSize = 62;
+
+/** Flags of an entry */
+static const uint16 FlagExtended = 0x4000;
+static const uint16 FlagStageMask = 0x3000;
+static const int32 FlagStageShift = 12;
+static const uint16 ExtendedFlagSkipWorktree = 0x4000;
+static const uint16 ExtendedFlagIntentToAdd = 0x2000;
+
+/** Object type of the mode of an entry */
+static const uint32 ModeTypeMask = 0170000;
+static const uint32 ModeRegularFile = 0100000;
+
+}
+
+/** Read big-endian (network byte order) integers */
+static uint32 ReadUInt32(const uint8* InData)
+{
+	return (uint32(InData[0]) << 24) | (uint32(InData[1]) << 16) | (uint32(InData[2]) << 8) | uint32(InData[3]);
+}
+
+static uint16 ReadUInt16(const uint8* InData)
+{
+	return uint16((InData[0] << 8) | InData[1]);
+}
+
+/** Read the variable length integer encoding the path prefix compression of version 4 */
+static bool ReadVarInt(const uint8*& InOutData, const uint8* InEnd, uint64& OutValue)
+{
+	if(InOutData >= InEnd)
+	{
+		return false;
+	}
+	uint8 Byte = *InOutData++;
+	OutValue = Byte & 0x7F;
+	while(Byte & 0x80)
+	{
+		if(InOutData >= InEnd)
+		{
+			return false;
+		}
+		Byte = *InOutData++;
+		OutValue = ((OutValue + 1) << 7) | (Byte & 0x7F);
+	}
+	return true;
+}
+
+/** Compare paths like Git sorts the index: byte by byte, then the shortest first */
+static int32 ComparePaths(const ANSICHAR* InA, const int32 InLenA, const ANSICHAR* InB, const int32 InLenB)
+{
+	const int32 Result = FMemory::Memcmp(InA, InB, FMath::Min(InLenA, InLenB));
+	return (Result != 0) ? Result : (InLenA - InLenB);
+}
+
+FString FGitIndex::FindIndexFile(const FString& InRepositoryRoot)
+{
+	const FString GitDirectory = GitSourceControlUtils::GetGitDirectory(InRepositoryRoot);
+	return GitDirectory.IsEmpty() ? FString() : GitDirectory / TEXT("index");
+}
+
+bool FGitIndex::Load(const FString& InIndexFile)
+{
+	Timestamp = IFileManager::Get().GetTimeStamp(*InIndexFile);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*InIndexFile));
+	if(MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+		if(MappedRegion.IsValid())
+		{
+			return Parse(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+		}
+	}
+
+	// Platforms without memory-mapped files
+	TArray<uint8> Content;
+	if(!FFileHelper::LoadFileToArray(Content, *InIndexFile, FILEREAD_Silent))
+	{
+		return false;
+	}
+	return Parse(Content.GetData(), Content.Num());
+}
+
+bool FGitIndex::Parse(const uint8* InData, const int64 InSize)
+{
+	using namespace GitIndexConstants;
+
+	// Header: "DIRC" signature, version and number of entries, and the whole file is followed by its SHA-1
+	if(InSize < 12 + HashSize || FMemory::Memcmp(InData, "DIRC", 4) != 0)
+	{
+		return false;
+	}
+	Version = ReadUInt32(InData + 4);
+	if(Version < 2 || Version > 4)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Git index version %u not supported"), Version);
+		return false;
+	}
+	const uint32 NumEntries = ReadUInt32(InData + 8);
+	Checksum = BytesToHex(InData + InSize - HashSize, HashSize).ToLower();
+
+	const uint8* Data = InData + 12;
+	const uint8* End = InData + InSize - HashSize;
+	Entries.Reset(NumEntries);
+	Paths.Reset(NumEntries * 64);
+	MergeBaseFileHashes.Reset();
+
+	for(uint32 Index = 0; Index < NumEntries; ++Index)
+	{
+		const uint8* EntryStart = Data;
+		if(Data + EntryHeaderSize > End)
+		{
+			return false;
+		}
+
+		// ctime (8 bytes), mtime (8), dev, ino, mode, uid, gid, size (4 each), SHA-1 (20) and flags (2)
+		FGitIndexEntry Entry;
+		Entry.MTimeSeconds = ReadUInt32(Data + 8);
+		Entry.MTimeNanoSeconds = ReadUInt32(Data + 12);
+		Entry.Mode = ReadUInt32(Data + 24);
+		Entry.FileSize = ReadUInt32(Data + 36);
+		const uint16 Flags = ReadUInt16(Data + 60);
+		Entry.Stage = uint8((Flags & FlagStageMask) >> FlagStageShift);
+		if(Entry.Stage == 1)
+		{
+			// Keep the object name of the common ancestor of a conflict, to give the base revision to merge without spawning Git
+			FSHAHash MergeBaseFileHash;
+			FMemory::Memcpy(MergeBaseFileHash.Hash, Data + 40, HashSize);
+			MergeBaseFileHashes.Add(Entries.Num(), MergeBaseFileHash);
+		}
+		Data += EntryHeaderSize;
+
+		if(Flags & FlagExtended)
+		{
+			if(Version < 3 || Data + 2 > End)
+			{
+				return false;
+			}
+			const uint16 ExtendedFlags = ReadUInt16(Data);
+			Entry.bSkipWorktree = (ExtendedFlags & ExtendedFlagSkipWorktree) != 0;
+			Entry.bIntentToAdd = (ExtendedFlags & ExtendedFlagIntentToAdd) != 0;
+			Data += 2;
+		}
+
+		// Number of bytes of the previous path to keep (version 4 only)
+		int32 PrefixLen = 0;
+		if(Version == 4)
+		{
+			// Prefix compression: number of bytes to remove from the end of the previous path, followed by the rest of the path
+			uint64 StripLen = 0;
+			const int32 PreviousLen = (Entries.Num() > 0) ? Entries.Last().PathLen : 0;
+			if(!ReadVarInt(Data, End, StripLen) || StripLen > uint64(PreviousLen))
+			{
+				return false;
+			}
+			PrefixLen = PreviousLen - int32(StripLen);
+		}
+
+		const uint8* Suffix = Data;
+		while(Data < End && *Data != 0)
+		{
+			++Data;
+		}
+		if(Data >= End)
+		{
+			return false;
+		}
+		const int32 SuffixLen = int32(Data - Suffix);
+		++Data; // NUL terminator
+
+		Entry.PathOffset = Paths.Num();
+		Entry.PathLen = PrefixLen + SuffixLen;
+		Paths.AddUninitialized(Entry.PathLen);
+		if(PrefixLen > 0)
+		{
+			FMemory::Memcpy(Paths.GetData() + Entry.PathOffset, Paths.GetData() + Entries.Last().PathOffset, PrefixLen);
+		}
+		FMemory::Memcpy(Paths.GetData() + Entry.PathOffset + PrefixLen, Suffix, SuffixLen);
+
+		if(Version != 4)
+		{
+			// Entries are padded with 1 to 8 NUL bytes to keep their size a multiple of 8 bytes
+			const int64 EntryLen = (Data - 1) - EntryStart;
+			Data = EntryStart + ((EntryLen + 8) & ~int64(7));
+			if(Data > End)
+			{
+				return false;
+			}
+		}
+
+		bHasConflicts |= (Entry.Stage != 0);
+		Entries.Add(Entry);
+	}
+
+	// Extensions: 4 bytes signature and 4 bytes size
+	while(Data + 8 <= End)
+	{
+		const uint8* Signature = Data;
+		const uint32 ExtensionSize = ReadUInt32(Data + 4);
+		Data += 8;
+		if(Data + ExtensionSize > End)
+		{
+			return false;
+		}
+		if(FMemory::Memcmp(Signature, "TREE", 4) == 0)
+		{
+			ParseTreeExtension(Data, ExtensionSize);
+		}
+		else if(FMemory::Memcmp(Signature, "link", 4) == 0)
+		{
+			// Split index: most entries are in a shared index file
+			UE_LOG(LogSourceControl, Log, TEXT("Git index in split mode not supported"));
+			return false;
+		}
+		Data += ExtensionSize;
+	}
+
+	// "index.skipHash" (implied by "feature.manyFiles") leaves the trailing SHA-1 all zeros:
+	// identify the content by the modification time and the size of the file, its root tree and its number of entries instead
+	if(Checksum == FString::ChrN(2 * HashSize, TEXT('0')))
+	{
+		Checksum = FString::Printf(TEXT("skiphash-%lld-%lld-%s-%u"), Timestamp.GetTicks(), InSize, *RootTreeHash, NumEntries);
+	}
+
+	return (Data == End);
+}
+
+void FGitIndex::ParseTreeExtension(const uint8* InData, const int64 InSize)
+{
+	// The first entry is the root: empty path, NUL, "<entry_count> <subtrees_count>\n", then the SHA-1 if entry_count is not -1 (invalidated)
+	const uint8* Data = InData;
+	const uint8* End = InData + InSize;
+	if(Data >= End || *Data != 0)
+	{
+		return;
+	}
+	++Data;
+
+	const bool bInvalidated = (Data < End && *Data == '-');
+	while(Data < End && *Data != '\n')
+	{
+		++Data;
+	}
+	++Data;
+	if(!bInvalidated && Data + GitIndexConstants::HashSize <= End)
+	{
+		RootTreeHash = BytesToHex(Data, GitIndexConstants::HashSize).ToLower();
+	}
+}
+
+const FGitIndexEntry* FGitIndex::Find(const FString& InRelativePath) const
+{
+	const FTCHARToUTF8 Path(*InRelativePath);
+
+	// Lower bound of the path in the sorted entries
+	int32 Low = 0;
+	int32 High = Entries.Num();
+	while(Low < High)
+	{
+		const int32 Middle = Low + (High - Low) / 2;
+		const FGitIndexEntry& Entry = Entries[Middle];
+		if(ComparePaths(Paths.GetData() + Entry.PathOffset, Entry.PathLen, Path.Get(), Path.Length()) < 0)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	if(Low < Entries.Num())
+	{
+		const FGitIndexEntry& Entry = Entries[Low];
+		if(ComparePaths(Paths.GetData() + Entry.PathOffset, Entry.PathLen, Path.Get(), Path.Length()) == 0)
+		{
+			return &Entry;
+		}
+	}
+	return nullptr;
+}
+
+bool FGitIndex::FindMergeBaseFileHash(const FString& InRelativePath, FString& OutFileHash) const
+{
+	// The stages of an unmerged file are sorted, so its first entry is the common ancestor if there is one
+	const FGitIndexEntry* Entry = Find(InRelativePath);
+	if(Entry == nullptr || Entry->Stage == 0)
+	{
+		return false;
+	}
+	const FSHAHash* MergeBaseFileHash = MergeBaseFileHashes.Find(int32(Entry - Entries.GetData()));
+	OutFileHash = (MergeBaseFileHash != nullptr) ? MergeBaseFileHash->ToString() : FString();
+	return true;
+}
+
+bool FGitIndex::IsUnchanged(const FString& InRelativePath, const FFileStatData& InStatData) const
+{
+	const FGitIndexEntry* Entry = Find(InRelativePath);
+	if(Entry == nullptr || Entry->Stage != 0 || Entry->bSkipWorktree || Entry->bIntentToAdd)
+	{
+		return false;
+	}
+	// Only regular files (not symbolic links nor submodules)
+	if((Entry->Mode & GitIndexConstants::ModeTypeMask) != GitIndexConstants::ModeRegularFile)
+	{
+		return false;
+	}
+	if(!InStatData.bIsValid || InStatData.bIsDirectory || uint32(InStatData.FileSize) != Entry->FileSize)
+	{
+		return false;
+	}
+
+	const FTimespan SinceEpoch = InStatData.ModificationTime - FDateTime(1970, 1, 1);
+	const int64 Seconds = SinceEpoch.GetTicks() / ETimespan::TicksPerSecond;
+	const int64 SubSecondTicks = SinceEpoch.GetTicks() % ETimespan::TicksPerSecond;
+	if(uint32(Seconds) != Entry->MTimeSeconds)
+	{
+		return false;
+	}
+	// Nanoseconds are only stored by some platforms, and with a resolution of 100ns at best
+	if(Entry->MTimeNanoSeconds != 0 && int64(Entry->MTimeNanoSeconds / ETimespan::NanosecondsPerTick) != SubSecondTicks)
+	{
+		return false;
+	}
+
+	// "Racily clean" entry: modified in the same second the index was written, Git would have to compare the content
+	const int64 IndexSeconds = (Timestamp - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerSecond;
+	return Seconds < IndexSeconds;
+}
+
+FGitIndexCache& FGitIndexCache::Get()
+{
+	static FGitIndexCache Instance;
+	return Instance;
+}
+
+TSharedPtr<const FGitIndex, ESPMode::ThreadSafe> FGitIndexCache::GetIndex(const FString& InRepositoryRoot)
+{
+	const FString IndexFile = FGitIndex::FindIndexFile(InRepositoryRoot);
+	if(IndexFile.IsEmpty())
+	{
+		return nullptr;
+	}
+	const FDateTime Timestamp = IFileManager::Get().GetTimeStamp(*IndexFile);
+	if(Timestamp == FDateTime::MinValue())
+	{
+		return nullptr;
+	}
+
+	FScopeLock ScopeLock(&CriticalSection);
+	const TSharedPtr<const FGitIndex, ESPMode::ThreadSafe>* CachedIndex = Indexes.Find(InRepositoryRoot);
+	if(CachedIndex != nullptr && CachedIndex->IsValid() && (*CachedIndex)->GetTimestamp() == Timestamp)
+	{
+		return *CachedIndex;
+	}
+
+	TSharedPtr<FGitIndex, ESPMode::ThreadSafe> NewIndex = MakeShared<FGitIndex, ESPMode::ThreadSafe>();
+	const double StartTime = FPlatformTime::Seconds();
+	if(!NewIndex->Load(IndexFile))
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Cannot read the Git index '%s'"), *IndexFile);
+		Indexes.Remove(InRepositoryRoot);
+		return nullptr;
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("Git index '%s' read in %.3lfs (%d entries)"), *IndexFile, FPlatformTime::Seconds() - StartTime, NewIndex->Num());
+
+	Indexes.Add(InRepositoryRoot, NewIndex);
+	return NewIndex;
+}
+
+void FGitIndexCache::Reset()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Indexes.Reset();
+}
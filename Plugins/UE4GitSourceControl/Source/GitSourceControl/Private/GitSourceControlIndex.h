@@ -0,0 +1,151 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/SecureHash.h"
+
+/** One entry of the Git index, as needed to tell if a file is tracked and unchanged */
+struct FGitIndexEntry
+{
+	/** UTF-8 path relative to the root of the repository, in the path arena of the index */
+	int32 PathOffset = 0;
+	int32 PathLen = 0;
+
+	/** Stat data of the file when it was last added or refreshed */
+	uint32 MTimeSeconds = 0;
+	uint32 MTimeNanoSeconds = 0;
+	uint32 FileSize = 0;
+	uint32 Mode = 0;
+
+	/** Merge stage: 0 for a normal entry, 1 to 3 for an unmerged (conflicted) file */
+	uint8 Stage = 0;
+
+	/** "skip-worktree" (sparse checkout) and "intent-to-add" (git add -N) extended flags */
+	bool bSkipWorktree = false;
+	bool bIntentToAdd = false;
+};
+
+/**
+ * Read-only in-process parser of the ".git/index" file (versions 2, 3 and 4, SHA-1 repositories).
+ *
+ * The index file is memory-mapped while being parsed into one array of entries and one arena of paths,
+ * so that looking up a file is a binary search, without spawning Git nor allocating.
+ * Only the "TREE" (cache tree) extension is used, to tell if the index matches the HEAD commit.
+ * Indexes in "split index" mode (the "link" extension) are not supported.
+ */
+class FGitIndex
+{
+public:
+	/** Find the index file of a repository, following the ".git" file of a submodule or worktree (empty if not found) */
+	static FString FindIndexFile(const FString& InRepositoryRoot);
+
+	/** Map and parse the index file */
+	bool Load(const FString& InIndexFile);
+
+	/** Find the entry of a path relative to the root of the repository (the first stage in case of a conflict), or nullptr if not tracked */
+	const FGitIndexEntry* Find(const FString& InRelativePath) const;
+
+	/** Tell if a path relative to the root of the repository is tracked */
+	bool IsTracked(const FString& InRelativePath) const
+	{
+		return Find(InRelativePath) != nullptr;
+	}
+
+	/**
+	 * Tell if a file is tracked and its stat data (size and modification time) match its entry in the index,
+	 * meaning that it has not been modified since it was last added, committed or checked-out.
+	 */
+	bool IsUnchanged(const FString& InRelativePath, const FFileStatData& InStatData) const;
+
+	/** SHA1 of the tree of the root directory, if the cache tree is valid (empty if not, for instance after a "git add") */
+	const FString& GetRootTreeHash() const
+	{
+		return RootTreeHash;
+	}
+
+	/**
+	 * SHA1 of the content of the index file, stored at its end: changes each time the index is written.
+	 * Made of the modification time, the size, the root tree and the number of entries of the index instead when written without it ("index.skipHash").
+	 */
+	const FString& GetChecksum() const
+	{
+		return Checksum;
+	}
+
+	/**
+	 * Get the SHA1 of the common ancestor (stage 1) of an unmerged file, that is the base revision to merge a conflict.
+	 * @param	OutFileHash		Empty if the file has no common ancestor (conflict between two added files)
+	 * @return true if the file is unmerged in the index
+	 */
+	bool FindMergeBaseFileHash(const FString& InRelativePath, FString& OutFileHash) const;
+
+	/** Tell if some entries are unmerged (conflicts) */
+	bool HasConflicts() const
+	{
+		return bHasConflicts;
+	}
+
+	/** Modification time of the index file when it was loaded */
+	const FDateTime& GetTimestamp() const
+	{
+		return Timestamp;
+	}
+
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+private:
+	/** Parse the content of the index file */
+	bool Parse(const uint8* InData, const int64 InSize);
+
+	/** Parse the "TREE" extension, only to get the hash of the root tree */
+	void ParseTreeExtension(const uint8* InData, const int64 InSize);
+
+	/** Version of the index format (2, 3 or 4) */
+	uint32 Version = 0;
+
+	/** Entries sorted by path, then by stage, like in the index file */
+	TArray<FGitIndexEntry> Entries;
+
+	/** Full UTF-8 paths of all the entries (decompressed for version 4) */
+	TArray<ANSICHAR> Paths;
+
+	/** Object name of the common ancestor (stage 1) of the unmerged files, by index of their entry */
+	TMap<int32, FSHAHash> MergeBaseFileHashes;
+
+	FString RootTreeHash;
+	FString Checksum;
+	bool bHasConflicts = false;
+	FDateTime Timestamp;
+};
+
+/**
+ * Cache of the parsed index of each repository (and submodule), reloaded when the modification time of the index file changes.
+ */
+class FGitIndexCache
+{
+public:
+	static FGitIndexCache& Get();
+
+	/** Get the up to date index of a repository, or an invalid pointer if it cannot be read */
+	TSharedPtr<const FGitIndex, ESPMode::ThreadSafe> GetIndex(const FString& InRepositoryRoot);
+
+	/** Forget all the indexes */
+	void Reset();
+
+private:
+	FGitIndexCache() = default;
+
+	/** Guards the map of indexes (the indexes themselves are immutable once loaded) */
+	FCriticalSection CriticalSection;
+
+	/** Parsed indexes, by repository root */
+	TMap<FString, TSharedPtr<const FGitIndex, ESPMode::ThreadSafe>> Indexes;
+};
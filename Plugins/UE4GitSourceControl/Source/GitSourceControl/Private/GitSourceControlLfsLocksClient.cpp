@@ -0,0 +1,882 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlLfsLocksClient.h"
+
+#include "Dom/JsonObject.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HttpManager.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/Base64.h"
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Modules/ModuleManager.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlProcessPool.h"
+#include "GitSourceControlUtils.h"
+
+namespace GitLfsLocksClientConstants
+{
+
+/** Media type of the requests and responses of the Git LFS APIs */
+static const TCHAR* MediaType = TEXT("application/vnd.git-lfs+json");
+
+/** Number of locks per page of the list */
+static const int32 PageSize = 100;
+
+/** Maximum number of requests waiting for their response at the same time */
+static const int32 MaxParallelRequests = 16;
+
+/** Maximum time to wait for the responses of a batch of requests */
+static const double TimeoutSeconds = 30.0;
+
+}
+
+static TAutoConsoleVariable<int32> CVarGitLfsLocksNativeClient(
+	TEXT("Git.LfsLocksNativeClient"),
+	1,
+	TEXT("Manage the Git LFS locks with HTTP requests to the locking API of the server (1), instead of running the git lfs locks/lock/unlock commands (0)."));
+
+FThreadSafeCounter FGitLfsLocksClient::NumRequests;
+FThreadSafeCounter FGitLfsLocksClient::NumCredentialFills;
+
+/** Absolute repository root without a trailing slash, to use it as a key */
+static FString NormalizeRoot(const FString& InRepositoryRoot)
+{
+	FString Root = FPaths::ConvertRelativePathToFull(InRepositoryRoot);
+	Root.RemoveFromEnd(TEXT("/"));
+	return Root;
+}
+
+/** "https://host:port" of a URL, and its protocol and host (without any user) */
+static FString GetServer(const FString& InUrl, FString& OutProtocol, FString& OutHost)
+{
+	FString Remaining;
+	if(!InUrl.Split(TEXT("://"), &OutProtocol, &Remaining))
+	{
+		return FString();
+	}
+	int32 PathStart;
+	OutHost = Remaining.FindChar(TEXT('/'), PathStart) ? Remaining.Left(PathStart) : Remaining;
+	OutHost.Split(TEXT("@"), nullptr, &OutHost, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+	return OutProtocol + TEXT("://") + OutHost;
+}
+
+/**
+ * URL of the LFS server of an HTTP(S) Git remote, like Git LFS derives it: "https://host/org/repo" => "https://host/org/repo.git/info/lfs"
+ *
+ * Empty for the SSH remotes: Git LFS asks their server for the endpoint and the credentials with "git-lfs-authenticate" over SSH,
+ * the HTTPS endpoint on the same host being only a guess, so they are left to the git lfs commands (unless "lfs.url" is set).
+ */
+static FString MakeLfsUrl(const FString& InRemoteUrl)
+{
+	FString Url = InRemoteUrl.TrimStartAndEnd();
+	if(!Url.StartsWith(TEXT("https://")) && !Url.StartsWith(TEXT("http://")))
+	{
+		return FString();
+	}
+	Url.RemoveFromEnd(TEXT("/"));
+	if(!Url.EndsWith(TEXT(".git")))
+	{
+		Url += TEXT(".git");
+	}
+	return Url + TEXT("/info/lfs");
+}
+
+/** Make a request of the locking API, with a JSON body if any */
+static FHttpRequestPtr MakeRequest(const FString& InUrl, const FString& InAuthorization, const FString& InVerb, const TSharedPtr<FJsonObject>& InBody)
+{
+	FHttpRequestPtr Request = FHttpModule::Get().CreateRequest();
+	Request->SetURL(InUrl);
+	Request->SetVerb(InVerb);
+	Request->SetHeader(TEXT("Accept"), GitLfsLocksClientConstants::MediaType);
+	if(!InAuthorization.IsEmpty())
+	{
+		Request->SetHeader(TEXT("Authorization"), InAuthorization);
+	}
+	if(InBody.IsValid())
+	{
+		FString Body;
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Body);
+		FJsonSerializer::Serialize(InBody.ToSharedRef(), Writer);
+		Request->SetHeader(TEXT("Content-Type"), GitLfsLocksClientConstants::MediaType);
+		Request->SetContentAsString(Body);
+	}
+	return Request;
+}
+
+/** Make the same request again with other credentials, the completed ones being not sent twice */
+static FHttpRequestPtr CopyRequest(const FHttpRequestPtr& InRequest, const FString& InAuthorization)
+{
+	FHttpRequestPtr Request = MakeRequest(InRequest->GetURL(), InAuthorization, InRequest->GetVerb(), nullptr);
+	if(InRequest->GetContentLength() > 0)
+	{
+		Request->SetHeader(TEXT("Content-Type"), GitLfsLocksClientConstants::MediaType);
+		Request->SetContent(InRequest->GetContent());
+	}
+	return Request;
+}
+
+/** HTTP status code of the response of a request, 0 if it got no response */
+static int32 GetResponseCode(const FHttpRequestPtr& InRequest)
+{
+	const FHttpResponsePtr Response = InRequest->GetResponse();
+	if(InRequest->GetStatus() != EHttpRequestStatus::Succeeded || !Response.IsValid())
+	{
+		return 0;
+	}
+	return Response->GetResponseCode();
+}
+
+/**
+ * 401 Unauthorized, or 403 Forbidden to an anonymous request: the server refused the credentials, or needs some
+ * (a 403 to an authenticated request is a lack of permission, like unlocking the lock of another user, that other credentials would not fix)
+ */
+static bool IsUnauthorized(const FHttpRequestPtr& InRequest)
+{
+	const int32 Code = GetResponseCode(InRequest);
+	return (Code == 401) || (Code == 403 && InRequest->GetHeader(TEXT("Authorization")).IsEmpty());
+}
+
+/** HTTP status code and JSON body of the response of a request, 0 if it got no response */
+static int32 GetResponse(const FHttpRequestPtr& InRequest, TSharedPtr<FJsonObject>& OutObject)
+{
+	const int32 Code = GetResponseCode(InRequest);
+	if(Code != 0)
+	{
+		TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(InRequest->GetResponse()->GetContentAsString());
+		FJsonSerializer::Deserialize(Reader, OutObject);
+	}
+	return Code;
+}
+
+/** Error message of a failed request, for the log */
+static FString GetErrorMessage(const int32 InCode, const TSharedPtr<FJsonObject>& InObject)
+{
+	FString Message;
+	if(InObject.IsValid())
+	{
+		InObject->TryGetStringField(TEXT("message"), Message);
+	}
+	return (InCode == 0) ? FString(TEXT("no response")) : FString::Printf(TEXT("HTTP %d %s"), InCode, *Message);
+}
+
+/** Parse a lock object: { "id": "some-uuid", "path": "foo/bar.zip", "locked_at": "2016-05-17T15:49:06+00:00", "owner": { "name": "Jane Doe" } } */
+static bool ParseLock(const TSharedPtr<FJsonObject>& InObject, FGitLfsLock& OutLock)
+{
+	if(!InObject.IsValid() || !InObject->TryGetStringField(TEXT("id"), OutLock.Id) || !InObject->TryGetStringField(TEXT("path"), OutLock.Path))
+	{
+		return false;
+	}
+	const TSharedPtr<FJsonObject>* Owner;
+	if(InObject->TryGetObjectField(TEXT("owner"), Owner))
+	{
+		(*Owner)->TryGetStringField(TEXT("name"), OutLock.Owner);
+	}
+	return true;
+}
+
+/** Parse an array of locks of a response ("locks", "ours" or "theirs") */
+static void ParseLocks(const TSharedPtr<FJsonObject>& InObject, const TCHAR* InField, TArray<FGitLfsLock>& OutLocks)
+{
+	const TArray<TSharedPtr<FJsonValue>>* Values;
+	if(InObject.IsValid() && InObject->TryGetArrayField(InField, Values))
+	{
+		for(const TSharedPtr<FJsonValue>& Value : *Values)
+		{
+			FGitLfsLock Lock;
+			if(ParseLock(Value->AsObject(), Lock))
+			{
+				OutLocks.Add(MoveTemp(Lock));
+			}
+		}
+	}
+}
+
+/** Parse the lock of a response ("lock") */
+static bool ParseSingleLock(const TSharedPtr<FJsonObject>& InObject, FGitLfsLock& OutLock)
+{
+	const TSharedPtr<FJsonObject>* LockObject;
+	return InObject.IsValid() && InObject->TryGetObjectField(TEXT("lock"), LockObject) && ParseLock(*LockObject, OutLock);
+}
+
+FGitLfsLocksClient& FGitLfsLocksClient::Get()
+{
+	static FGitLfsLocksClient Instance;
+	return Instance;
+}
+
+bool FGitLfsLocksClient::IsAvailable(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	FEndpoint Endpoint;
+	return (CVarGitLfsLocksNativeClient.GetValueOnAnyThread() != 0) && GetEndpoint(InPathToGitBinary, InRepositoryRoot, Endpoint);
+}
+
+/** Completion of a batch of requests, shared with their completion delegates that can be called after the wait gave up */
+struct FGitLfsRequestsBatch
+{
+	FGitLfsRequestsBatch()
+		: CompletedEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	{
+	}
+	~FGitLfsRequestsBatch()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(CompletedEvent);
+	}
+
+	/** Triggered each time a request completes (or when the client is aborted) */
+	FEvent* CompletedEvent;
+
+	/** Number of requests completed */
+	FThreadSafeCounter NumCompleted;
+};
+
+bool FGitLfsLocksClient::SendRequests(const TArray<FHttpRequestPtr>& InRequests)
+{
+	using namespace GitLfsLocksClientConstants;
+
+	if(InRequests.Num() == 0)
+	{
+		return true;
+	}
+
+	TSharedRef<FGitLfsRequestsBatch, ESPMode::ThreadSafe> Batch = MakeShared<FGitLfsRequestsBatch, ESPMode::ThreadSafe>();
+	{
+		FScopeLock ScopeLock(&WaitsCriticalSection);
+		if(bAborted)
+		{
+			return false;
+		}
+		WaitEvents.Add(Batch->CompletedEvent);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumSent = 0;
+	bool bCompleted = false;
+	while(!bAborted)
+	{
+		while(NumSent < InRequests.Num() && NumSent - Batch->NumCompleted.GetValue() < MaxParallelRequests)
+		{
+			const FHttpRequestPtr& Request = InRequests[NumSent++];
+#if !UE_VERSION_OLDER_THAN(4, 26, 0)
+			// Complete on the HTTP thread, instead of waiting for the game thread to tick the HTTP manager
+			Request->SetDelegateThreadPolicy(EHttpRequestDelegateThreadPolicy::CompleteOnHttpThread);
+#endif
+			Request->OnProcessRequestComplete().BindLambda([Batch](FHttpRequestPtr, FHttpResponsePtr, bool)
+			{
+				Batch->NumCompleted.Increment();
+				Batch->CompletedEvent->Trigger();
+			});
+			NumRequests.Increment();
+			if(!Request->ProcessRequest())
+			{
+				Request->OnProcessRequestComplete().Unbind();
+				Batch->NumCompleted.Increment();
+			}
+		}
+		if(Batch->NumCompleted.GetValue() >= InRequests.Num())
+		{
+			bCompleted = true;
+			break;
+		}
+		const double RemainingSeconds = TimeoutSeconds - (FPlatformTime::Seconds() - StartTime);
+		if(RemainingSeconds <= 0.0)
+		{
+			UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: no response after %.0lfs"), TimeoutSeconds);
+			break;
+		}
+		uint32 WaitMs = (uint32)FMath::CeilToInt(RemainingSeconds * 1000.0);
+#if UE_VERSION_OLDER_THAN(4, 26, 0)
+		// The requests complete only when the HTTP manager is ticked, by the Editor on the game thread
+		if(IsInGameThread())
+		{
+			FHttpModule::Get().GetHttpManager().Tick(0.0f);
+			WaitMs = FMath::Min(WaitMs, 2u);
+		}
+#endif
+		Batch->CompletedEvent->Wait(WaitMs);
+	}
+
+	{
+		FScopeLock ScopeLock(&WaitsCriticalSection);
+		WaitEvents.Remove(Batch->CompletedEvent);
+	}
+	if(!bCompleted)
+	{
+		for(const FHttpRequestPtr& Request : InRequests)
+		{
+			Request->CancelRequest();
+		}
+	}
+	return bCompleted;
+}
+
+bool FGitLfsLocksClient::SendAndWait(const FString& InPathToGitBinary, const FString& InRepositoryRoot, TArray<FHttpRequestPtr>& InOutRequests)
+{
+	TArray<FString> RequestRoots;
+	RequestRoots.Init(InRepositoryRoot, InOutRequests.Num());
+	return SendAndWait(InPathToGitBinary, RequestRoots, InOutRequests);
+}
+
+bool FGitLfsLocksClient::SendAndWait(const FString& InPathToGitBinary, const TArray<FString>& InRequestRoots, TArray<FHttpRequestPtr>& InOutRequests)
+{
+	bool bCompleted = SendRequests(InOutRequests);
+
+	// The requests refused by the server are sent again once, with the credentials the credential helpers give instead
+	TArray<FHttpRequestPtr> Retries;
+	TArray<int32> RetryIndices;
+	for(int32 Index = 0; Index < InOutRequests.Num(); ++Index)
+	{
+		const int32 Code = GetResponseCode(InOutRequests[Index]);
+		if(IsUnauthorized(InOutRequests[Index]))
+		{
+			FString Authorization;
+			if(RejectCredentials(InPathToGitBinary, InRequestRoots[Index], InOutRequests[Index]->GetHeader(TEXT("Authorization")), true, Authorization))
+			{
+				Retries.Add(CopyRequest(InOutRequests[Index], Authorization));
+				RetryIndices.Add(Index);
+			}
+		}
+		else if(Code >= 200 && Code < 300)
+		{
+			ApproveCredentials(InPathToGitBinary, InRequestRoots[Index]);
+		}
+	}
+	if(Retries.Num() > 0)
+	{
+		bCompleted &= SendRequests(Retries);
+		for(int32 RetryIndex = 0; RetryIndex < Retries.Num(); ++RetryIndex)
+		{
+			const int32 Index = RetryIndices[RetryIndex];
+			InOutRequests[Index] = Retries[RetryIndex];
+			const int32 Code = GetResponseCode(Retries[RetryIndex]);
+			if(IsUnauthorized(Retries[RetryIndex]))
+			{
+				FString Authorization;
+				RejectCredentials(InPathToGitBinary, InRequestRoots[Index], Retries[RetryIndex]->GetHeader(TEXT("Authorization")), false, Authorization);
+			}
+			else if(Code >= 200 && Code < 300)
+			{
+				ApproveCredentials(InPathToGitBinary, InRequestRoots[Index]);
+			}
+		}
+	}
+	return bCompleted;
+}
+
+void FGitLfsLocksClient::Abort()
+{
+	FScopeLock ScopeLock(&WaitsCriticalSection);
+	bAborted = true;
+	for(FEvent* WaitEvent : WaitEvents)
+	{
+		WaitEvent->Trigger();
+	}
+}
+
+void FGitLfsLocksClient::Resume()
+{
+	FScopeLock ScopeLock(&WaitsCriticalSection);
+	bAborted = false;
+}
+
+void FGitLfsLocksClient::Reset()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Endpoints.Reset();
+	Credentials.Reset();
+	LockIds.Reset();
+}
+
+void FGitLfsLocksClient::SetEndpoint(const FString& InRepositoryRoot, const FString& InUrl)
+{
+	FEndpoint Endpoint;
+	Endpoint.Url = InUrl;
+	FString Protocol, Host;
+	Endpoint.Server = GetServer(InUrl, Protocol, Host);
+
+	FScopeLock ScopeLock(&CriticalSection);
+	Credentials.Add(Endpoint.Server, FCredentials());
+	Endpoints.Add(NormalizeRoot(InRepositoryRoot), Endpoint);
+}
+
+bool FGitLfsLocksClient::GetEndpoint(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FEndpoint& OutEndpoint)
+{
+	const FString Root = NormalizeRoot(InRepositoryRoot);
+
+	// Held while looking up the endpoint, so that the credentials of a server are asked only once
+	FScopeLock ScopeLock(&CriticalSection);
+	if(const FEndpoint* Endpoint = Endpoints.Find(Root))
+	{
+		OutEndpoint = *Endpoint;
+		return !OutEndpoint.Url.IsEmpty();
+	}
+
+	FEndpoint Endpoint;
+	Endpoint.Url = FindLfsUrl(InPathToGitBinary, Root);
+	if(!Endpoint.Url.IsEmpty())
+	{
+		FString Protocol, Host;
+		Endpoint.Server = GetServer(Endpoint.Url, Protocol, Host);
+		if(const FCredentials* ServerCredentials = Credentials.Find(Endpoint.Server))
+		{
+			Endpoint.Authorization = ServerCredentials->Authorization;
+		}
+		else
+		{
+			// Even if empty: the server may accept anonymous requests, else its first 401 makes RejectCredentials() ask again
+			FCredentials NewCredentials;
+			FillCredentials(InPathToGitBinary, Root, Endpoint.Url, NewCredentials);
+			Endpoint.Authorization = NewCredentials.Authorization;
+			Credentials.Add(Endpoint.Server, MoveTemp(NewCredentials));
+		}
+		UE_LOG(LogSourceControl, Log, TEXT("Git LFS locking API of '%s': %s"), *Root, *Endpoint.Url);
+	}
+	else
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Git LFS locking API of '%s': no HTTP(S) endpoint, using the git lfs commands"), *Root);
+	}
+	Endpoints.Add(Root, Endpoint);
+	OutEndpoint = Endpoint;
+	return !OutEndpoint.Url.IsEmpty();
+}
+
+void FGitLfsLocksClient::ApproveCredentials(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	FString Url;
+	FCredentials Approved;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		const FEndpoint* Endpoint = Endpoints.Find(NormalizeRoot(InRepositoryRoot));
+		FCredentials* ServerCredentials = Endpoint ? Credentials.Find(Endpoint->Server) : nullptr;
+		if(ServerCredentials == nullptr || ServerCredentials->bApproved || ServerCredentials->Authorization.IsEmpty())
+		{
+			return;
+		}
+		ServerCredentials->bApproved = true;
+		Url = Endpoint->Url;
+		Approved = *ServerCredentials;
+	}
+	// Let the credential helpers store the credentials the server accepted, like Git does after a successful fetch
+	RunCredentialCommand(InPathToGitBinary, InRepositoryRoot, TEXT("credential approve"), Url, Approved);
+}
+
+bool FGitLfsLocksClient::RejectCredentials(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InRefusedAuthorization, const bool bInFillAgain, FString& OutAuthorization)
+{
+	const FString Root = NormalizeRoot(InRepositoryRoot);
+
+	// Held while asking for new credentials, so that they are asked only once for all the requests refused at the same time
+	FScopeLock ScopeLock(&CriticalSection);
+	FEndpoint* Endpoint = Endpoints.Find(Root);
+	if(Endpoint == nullptr || Endpoint->Url.IsEmpty())
+	{
+		return false;
+	}
+	FCredentials& ServerCredentials = Credentials.FindOrAdd(Endpoint->Server);
+	if(ServerCredentials.Authorization != InRefusedAuthorization)
+	{
+		// Already renewed for another request to the same server
+		OutAuthorization = ServerCredentials.Authorization;
+		return true;
+	}
+
+	// Let the credential helpers forget the credentials the server refused, so that they are not given again
+	if(!ServerCredentials.Authorization.IsEmpty())
+	{
+		RunCredentialCommand(InPathToGitBinary, Root, TEXT("credential reject"), Endpoint->Url, ServerCredentials);
+	}
+	FCredentials NewCredentials;
+	if(bInFillAgain)
+	{
+		FillCredentials(InPathToGitBinary, Root, Endpoint->Url, NewCredentials);
+	}
+	const FString Server = Endpoint->Server;
+	if(NewCredentials.Authorization.IsEmpty() || NewCredentials.Authorization == InRefusedAuthorization)
+	{
+		// The git lfs commands may still be able to authenticate (SSH, custom transfer agents...)
+		UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: %s refused the credentials, using the git lfs commands"), *Server);
+		for(TPair<FString, FEndpoint>& Pair : Endpoints)
+		{
+			if(Pair.Value.Server == Server)
+			{
+				Pair.Value.Url.Reset();
+			}
+		}
+		Credentials.Remove(Server);
+		return false;
+	}
+
+	OutAuthorization = NewCredentials.Authorization;
+	ServerCredentials = MoveTemp(NewCredentials);
+	for(TPair<FString, FEndpoint>& Pair : Endpoints)
+	{
+		if(Pair.Value.Server == Server)
+		{
+			Pair.Value.Authorization = OutAuthorization;
+		}
+	}
+	return true;
+}
+
+FString FGitLfsLocksClient::FindLfsUrl(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FString Url = GitSourceControl.AccessSettings().GetLfsLocksUrl();
+	if(Url.IsEmpty() || InRepositoryRoot != NormalizeRoot(GitSourceControl.GetProvider().GetPathToRepositoryRoot()))
+	{
+		Url.Reset();
+
+		// "lfs.url" of the Git configuration, else of the ".lfsconfig" file of the repository
+		TArray<FString> Results;
+		TArray<FString> ErrorMessages;
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--get"));
+		Parameters.Add(TEXT("lfs.url"));
+		if(!GitSourceControlUtils::RunCommand(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages) || Results.Num() == 0)
+		{
+			Parameters.Insert(TEXT("--file=.lfsconfig"), 0);
+			Results.Reset();
+			GitSourceControlUtils::RunCommand(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages);
+		}
+		if(Results.Num() > 0)
+		{
+			Url = Results[0].TrimStartAndEnd();
+		}
+		else
+		{
+			FString RemoteUrl;
+			if(GitSourceControlUtils::GetRemoteUrl(InPathToGitBinary, InRepositoryRoot, RemoteUrl))
+			{
+				Url = MakeLfsUrl(RemoteUrl);
+			}
+		}
+	}
+
+	Url.RemoveFromEnd(TEXT("/"));
+	if(!Url.StartsWith(TEXT("https://")) && !Url.StartsWith(TEXT("http://")))
+	{
+		return FString();
+	}
+	return Url;
+}
+
+bool FGitLfsLocksClient::FillCredentials(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InUrl, FCredentials& OutCredentials)
+{
+	FString Protocol, Host;
+	GetServer(InUrl, Protocol, Host);
+
+	// The credential helpers configured for Git (the same ones Git LFS uses)
+	FGitHelperProcess Process(InPathToGitBinary, InRepositoryRoot, TEXT("credential fill"));
+	if(!Process.Launch())
+	{
+		return false;
+	}
+	NumCredentialFills.Increment();
+	Process.Write(FString::Printf(TEXT("protocol=%s\nhost=%s\n\n"), *Protocol, *Host));
+
+	// "username=..." and "password=..." lines, until the process exits
+	TArray<uint8> Line;
+	while(Process.ReadUntil('\n', Line))
+	{
+		FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Line.GetData()), Line.Num());
+		const FString Field(Converter.Length(), Converter.Get());
+		if(Field.StartsWith(TEXT("username=")))
+		{
+			OutCredentials.Username = Field.RightChop(9);
+		}
+		else if(Field.StartsWith(TEXT("password=")))
+		{
+			OutCredentials.Password = Field.RightChop(9);
+		}
+		Line.Reset();
+	}
+	Process.Terminate();
+
+	if(OutCredentials.Username.IsEmpty() && OutCredentials.Password.IsEmpty())
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Git LFS locking API: no credentials for %s, anonymous requests"), *Host);
+		return false;
+	}
+	FTCHARToUTF8 Utf8Credentials(*(OutCredentials.Username + TEXT(":") + OutCredentials.Password));
+	OutCredentials.Authorization = TEXT("Basic ") + FBase64::Encode(reinterpret_cast<const uint8*>(Utf8Credentials.Get()), Utf8Credentials.Length());
+	return true;
+}
+
+void FGitLfsLocksClient::RunCredentialCommand(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TCHAR* InCommand, const FString& InUrl, const FCredentials& InCredentials)
+{
+	FString Protocol, Host;
+	GetServer(InUrl, Protocol, Host);
+
+	FGitHelperProcess Process(InPathToGitBinary, InRepositoryRoot, InCommand);
+	if(Process.Launch())
+	{
+		Process.Write(FString::Printf(TEXT("protocol=%s\nhost=%s\nusername=%s\npassword=%s\n\n"), *Protocol, *Host, *InCredentials.Username, *InCredentials.Password));
+		if(!Process.WaitForExit())
+		{
+			UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: 'git %s' did not complete for %s"), InCommand, *Host);
+		}
+	}
+}
+
+void FGitLfsLocksClient::SetLockId(const FString& InRepositoryRoot, const FString& InPath, const FString& InId)
+{
+	const FString Key = NormalizeRoot(InRepositoryRoot) + TEXT("|") + InPath;
+	FScopeLock ScopeLock(&CriticalSection);
+	if(InId.IsEmpty())
+	{
+		LockIds.Remove(Key);
+	}
+	else
+	{
+		LockIds.Add(Key, InId);
+	}
+}
+
+bool FGitLfsLocksClient::ListLocks(const FString& InPathToGitBinary, const TArray<FString>& InRepositoryRoots, TArray<TArray<FGitLfsLock>>& OutLocks)
+{
+	using namespace GitLfsLocksClientConstants;
+
+	OutLocks.Reset();
+	OutLocks.SetNum(InRepositoryRoots.Num());
+	TArray<FEndpoint> RootEndpoints;
+	RootEndpoints.SetNum(InRepositoryRoots.Num());
+	for(int32 Index = 0; Index < InRepositoryRoots.Num(); ++Index)
+	{
+		if(!GetEndpoint(InPathToGitBinary, InRepositoryRoots[Index], RootEndpoints[Index]))
+		{
+			return false;
+		}
+	}
+
+	// One page of each repository at a time, the repositories in parallel
+	bool bResult = true;
+	TArray<int32> PendingRoots;
+	TArray<FString> Cursors;
+	for(int32 Index = 0; Index < InRepositoryRoots.Num(); ++Index)
+	{
+		PendingRoots.Add(Index);
+		Cursors.Add(FString());
+	}
+	while(PendingRoots.Num() > 0)
+	{
+		TArray<FHttpRequestPtr> Requests;
+		TArray<FString> RequestRoots;
+		for(const int32 Index : PendingRoots)
+		{
+			FString Url = FString::Printf(TEXT("%s/locks?limit=%d"), *RootEndpoints[Index].Url, PageSize);
+			if(!Cursors[Index].IsEmpty())
+			{
+				Url += TEXT("&cursor=") + FGenericPlatformHttp::UrlEncode(Cursors[Index]);
+			}
+			Requests.Add(MakeRequest(Url, RootEndpoints[Index].Authorization, TEXT("GET"), nullptr));
+			RequestRoots.Add(InRepositoryRoots[Index]);
+		}
+		SendAndWait(InPathToGitBinary, RequestRoots, Requests);
+
+		TArray<int32> NextRoots;
+		for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+		{
+			const int32 Index = PendingRoots[RequestIndex];
+			TSharedPtr<FJsonObject> Object;
+			const int32 Code = GetResponse(Requests[RequestIndex], Object);
+			if(Code != 200 || !Object.IsValid())
+			{
+				UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: cannot list the locks of '%s': %s"), *InRepositoryRoots[Index], *GetErrorMessage(Code, Object));
+				bResult = false;
+				continue;
+			}
+			ParseLocks(Object, TEXT("locks"), OutLocks[Index]);
+			if(Object->TryGetStringField(TEXT("next_cursor"), Cursors[Index]) && !Cursors[Index].IsEmpty())
+			{
+				NextRoots.Add(Index);
+			}
+		}
+		PendingRoots = MoveTemp(NextRoots);
+	}
+
+	for(int32 Index = 0; Index < InRepositoryRoots.Num(); ++Index)
+	{
+		for(const FGitLfsLock& Lock : OutLocks[Index])
+		{
+			SetLockId(InRepositoryRoots[Index], Lock.Path, Lock.Id);
+		}
+	}
+	return bResult;
+}
+
+bool FGitLfsLocksClient::VerifyLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, TArray<FGitLfsLock>& OutOurs, TArray<FGitLfsLock>& OutTheirs)
+{
+	using namespace GitLfsLocksClientConstants;
+
+	FEndpoint Endpoint;
+	if(!GetEndpoint(InPathToGitBinary, InRepositoryRoot, Endpoint))
+	{
+		return false;
+	}
+
+	FString Cursor;
+	do
+	{
+		TSharedPtr<FJsonObject> Body = MakeShared<FJsonObject>();
+		Body->SetNumberField(TEXT("limit"), PageSize);
+		if(!Cursor.IsEmpty())
+		{
+			Body->SetStringField(TEXT("cursor"), Cursor);
+		}
+		TArray<FHttpRequestPtr> Requests;
+		Requests.Add(MakeRequest(Endpoint.Url + TEXT("/locks/verify"), Endpoint.Authorization, TEXT("POST"), Body));
+		SendAndWait(InPathToGitBinary, InRepositoryRoot, Requests);
+
+		TSharedPtr<FJsonObject> Object;
+		const int32 Code = GetResponse(Requests[0], Object);
+		if(Code != 200 || !Object.IsValid())
+		{
+			UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: cannot verify the locks of '%s': %s"), *InRepositoryRoot, *GetErrorMessage(Code, Object));
+			return false;
+		}
+		ParseLocks(Object, TEXT("ours"), OutOurs);
+		ParseLocks(Object, TEXT("theirs"), OutTheirs);
+		Cursor.Reset();
+		Object->TryGetStringField(TEXT("next_cursor"), Cursor);
+	}
+	while(!Cursor.IsEmpty());
+	return true;
+}
+
+bool FGitLfsLocksClient::CreateLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutFailedFiles)
+{
+	FEndpoint Endpoint;
+	if(!GetEndpoint(InPathToGitBinary, InRepositoryRoot, Endpoint))
+	{
+		OutFailedFiles.Append(InFiles);
+		return false;
+	}
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
+
+	TArray<FHttpRequestPtr> Requests;
+	for(const FString& File : InFiles)
+	{
+		TSharedPtr<FJsonObject> Body = MakeShared<FJsonObject>();
+		Body->SetStringField(TEXT("path"), File);
+		Requests.Add(MakeRequest(Endpoint.Url + TEXT("/locks"), Endpoint.Authorization, TEXT("POST"), Body));
+	}
+	SendAndWait(InPathToGitBinary, InRepositoryRoot, Requests);
+
+	for(int32 Index = 0; Index < InFiles.Num(); ++Index)
+	{
+		TSharedPtr<FJsonObject> Object;
+		const int32 Code = GetResponse(Requests[Index], Object);
+		FGitLfsLock Lock;
+		const bool bHasLock = ParseSingleLock(Object, Lock);
+		// 201 Created, or 409 Conflict with the existing lock, that can be ours already
+		if(bHasLock && (Code == 201 || (Code == 409 && Lock.Owner == LfsUserName)))
+		{
+			SetLockId(InRepositoryRoot, Lock.Path, Lock.Id);
+		}
+		else
+		{
+			UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: cannot lock '%s': %s"), *InFiles[Index], (Code == 409 && bHasLock) ? *FString::Printf(TEXT("locked by %s"), *Lock.Owner) : *GetErrorMessage(Code, Object));
+			OutFailedFiles.Add(InFiles[Index]);
+		}
+	}
+	return (OutFailedFiles.Num() == 0);
+}
+
+bool FGitLfsLocksClient::DeleteLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutFailedFiles)
+{
+	FEndpoint Endpoint;
+	if(!GetEndpoint(InPathToGitBinary, InRepositoryRoot, Endpoint))
+	{
+		OutFailedFiles.Append(InFiles);
+		return false;
+	}
+
+	// The identifiers of the locks listed or created before, else find them (in parallel)
+	TArray<FString> Ids;
+	TArray<int32> UnknownIds;
+	{
+		const FString RootPrefix = NormalizeRoot(InRepositoryRoot) + TEXT("|");
+		FScopeLock ScopeLock(&CriticalSection);
+		for(int32 Index = 0; Index < InFiles.Num(); ++Index)
+		{
+			const FString* Id = LockIds.Find(RootPrefix + InFiles[Index]);
+			Ids.Add(Id ? *Id : FString());
+			if(Id == nullptr)
+			{
+				UnknownIds.Add(Index);
+			}
+		}
+	}
+	if(UnknownIds.Num() > 0)
+	{
+		TArray<FHttpRequestPtr> Requests;
+		for(const int32 Index : UnknownIds)
+		{
+			Requests.Add(MakeRequest(Endpoint.Url + TEXT("/locks?path=") + FGenericPlatformHttp::UrlEncode(InFiles[Index]), Endpoint.Authorization, TEXT("GET"), nullptr));
+		}
+		SendAndWait(InPathToGitBinary, InRepositoryRoot, Requests);
+		for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+		{
+			const int32 Index = UnknownIds[RequestIndex];
+			TSharedPtr<FJsonObject> Object;
+			const int32 Code = GetResponse(Requests[RequestIndex], Object);
+			TArray<FGitLfsLock> Locks;
+			ParseLocks(Object, TEXT("locks"), Locks);
+			if(Code != 200)
+			{
+				UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: cannot find the lock of '%s': %s"), *InFiles[Index], *GetErrorMessage(Code, Object));
+				OutFailedFiles.Add(InFiles[Index]);
+			}
+			else if(Locks.Num() > 0)
+			{
+				Ids[Index] = Locks[0].Id;
+			}
+			// else not locked anymore: nothing to unlock
+		}
+	}
+
+	TArray<FHttpRequestPtr> Requests;
+	TArray<int32> RequestFiles;
+	for(int32 Index = 0; Index < InFiles.Num(); ++Index)
+	{
+		if(!Ids[Index].IsEmpty())
+		{
+			TSharedPtr<FJsonObject> Body = MakeShared<FJsonObject>();
+			Body->SetBoolField(TEXT("force"), false);
+			Requests.Add(MakeRequest(Endpoint.Url + TEXT("/locks/") + FGenericPlatformHttp::UrlEncode(Ids[Index]) + TEXT("/unlock"), Endpoint.Authorization, TEXT("POST"), Body));
+			RequestFiles.Add(Index);
+		}
+	}
+	SendAndWait(InPathToGitBinary, InRepositoryRoot, Requests);
+
+	for(int32 RequestIndex = 0; RequestIndex < Requests.Num(); ++RequestIndex)
+	{
+		const int32 Index = RequestFiles[RequestIndex];
+		TSharedPtr<FJsonObject> Object;
+		const int32 Code = GetResponse(Requests[RequestIndex], Object);
+		// 404 Not Found: unlocked in the meantime
+		if(Code == 200 || Code == 404)
+		{
+			SetLockId(InRepositoryRoot, InFiles[Index], FString());
+		}
+		else
+		{
+			UE_LOG(LogSourceControl, Warning, TEXT("Git LFS locking API: cannot unlock '%s': %s"), *InFiles[Index], *GetErrorMessage(Code, Object));
+			OutFailedFiles.Add(InFiles[Index]);
+		}
+	}
+	return (OutFailedFiles.Num() == 0);
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Interfaces/IHttpRequest.h"
+
+/** A lock of the Git LFS locking API */
+struct FGitLfsLock
+{
+	/** Identifier of the lock on the server, to delete it */
+	FString Id;
+
+	/** Path of the locked file, relative to the root of its repository */
+	FString Path;
+
+	/** Name of the owner of the lock */
+	FString Owner;
+};
+
+/**
+ * Client of the Git LFS File Locking API (https://github.com/git-lfs/git-lfs/blob/main/docs/api/locking.md),
+ * replacing the "git lfs locks", "git lfs lock" and "git lfs unlock" commands.
+ *
+ * Each command spawned a Git LFS process, which looked up the credentials and opened its own TLS connection to the server.
+ * The client sends HTTP requests through the HTTP module of the engine, that keeps the connections alive,
+ * sends the requests of many files or many repositories (submodules) in parallel,
+ * and asks "git credential fill" for the credentials only once per server (again if the server refuses them).
+ *
+ * The endpoint of a repository is the "LfsLocksUrl" setting for the main repository, else "lfs.url" of the Git configuration or of ".lfsconfig",
+ * else derived from the URL of the "origin" remote if it is an HTTP(S) one. The SSH remotes are left to the Git LFS commands,
+ * and so are the servers refusing the credentials (401, or 403 to an anonymous request): the callers fall back to the Git LFS commands if IsAvailable() is false,
+ * including when it becomes false after a request failed.
+ */
+class FGitLfsLocksClient
+{
+public:
+	static FGitLfsLocksClient& Get();
+
+	/** Tell if the locks of the repository can be managed with the API (the client is enabled and the repository has an HTTP(S) endpoint) */
+	bool IsAvailable(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/**
+	 * List all the locks of many repositories, requesting their pages in parallel
+	 * @param	OutLocks	The locks of each repository, in the order of InRepositoryRoots
+	 * @returns true if the locks of all the repositories could be listed
+	 */
+	bool ListLocks(const FString& InPathToGitBinary, const TArray<FString>& InRepositoryRoots, TArray<TArray<FGitLfsLock>>& OutLocks);
+
+	/** List the locks of a repository owned by the current user (ours) and by the others (theirs) */
+	bool VerifyLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, TArray<FGitLfsLock>& OutOurs, TArray<FGitLfsLock>& OutTheirs);
+
+	/**
+	 * Lock files (relative to the repository root), with one request per file, in parallel
+	 * @param	OutFailedFiles	The files that could not be locked (already locked by another user, or error)
+	 * @returns true if all the files are locked by the current user
+	 */
+	bool CreateLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutFailedFiles);
+
+	/**
+	 * Unlock files (relative to the repository root), with one request per file, in parallel
+	 * @param	OutFailedFiles	The files that could not be unlocked
+	 * @returns true if none of the files is locked anymore
+	 */
+	bool DeleteLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutFailedFiles);
+
+	/** Forget the endpoints, the credentials and the identifiers of the locks (when the settings change) */
+	void Reset();
+
+	/** Use the given endpoint for the repository, with anonymous requests (to check the client against a local stub server) */
+	void SetEndpoint(const FString& InRepositoryRoot, const FString& InUrl);
+
+	/** Cancel the requests waiting for their responses, and fail the next ones at once, until Resume() (when the locks worker stops) */
+	void Abort();
+
+	/** Send the requests again after Abort() (when the locks worker starts) */
+	void Resume();
+
+	/** Number of HTTP requests sent, and of credentials looked up, since the last ResetCounters(), for the benchmarks */
+	static int32 GetNumRequests()
+	{
+		return NumRequests.GetValue();
+	}
+	static int32 GetNumCredentialFills()
+	{
+		return NumCredentialFills.GetValue();
+	}
+	static void ResetCounters()
+	{
+		NumRequests.Reset();
+		NumCredentialFills.Reset();
+	}
+
+private:
+	FGitLfsLocksClient() = default;
+
+	/** Locking API of a repository */
+	struct FEndpoint
+	{
+		/** URL of the LFS server, the locks being at Url + "/locks", empty if the repository has no HTTP(S) endpoint */
+		FString Url;
+
+		/** "https://host:port" of the URL, the key of its credentials */
+		FString Server;
+
+		/** Value of the "Authorization" header, empty for anonymous requests */
+		FString Authorization;
+	};
+
+	/** Credentials of a server, given by the credential helpers */
+	struct FCredentials
+	{
+		FString Username;
+		FString Password;
+
+		/** Value of the "Authorization" header, empty for anonymous requests */
+		FString Authorization;
+
+		/** Set once the credentials were accepted by the server and given back to the credential helpers */
+		bool bApproved = false;
+	};
+
+	/** Find the endpoint of the repository, and its credentials, the first time */
+	bool GetEndpoint(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FEndpoint& OutEndpoint);
+
+	/** URL of the LFS server of the repository from the settings or the Git configuration, empty if not HTTP(S) */
+	static FString FindLfsUrl(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/** Ask "git credential fill" for the credentials of the server of the URL, and make their "Authorization" header (false if no credentials) */
+	static bool FillCredentials(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InUrl, FCredentials& OutCredentials);
+
+	/** Give credentials back to the credential helpers with "git credential approve" or "git credential reject" */
+	static void RunCredentialCommand(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TCHAR* InCommand, const FString& InUrl, const FCredentials& InCredentials);
+
+	/** Approve the credentials of the server of the repository the first time it accepts them */
+	void ApproveCredentials(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/**
+	 * Reject the credentials the server of the repository refused, and ask for new ones if bInFillAgain
+	 * @returns true with the "Authorization" header to send the request again, false if the repositories of the server must use the git lfs commands from now on
+	 */
+	bool RejectCredentials(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InRefusedAuthorization, const bool bInFillAgain, FString& OutAuthorization);
+
+	/**
+	 * Send the requests, keeping up to MaxParallelRequests of them in flight, and wait for all their responses
+	 * @returns false if they did not all complete before the timeout, or if the client was aborted
+	 */
+	bool SendRequests(const TArray<FHttpRequestPtr>& InRequests);
+
+	/**
+	 * Send the requests of the repositories and wait for their responses, sending the ones refused by the server (401, or 403 to an anonymous request) again once with new credentials
+	 * @param	InRequestRoots	The repository root of each request
+	 * @param	InOutRequests	The requests, replaced by the ones sent again
+	 * @returns false if they did not all complete before the timeout, or if the client was aborted
+	 */
+	bool SendAndWait(const FString& InPathToGitBinary, const TArray<FString>& InRequestRoots, TArray<FHttpRequestPtr>& InOutRequests);
+
+	/** Send the requests of one repository and wait for their responses */
+	bool SendAndWait(const FString& InPathToGitBinary, const FString& InRepositoryRoot, TArray<FHttpRequestPtr>& InOutRequests);
+
+	/** Remember the identifier of a lock, or forget it (empty InId) */
+	void SetLockId(const FString& InRepositoryRoot, const FString& InPath, const FString& InId);
+
+	/** Guards the endpoints, the credentials and the identifiers of the locks */
+	FCriticalSection CriticalSection;
+
+	/** Endpoint of each repository root */
+	TMap<FString, FEndpoint> Endpoints;
+
+	/** Credentials of each server ("https://host:port"), shared by the repositories on the same server */
+	TMap<FString, FCredentials> Credentials;
+
+	/** Identifier of the locks listed or created, by repository root + "|" + path, to delete them without listing them first */
+	TMap<FString, FString> LockIds;
+
+	/** Guards the events of the waits in progress */
+	FCriticalSection WaitsCriticalSection;
+
+	/** Event of each wait in progress, to wake it up on Abort() */
+	TArray<FEvent*> WaitEvents;
+
+	/** Set by Abort() until Resume(), read without holding WaitsCriticalSection by the waits in progress */
+	FThreadSafeBool bAborted;
+
+	static FThreadSafeCounter NumRequests;
+	static FThreadSafeCounter NumCredentialFills;
+};
@@ -0,0 +1,228 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlLfsLocksStubServer.h"
+
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ISourceControlModule.h"
+
+/** Maximum number of locks per page when the request does not give a limit */
+static const int32 DefaultPageSize = 100;
+
+FGitLfsLocksStubServer::FGitLfsLocksStubServer(const uint32 InPort, const FString& InUserName)
+	: Port(InPort)
+	, UserName(InUserName)
+{
+}
+
+FGitLfsLocksStubServer::~FGitLfsLocksStubServer()
+{
+	Stop();
+}
+
+bool FGitLfsLocksStubServer::Start()
+{
+	Router = FHttpServerModule::Get().GetHttpRouter(Port);
+	if(!Router.IsValid())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git LFS locking API stub: cannot listen on port %u"), Port);
+		return false;
+	}
+
+	auto Handler = [this](const FHttpServerRequest& InRequest, const FHttpResultCallback& OnComplete)
+	{
+		return HandleRequest(InRequest, [&OnComplete](const int32 InCode, const TSharedRef<FJsonObject>& InBody)
+		{
+			FString Body;
+			TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Body);
+			FJsonSerializer::Serialize(InBody, Writer);
+			TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(Body, TEXT("application/vnd.git-lfs+json"));
+			Response->Code = static_cast<EHttpServerResponseCodes>(InCode);
+			OnComplete(MoveTemp(Response));
+		});
+	};
+	const EHttpServerRequestVerbs Verbs = EHttpServerRequestVerbs::VERB_GET | EHttpServerRequestVerbs::VERB_POST;
+#if UE_VERSION_OLDER_THAN(5, 1, 0)
+	RouteHandle = Router->BindRoute(FHttpPath(TEXT("/lfs/locks")), Verbs, Handler);
+#else
+	RouteHandle = Router->BindRoute(FHttpPath(TEXT("/lfs/locks")), Verbs, FHttpRequestHandler::CreateLambda(Handler));
+#endif
+	if(!RouteHandle.IsValid())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git LFS locking API stub: cannot bind the routes on port %u"), Port);
+		return false;
+	}
+	FHttpServerModule::Get().StartAllListeners();
+	return true;
+}
+
+void FGitLfsLocksStubServer::Stop()
+{
+	if(Router.IsValid() && RouteHandle.IsValid())
+	{
+		Router->UnbindRoute(RouteHandle);
+	}
+	RouteHandle.Reset();
+	Router.Reset();
+}
+
+FString FGitLfsLocksStubServer::GetUrl() const
+{
+	return FString::Printf(TEXT("http://127.0.0.1:%u/lfs"), Port);
+}
+
+void FGitLfsLocksStubServer::AddLock(const FString& InPath, const FString& InOwner)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	FGitLfsLock& Lock = Locks.Add(NextId);
+	Lock.Id = FString::FromInt(NextId++);
+	Lock.Path = InPath;
+	Lock.Owner = InOwner;
+}
+
+int32 FGitLfsLocksStubServer::GetNumLocks() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return Locks.Num();
+}
+
+TSharedRef<FJsonObject> FGitLfsLocksStubServer::MakeLockObject(const FGitLfsLock& InLock) const
+{
+	TSharedRef<FJsonObject> Owner = MakeShared<FJsonObject>();
+	Owner->SetStringField(TEXT("name"), InLock.Owner);
+	TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+	Object->SetStringField(TEXT("id"), InLock.Id);
+	Object->SetStringField(TEXT("path"), InLock.Path);
+	Object->SetStringField(TEXT("locked_at"), TEXT("2020-01-01T00:00:00Z"));
+	Object->SetObjectField(TEXT("owner"), Owner);
+	return Object;
+}
+
+bool FGitLfsLocksStubServer::HandleRequest(const FHttpServerRequest& InRequest, TFunction<void(const int32 InCode, const TSharedRef<FJsonObject>& InBody)> InRespond)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	++NumRequests;
+
+	// "", "verify" or "<id>/unlock", whether the path is given relative to the route or not
+	FString Path = InRequest.RelativePath.GetPath();
+	const int32 RouteEnd = Path.Find(TEXT("/locks"));
+	if(RouteEnd != INDEX_NONE)
+	{
+		Path = Path.RightChop(RouteEnd + 6);
+	}
+	while(Path.RemoveFromStart(TEXT("/")));
+
+	TSharedPtr<FJsonObject> Body;
+	if(InRequest.Body.Num() > 0)
+	{
+		FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(InRequest.Body.GetData()), InRequest.Body.Num());
+		TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(FString(Converter.Length(), Converter.Get()));
+		FJsonSerializer::Deserialize(Reader, Body);
+	}
+	if(!Body.IsValid())
+	{
+		Body = MakeShared<FJsonObject>();
+	}
+
+	TSharedRef<FJsonObject> Response = MakeShared<FJsonObject>();
+	const bool bGet = (InRequest.Verb == EHttpServerRequestVerbs::VERB_GET);
+	if(Path.IsEmpty() && bGet)
+	{
+		// List, filtered by path, one page from the cursor (the identifier of its first lock)
+		const FString* PathFilter = InRequest.QueryParams.Find(TEXT("path"));
+		const FString* Cursor = InRequest.QueryParams.Find(TEXT("cursor"));
+		const FString* Limit = InRequest.QueryParams.Find(TEXT("limit"));
+		const int32 FirstId = Cursor ? FCString::Atoi(**Cursor) : 0;
+		const int32 PageSize = Limit ? FMath::Max(FCString::Atoi(**Limit), 1) : DefaultPageSize;
+		TArray<TSharedPtr<FJsonValue>> Values;
+		for(const TPair<int32, FGitLfsLock>& Pair : Locks)
+		{
+			if(Pair.Key < FirstId || (PathFilter && Pair.Value.Path != FGenericPlatformHttp::UrlDecode(*PathFilter)))
+			{
+				continue;
+			}
+			if(Values.Num() == PageSize)
+			{
+				Response->SetStringField(TEXT("next_cursor"), Pair.Value.Id);
+				break;
+			}
+			Values.Add(MakeShared<FJsonValueObject>(MakeLockObject(Pair.Value)));
+		}
+		Response->SetArrayField(TEXT("locks"), Values);
+		InRespond(200, Response);
+	}
+	else if(Path.IsEmpty() && !bGet)
+	{
+		// Create, or 409 Conflict with the existing lock
+		const FString LockPath = Body->GetStringField(TEXT("path"));
+		for(const TPair<int32, FGitLfsLock>& Pair : Locks)
+		{
+			if(Pair.Value.Path == LockPath)
+			{
+				Response->SetObjectField(TEXT("lock"), MakeLockObject(Pair.Value));
+				Response->SetStringField(TEXT("message"), TEXT("already created lock"));
+				InRespond(409, Response);
+				return true;
+			}
+		}
+		FGitLfsLock& Lock = Locks.Add(NextId);
+		Lock.Id = FString::FromInt(NextId++);
+		Lock.Path = LockPath;
+		Lock.Owner = UserName;
+		Response->SetObjectField(TEXT("lock"), MakeLockObject(Lock));
+		InRespond(201, Response);
+	}
+	else if(Path == TEXT("verify") && !bGet)
+	{
+		// Ours and theirs, all in one page
+		TArray<TSharedPtr<FJsonValue>> Ours;
+		TArray<TSharedPtr<FJsonValue>> Theirs;
+		for(const TPair<int32, FGitLfsLock>& Pair : Locks)
+		{
+			(Pair.Value.Owner == UserName ? Ours : Theirs).Add(MakeShared<FJsonValueObject>(MakeLockObject(Pair.Value)));
+		}
+		Response->SetArrayField(TEXT("ours"), Ours);
+		Response->SetArrayField(TEXT("theirs"), Theirs);
+		InRespond(200, Response);
+	}
+	else if(Path.EndsWith(TEXT("/unlock")) && !bGet)
+	{
+		// Delete, only the locks of the user unless forced
+		const int32 Id = FCString::Atoi(*Path.LeftChop(7));
+		const FGitLfsLock* Lock = Locks.Find(Id);
+		if(Lock == nullptr)
+		{
+			Response->SetStringField(TEXT("message"), TEXT("unable to find lock"));
+			InRespond(404, Response);
+		}
+		else if(Lock->Owner != UserName && !Body->GetBoolField(TEXT("force")))
+		{
+			Response->SetStringField(TEXT("message"), TEXT("lock owned by another user"));
+			InRespond(403, Response);
+		}
+		else
+		{
+			Response->SetObjectField(TEXT("lock"), MakeLockObject(*Lock));
+			Locks.Remove(Id);
+			InRespond(200, Response);
+		}
+	}
+	else
+	{
+		Response->SetStringField(TEXT("message"), TEXT("not found"));
+		InRespond(404, Response);
+	}
+	return true;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "HttpRouteHandle.h"
+#include "GitSourceControlLfsLocksClient.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+
+/**
+ * Minimal in-memory server of the Git LFS File Locking API, listening on localhost,
+ * to check the client of the locking API without a real LFS server ("Git.Benchmark.LfsLocks stub").
+ *
+ * Serves "GET /locks" (with "path", "cursor" and "limit"), "POST /locks", "POST /locks/verify" and "POST /locks/:id/unlock",
+ * the locks being owned by the given user unless added with another owner by AddLock().
+ * The HTTP server module ticks its listeners on the game thread: the client must be driven from another thread.
+ */
+class FGitLfsLocksStubServer
+{
+public:
+	FGitLfsLocksStubServer(const uint32 InPort, const FString& InUserName);
+	~FGitLfsLocksStubServer();
+
+	/** Bind the routes and start listening */
+	bool Start();
+
+	/** Unbind the routes (the listeners of the HTTP server module are shared, and left running) */
+	void Stop();
+
+	/** URL of the LFS server, the locks being at Url + "/locks" */
+	FString GetUrl() const;
+
+	/** Add a lock, as if it was created by the given user */
+	void AddLock(const FString& InPath, const FString& InOwner);
+
+	/** Number of locks held */
+	int32 GetNumLocks() const;
+
+	/** Number of requests served since the start */
+	int32 GetNumRequests() const
+	{
+		return NumRequests;
+	}
+
+private:
+	/** Answer a request of the locking API, the path being relative to "/lfs/locks" */
+	bool HandleRequest(const FHttpServerRequest& InRequest, TFunction<void(const int32 InCode, const TSharedRef<FJsonObject>& InBody)> InRespond);
+
+	/** Serialize a lock like the API does */
+	TSharedRef<FJsonObject> MakeLockObject(const FGitLfsLock& InLock) const;
+
+	uint32 Port;
+	FString UserName;
+
+	TSharedPtr<IHttpRouter> Router;
+	FHttpRouteHandle RouteHandle;
+
+	/** Locks by identifier, sorted by identifier for the pages of the list */
+	TSortedMap<int32, FGitLfsLock> Locks;
+	int32 NextId = 1;
+	int32 NumRequests = 0;
+
+	/** Guards the locks, added from the game thread and served by the listeners */
+	mutable FCriticalSection CriticalSection;
+};
@@ -0,0 +1,463 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlLockTable.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Templates/UniquePtr.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlFileExistenceCache.h"
+#include "GitSourceControlProvider.h"
+#include "GitSourceControlUtils.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lock table contended accesses"), STAT_GitLockTableContentions, STATGROUP_GitSourceControl);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Lock table wait time (ms)"), STAT_GitLockTableWaitTime, STATGROUP_GitSourceControl);
+
+namespace GitLockTableConstants
+{
+
+/** "GSCL" */
+static const uint32 Magic = 0x4C435347;
+
+/** Version of the format, to be incremented on each change of the layout below */
+static const uint32 Version = 1;
+
+/** Size of the header: magic and version */
+static const int64 HeaderSize = 4 + 4;
+
+/** Size of the header of a record: size and CRC of its payload */
+static const int64 RecordHeaderSize = 4 + 4;
+
+/** Wait for the lock of the table above which an access counts as contended */
+static const double ContentionThresholdMs = 0.1;
+
+/** Operation of a record */
+static const uint8 OpUnlock = 0;
+static const uint8 OpLock = 1;
+
+/** Compact the table file once it has more records than this, and more than twice the number of locks */
+static const int32 MinRecordsToCompact = 256;
+
+}
+
+/** Scope lock of the table, measuring the time spent waiting for the other threads */
+class FGitLockTableScopeLock
+{
+public:
+	FGitLockTableScopeLock(FRWLock& InLock, const FRWScopeLockType InLockType)
+		: Lock(InLock)
+		, LockType(InLockType)
+	{
+		const uint32 StartCycles = FPlatformTime::Cycles();
+		if(LockType == SLT_ReadOnly)
+		{
+			Lock.ReadLock();
+		}
+		else
+		{
+			Lock.WriteLock();
+		}
+		const double WaitMs = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles);
+		if(WaitMs > GitLockTableConstants::ContentionThresholdMs)
+		{
+			INC_DWORD_STAT(STAT_GitLockTableContentions);
+			INC_FLOAT_STAT_BY(STAT_GitLockTableWaitTime, WaitMs);
+		}
+	}
+
+	~FGitLockTableScopeLock()
+	{
+		if(LockType == SLT_ReadOnly)
+		{
+			Lock.ReadUnlock();
+		}
+		else
+		{
+			Lock.WriteUnlock();
+		}
+	}
+
+private:
+	FRWLock& Lock;
+	const FRWScopeLockType LockType;
+};
+
+/**
+ * Layout of the table file (little-endian):
+ * - header: magic and version,
+ * - records appended one after the other: payload size and CRC32, then the payload:
+ *   operation (lock or unlock), path relative to the project directory, and owner of the lock (for a lock).
+ * A record truncated or corrupted (crash while appending) ends the table: the file is compacted right after loading it.
+ */
+FGitLockTable& FGitLockTable::Get()
+{
+	static FGitLockTable Instance;
+	return Instance;
+}
+
+FString FGitLockTable::GetTableFile()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir()) / TEXT("GitSourceControl") / TEXT("Locks.bin");
+}
+
+FString FGitLockTable::ToStoredPath(const FString& InFilename)
+{
+	const FString ProjectDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
+	return InFilename.StartsWith(ProjectDir) ? InFilename.RightChop(ProjectDir.Len()) : InFilename;
+}
+
+FString FGitLockTable::FromStoredPath(const FString& InStoredPath)
+{
+	return FPaths::IsRelative(InStoredPath) ? FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), InStoredPath) : InStoredPath;
+}
+
+bool FGitLockTable::Find(const FString& InFilename, FString& OutUser)
+{
+	EnsureLoaded();
+
+	FGitLockTableScopeLock ReadLock(TableLock, SLT_ReadOnly);
+	if(const FString* User = Locks.Find(InFilename))
+	{
+		OutUser = *User;
+		return true;
+	}
+	return false;
+}
+
+void FGitLockTable::GetAllLocks(const bool bAbsolutePaths, TMap<FString, FString>& OutLocks)
+{
+	EnsureLoaded();
+
+	// Roots of the repository and of its submodules, the longest first, to make the files relative to the repository they belong to
+	TArray<FString> RepositoryRoots;
+	if(!bAbsolutePaths)
+	{
+		const FString ProjectDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
+		TArray<FString> SubModules;
+		GitSourceControlUtils::GetSubModulesRoots(SubModules);
+		for(const FString& SubModule : SubModules)
+		{
+			RepositoryRoots.Add(ProjectDir / SubModule + TEXT("/"));
+		}
+		RepositoryRoots.Sort([](const FString& InA, const FString& InB) { return InA.Len() > InB.Len(); });
+		RepositoryRoots.Add(ProjectDir);
+	}
+
+	FGitLockTableScopeLock ReadLock(TableLock, SLT_ReadOnly);
+	OutLocks.Reserve(OutLocks.Num() + Locks.Num());
+	for(const auto& Lock : Locks)
+	{
+		if(bAbsolutePaths)
+		{
+			OutLocks.Add(Lock.Key, Lock.Value);
+			continue;
+		}
+		const FString* RepositoryRoot = RepositoryRoots.FindByPredicate([&Lock](const FString& InRoot) { return Lock.Key.StartsWith(InRoot); });
+		OutLocks.Add((RepositoryRoot != nullptr) ? Lock.Key.RightChop(RepositoryRoot->Len()) : Lock.Key, Lock.Value);
+	}
+}
+
+bool FGitLockTable::Lock(const FString& InRepositoryRoot, const TArray<FString>& InFiles, const FString& InUser)
+{
+	EnsureLoaded();
+
+	TArray<FString> Filenames;
+	for(const FString& File : InFiles)
+	{
+		Filenames.Add(FPaths::ConvertRelativePathToFull(InRepositoryRoot, File));
+	}
+
+	FGitLockTableScopeLock WriteLock(TableLock, SLT_Write);
+	for(const FString& Filename : Filenames)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Lock table: %s locked by %s"), *Filename, *InUser);
+		Locks.Add(Filename, InUser);
+	}
+	return Append(Filenames, &InUser);
+}
+
+bool FGitLockTable::Unlock(const FString& InRepositoryRoot, const TArray<FString>& InFiles)
+{
+	EnsureLoaded();
+
+	TArray<FString> Filenames;
+	for(const FString& File : InFiles)
+	{
+		Filenames.Add(FPaths::ConvertRelativePathToFull(InRepositoryRoot, File));
+	}
+
+	FGitLockTableScopeLock WriteLock(TableLock, SLT_Write);
+	for(const FString& Filename : Filenames)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Lock table: %s unlocked"), *Filename);
+		Locks.Remove(Filename);
+	}
+	return Append(Filenames, nullptr);
+}
+
+bool FGitLockTable::Reset(const TMap<FString, FString>& InLocks, TArray<FString>& OutChangedFiles)
+{
+	EnsureLoaded();
+
+	FGitLockTableScopeLock WriteLock(TableLock, SLT_Write);
+	for(const auto& Lock : InLocks)
+	{
+		const FString* User = Locks.Find(Lock.Key);
+		if(User == nullptr || *User != Lock.Value)
+		{
+			OutChangedFiles.Add(Lock.Key);
+		}
+	}
+	for(const auto& Lock : Locks)
+	{
+		if(!InLocks.Contains(Lock.Key))
+		{
+			OutChangedFiles.Add(Lock.Key);
+		}
+	}
+	if(OutChangedFiles.Num() == 0)
+	{
+		return true;
+	}
+
+	Locks = InLocks;
+	return Compact();
+}
+
+void FGitLockTable::EnsureLoaded()
+{
+	if(bLoaded)
+	{
+		return;
+	}
+
+	FGitLockTableScopeLock WriteLock(TableLock, SLT_Write);
+	if(!bLoaded)
+	{
+		if(!Load())
+		{
+			ImportLegacyCache();
+			Compact();
+		}
+		bLoaded = true;
+	}
+}
+
+bool FGitLockTable::Load()
+{
+	const FString TableFile = GetTableFile();
+	if(!FPaths::FileExists(TableFile))
+	{
+		return false;
+	}
+
+	bool bParsed = false;
+	bool bTruncated = false;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*TableFile));
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	if(MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+	if(MappedRegion.IsValid())
+	{
+		bParsed = Parse(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), bTruncated);
+	}
+	else
+	{
+		// Platforms without memory-mapped files
+		TArray<uint8> Content;
+		if(FFileHelper::LoadFileToArray(Content, *TableFile, FILEREAD_Silent))
+		{
+			bParsed = Parse(Content.GetData(), Content.Num(), bTruncated);
+		}
+	}
+	MappedRegion.Reset();
+	MappedFile.Reset();
+
+	if(bParsed && bTruncated)
+	{
+		// Never append after a partial record
+		UE_LOG(LogSourceControl, Warning, TEXT("Lock table '%s' truncated: compacted"), *TableFile);
+		Compact();
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("Lock table: %d locks loaded from %d records"), Locks.Num(), NumRecords);
+	return bParsed;
+}
+
+bool FGitLockTable::Parse(const uint8* InData, const int64 InSize, bool& bOutTruncated)
+{
+	using namespace GitLockTableConstants;
+
+	if(InSize < HeaderSize)
+	{
+		return false;
+	}
+	FLargeMemoryReader HeaderReader(InData, HeaderSize);
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	HeaderReader << FileMagic << FileVersion;
+	if(FileMagic != Magic || FileVersion != Version)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Lock table ignored: version %u not supported"), FileVersion);
+		return false;
+	}
+
+	Locks.Reset();
+	NumRecords = 0;
+	int64 Offset = HeaderSize;
+	while(Offset < InSize)
+	{
+		if(Offset + RecordHeaderSize > InSize)
+		{
+			bOutTruncated = true;
+			break;
+		}
+		FLargeMemoryReader RecordHeaderReader(InData + Offset, RecordHeaderSize);
+		uint32 PayloadSize = 0;
+		uint32 PayloadCrc = 0;
+		RecordHeaderReader << PayloadSize << PayloadCrc;
+		const uint8* Payload = InData + Offset + RecordHeaderSize;
+		if(Offset + RecordHeaderSize + PayloadSize > InSize || FCrc::MemCrc32(Payload, PayloadSize) != PayloadCrc)
+		{
+			bOutTruncated = true;
+			break;
+		}
+
+		FLargeMemoryReader Reader(Payload, PayloadSize);
+		uint8 Op = OpUnlock;
+		FString StoredPath;
+		FString User;
+		Reader << Op << StoredPath;
+		if(Op == OpLock)
+		{
+			Reader << User;
+		}
+		if(Reader.IsError())
+		{
+			bOutTruncated = true;
+			break;
+		}
+		if(Op == OpLock)
+		{
+			Locks.Add(FromStoredPath(StoredPath), MoveTemp(User));
+		}
+		else
+		{
+			Locks.Remove(FromStoredPath(StoredPath));
+		}
+		++NumRecords;
+		Offset += RecordHeaderSize + PayloadSize;
+	}
+	return true;
+}
+
+void FGitLockTable::ImportLegacyCache()
+{
+	const FString LegacyFile = FPaths::ProjectDir() / TEXT("locks_cache");
+	TArray<FString> Lines;
+	if(!FFileHelper::LoadFileToStringArray(Lines, *LegacyFile))
+	{
+		return;
+	}
+
+	// "user@path", the path being relative to the root of the repository or of the submodule of the file
+	FGitFileExistenceCache ExistenceCache;
+	for(const FString& Line : Lines)
+	{
+		FString User, RelativePath;
+		if(Line.Split(TEXT("@"), &User, &RelativePath))
+		{
+			FString RepositoryRoot = FPaths::ProjectDir();
+			GitSourceControlUtils::FindRepoRoot(RelativePath, RepositoryRoot, ExistenceCache);
+			Locks.Add(FPaths::ConvertRelativePathToFull(RepositoryRoot, RelativePath), MoveTemp(User));
+		}
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("Lock table: %d locks imported from '%s'"), Locks.Num(), *LegacyFile);
+}
+
+/** Serialize one record: header and payload */
+static void WriteRecord(FArchive& InOutWriter, uint8 InOp, FString InStoredPath, const FString* InUser)
+{
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+	PayloadWriter << InOp << InStoredPath;
+	if(InUser != nullptr)
+	{
+		FString User = *InUser;
+		PayloadWriter << User;
+	}
+	uint32 PayloadSize = Payload.Num();
+	uint32 PayloadCrc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+	InOutWriter << PayloadSize << PayloadCrc;
+	InOutWriter.Serialize(Payload.GetData(), Payload.Num());
+}
+
+bool FGitLockTable::Append(const TArray<FString>& InFilenames, const FString* InUser)
+{
+	using namespace GitLockTableConstants;
+
+	if(InFilenames.Num() == 0)
+	{
+		return true;
+	}
+
+	TArray<uint8> Records;
+	FMemoryWriter Writer(Records);
+	for(const FString& Filename : InFilenames)
+	{
+		WriteRecord(Writer, (InUser != nullptr) ? OpLock : OpUnlock, ToStoredPath(Filename), InUser);
+	}
+
+	// Only the new records are written, at the end of the file
+	TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*GetTableFile(), FILEWRITE_Append | FILEWRITE_Silent));
+	if(!FileWriter.IsValid())
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("Cannot append to the lock table '%s'"), *GetTableFile());
+		return false;
+	}
+	FileWriter->Serialize(Records.GetData(), Records.Num());
+	const bool bWritten = FileWriter->Close();
+	NumRecords += InFilenames.Num();
+
+	if(NumRecords > MinRecordsToCompact && NumRecords > 2 * Locks.Num())
+	{
+		return Compact();
+	}
+	return bWritten;
+}
+
+bool FGitLockTable::Compact()
+{
+	using namespace GitLockTableConstants;
+
+	TArray<uint8> Content;
+	FMemoryWriter Writer(Content);
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	Writer << FileMagic << FileVersion;
+	for(const auto& Lock : Locks)
+	{
+		WriteRecord(Writer, OpLock, ToStoredPath(Lock.Key), &Lock.Value);
+	}
+
+	const FString TableFile = GetTableFile();
+	if(!FFileHelper::SaveArrayToFile(Content, *TableFile))
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("Cannot write the lock table '%s'"), *TableFile);
+		return false;
+	}
+	NumRecords = Locks.Num();
+	return true;
+}
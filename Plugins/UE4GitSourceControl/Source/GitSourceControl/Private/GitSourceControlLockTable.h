@@ -0,0 +1,82 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/ScopeRWLock.h"
+
+/**
+ * Local table of the Git LFS locks (file and owner), shared by the workers and the locks worker thread,
+ * replacing the "locks_cache" text file that was loaded and written back in full for each lock and unlock.
+ *
+ * The table is a versioned binary file in Saved/, memory-mapped once at the first use and indexed in memory
+ * by absolute filename, so that the lock of a file is a hash lookup, without reading the file again.
+ * Each lock and unlock appends one record to the file, and the file is compacted (rewritten with only the current locks)
+ * once it has a lot more records than locks. The old "locks_cache" is imported the first time.
+ */
+class FGitLockTable
+{
+public:
+	static FGitLockTable& Get();
+
+	/** Get the owner of the lock of a file (absolute path), if locked */
+	bool Find(const FString& InFilename, FString& OutUser);
+
+	/** Get all the locks (file and owner), with absolute paths or relative to the root of the repository or submodule of each file */
+	void GetAllLocks(const bool bAbsolutePaths, TMap<FString, FString>& OutLocks);
+
+	/** Record the locks of files (relative to a repository root) by a user, appending them to the table file */
+	bool Lock(const FString& InRepositoryRoot, const TArray<FString>& InFiles, const FString& InUser);
+
+	/** Record the unlocks of files (relative to a repository root), appending them to the table file */
+	bool Unlock(const FString& InRepositoryRoot, const TArray<FString>& InFiles);
+
+	/**
+	 * Replace all the locks by the locks of the server (absolute paths), and rewrite the table file
+	 * @param	OutChangedFiles		Files locked, unlocked, or locked by another user since the last update
+	 */
+	bool Reset(const TMap<FString, FString>& InLocks, TArray<FString>& OutChangedFiles);
+
+	/** Path of the table file of the project */
+	static FString GetTableFile();
+
+private:
+	FGitLockTable() = default;
+
+	/** Load the table file at the first use, or import the "locks_cache" file if there is no table yet */
+	void EnsureLoaded();
+
+	/** Memory-map the table file and replay its records (under the write lock) */
+	bool Load();
+
+	/** Import the locks of the old "locks_cache" text file (under the write lock) */
+	void ImportLegacyCache();
+
+	/** Replay the records of the table file, until the end or the first truncated or corrupted record */
+	bool Parse(const uint8* InData, const int64 InSize, bool& bOutTruncated);
+
+	/** Append records of locks (with their owner) or unlocks to the table file, and compact it if needed (under the write lock) */
+	bool Append(const TArray<FString>& InFilenames, const FString* InUser);
+
+	/** Rewrite the table file with one record per lock (under the write lock) */
+	bool Compact();
+
+	/** Path stored in the table file: relative to the project directory if inside of it, else absolute */
+	static FString ToStoredPath(const FString& InFilename);
+	static FString FromStoredPath(const FString& InStoredPath);
+
+	/** Guards the locks and the table file */
+	FRWLock TableLock;
+
+	FThreadSafeBool bLoaded = false;
+
+	/** Owner of the lock of each file, by absolute filename */
+	TMap<FString, FString> Locks;
+
+	/** Number of records in the table file, to know when to compact it */
+	int32 NumRecords = 0;
+};
@@ -1,18 +1,53 @@
 
 #include "GitSourceControlLocksWorker.h"
 
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformTLS.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlState.h"
+#include "GitSourceControlFileExistenceCache.h"
+#include "GitSourceControlLfsLocksClient.h"
 //#include "GitSourceControlMenu.h"
 //#include "Misc/MessageDialog.h"
 #include "Engine/Engine.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lock commands queued"), STAT_GitLockCommandsQueued, STATGROUP_GitSourceControl);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lock commands waiting for the queue"), STAT_GitLockCommandsBlocked, STATGROUP_GitSourceControl);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Lock commands wait time (ms)"), STAT_GitLockCommandsWaitTime, STATGROUP_GitSourceControl);
 
-FGitSourceControlLocksWorker* FGitSourceControlLocksWorker::Runnable = NULL;
+TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> FGitSourceControlLocksWorker::Runnable;
+bool FGitSourceControlLocksWorker::bShutdown = false;
+
+static TAutoConsoleVariable<float> CVarGitLocksRefreshInterval(
+	TEXT("Git.LocksRefreshInterval"),
+	9.0f,
+	TEXT("Interval in seconds between two refreshes of the Git LFS locks from the server, and of the files modified on disk, by the locks worker thread."));
+
+static TAutoConsoleVariable<float> CVarGitLocksRefreshJitter(
+	TEXT("Git.LocksRefreshJitter"),
+	0.2f,
+	TEXT("Random variation of the interval between two refreshes of the locks, as a fraction of the interval (0 to 1)."));
+
+static TAutoConsoleVariable<float> CVarGitLocksRefreshMaxBackoff(
+	TEXT("Git.LocksRefreshMaxBackoff"),
+	300.0f,
+	TEXT("Maximum interval in seconds between two refreshes of the locks while the Git LFS server is unreachable (the interval doubles after each failure)."));
+
+/** Minimum interval in seconds between two refreshes of the locks requested by the status updates */
+static const double MinRequestedRefreshSpacing = 2.0;
+
+/** Guards the creation and the destruction of the thread, by the first worker to push a command, and the reads of Runnable */
+static FCriticalSection RunnableCriticalSection;
 
 FGitSourceControlLocksWorker::FGitSourceControlLocksWorker()
 {
+	QueueNotFullEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	RandomStream.Initialize((int32)FPlatformTime::Cycles());
+	FGitLfsLocksClient::Get().Resume();
 	Thread = FRunnableThread::Create(this, TEXT("LocksWorker"), 0, TPri_BelowNormal);
 
 	//GitSourceControlUtils::GetSelfLocksFile(SelfLockedFile);
@@ -37,6 +72,10 @@ FGitSourceControlLocksWorker::~FGitSourceControlLocksWorker()
 {
 	delete Thread;
 	Thread = NULL;
+	FPlatformProcess::ReturnSynchEventToPool(QueueNotFullEvent);
+	QueueNotFullEvent = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	WakeUpEvent = nullptr;
 }
 
 bool FGitSourceControlLocksWorker::Init()
@@ -47,86 +86,207 @@ bool FGitSourceControlLocksWorker::Init()
 
 uint32 FGitSourceControlLocksWorker::Run()
 {
-	FPlatformProcess::Sleep(0.03);
-
 	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 
+	double LastRefreshTime = 0.0;
+	double NextRefreshTime = FPlatformTime::Seconds() + GetRefreshDelay(CVarGitLocksRefreshInterval.GetValueOnAnyThread());
 	while (StopTaskCounter.GetValue() == 0)
 	{
-		//UE_LOG(LogSourceControl, Error, TEXT("command queue size: %d"), CommandQueue.size());
-		if (!CommandQueue.empty()) 
+		RunQueuedCommands();
+
+		if (bPullRequested.AtomicSet(false))
 		{
-			COMMAND command = CommandQueue.front();
-			CommandQueue.pop();
-			TArray<FString> Results;
-			TArray<FString> ErrorMessage;
-			UE_LOG(LogSourceControl, Warning, TEXT("lock operation: %s"), *command.Command);
-			GitSourceControlUtils::RunCommand(command.Command, command.PathToGitBinary, command.RepositoryRoot, command.Parameters, command.Files, Results, ErrorMessage);
+			PullAndUpdateSubmodules();
+		}
+
+		// Coalesce the requests of refresh, and ignore them while the server is unreachable
+		if (bRefreshRequested.AtomicSet(false) && RefreshBackoffSeconds == 0.0)
+		{
+			NextRefreshTime = FMath::Min(NextRefreshTime, LastRefreshTime + MinRequestedRefreshSpacing);
 		}
-		else if(CurIteration == 0)
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now >= NextRefreshTime)
 		{
-			CurIteration = (CurIteration + 1) % MaxIteration;
-			TArray<FString> ChangedFiles;
-			const bool changed = GitSourceControlUtils::UpdateLockCaches(ChangedFiles, PathToGitBinary, PathToRepositoryRoot, LfsUserName);
-			if (changed) {
-				//PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
-				//PathToRepositoryRoot = GitSourceControl.AccessSettings().GetRepositoryRootPath();
-				TArray<FGitSourceControlState> States;
-				for (const auto& File : ChangedFiles) {
-					TArray<FString> OneFile;
-					TArray<FString> ErrorMessage;
-					OneFile.Add(File);
-					FString RepoRoot = PathToRepositoryRoot;
-					GitSourceControlUtils::FindRepoRoot(File, RepoRoot);
-					GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, RepoRoot, true, OneFile, ErrorMessage, States);
-					GitSourceControlUtils::UpdateCachedStates(States);
+			LastRefreshTime = Now;
+			const float RefreshInterval = CVarGitLocksRefreshInterval.GetValueOnAnyThread();
+			if (RefreshLocks())
+			{
+				RefreshBackoffSeconds = 0.0;
+				NextRefreshTime = Now + GetRefreshDelay(RefreshInterval);
+			}
+			else
+			{
+				RefreshBackoffSeconds = FMath::Min((RefreshBackoffSeconds == 0.0) ? RefreshInterval : RefreshBackoffSeconds * 2.0, (double)CVarGitLocksRefreshMaxBackoff.GetValueOnAnyThread());
+				NextRefreshTime = Now + GetRefreshDelay(RefreshBackoffSeconds);
+				UE_LOG(LogSourceControl, Warning, TEXT("Cannot get the locks from the LFS server: next try in %.0lfs"), NextRefreshTime - Now);
+			}
+			UpdateModifiedFiles();
+			continue;
+		}
+
+		// Sleep until the next refresh, unless woken up by a command or a request
+		const uint32 WaitMs = (uint32)FMath::CeilToInt((NextRefreshTime - Now) * 1000.0);
+		WakeUpEvent->Wait(WaitMs);
+	}
+	UE_LOG(LogSourceControl, Warning, TEXT("Run finished"));
+	return 0;
+}
+
+double FGitSourceControlLocksWorker::GetRefreshDelay(const double InDelay)
+{
+	// Jitter, so that the editors of a team do not query the LFS server all at the same time
+	const double Jitter = FMath::Clamp(CVarGitLocksRefreshJitter.GetValueOnAnyThread(), 0.0f, 1.0f);
+	return InDelay * (1.0 + RandomStream.FRandRange(-Jitter, Jitter));
+}
+
+void FGitSourceControlLocksWorker::RunQueuedCommands()
+{
+	COMMAND command;
+	while (StopTaskCounter.GetValue() == 0 && CommandQueue.Dequeue(command))
+	{
+		SET_DWORD_STAT(STAT_GitLockCommandsQueued, NumQueuedCommands.Decrement());
+		QueueNotFullEvent->Trigger();
+		TArray<FString> Results;
+		TArray<FString> ErrorMessage;
+		UE_LOG(LogSourceControl, Warning, TEXT("lock operation: %s (%d files)"), *command.Command, command.Files.Num());
+		if (command.Command == TEXT("lfs lock") || command.Command == TEXT("lfs unlock"))
+		{
+			TArray<FString> FailedFiles;
+			if (!GitSourceControlUtils::RunLfsLockCommand(command.Command, command.PathToGitBinary, command.RepositoryRoot, command.Files, FailedFiles, ErrorMessage))
+			{
+				for (const auto& File : FailedFiles) {
+					UE_LOG(LogSourceControl, Warning, TEXT("%s failed: %s"), *command.Command, *File);
 				}
+				// The lock table recorded the files as locked: forget the locks that failed, and get the truth from the server
+				if (command.Command == TEXT("lfs lock"))
+				{
+					GitSourceControlUtils::CacheLockRemove(command.RepositoryRoot, FailedFiles);
+
+					// The next refresh would not see them change, as the lock table does not hold them anymore: update their cached status now
+					TArray<FString> AbsoluteFiles;
+					for (const auto& File : FailedFiles) {
+						AbsoluteFiles.Add(FPaths::ConvertRelativePathToFull(command.RepositoryRoot, File));
+					}
+					TArray<FGitSourceControlState> States;
+					TArray<FString> ErrorMessages;
+					if (GitSourceControlUtils::RunUpdateStatus(command.PathToGitBinary, command.RepositoryRoot, true, AbsoluteFiles, ErrorMessages, States)) {
+						GitSourceControlUtils::UpdateCachedStates(States);
+					}
+				}
+				bRefreshRequested = true;
 			}
 		}
-		else if (CurIteration == -1) {
-			CurIteration = (CurIteration + 1) % MaxIteration;
-			GEngine->AddOnScreenDebugMessage(-1, 8.f, FColor::Green, TEXT("Updating Submodules to the latest version!"));
-			
-			TArray<FString> Results;
-			TArray<FString> ErrorMessages;
-			TArray<FString> Parameters;
-			Parameters.Add(TEXT("--rebase"));
-			Parameters.Add(TEXT("--autostash"));
-			// TODO Configure origin
-			Parameters.Add(TEXT("origin"));
-			Parameters.Add(TEXT("HEAD"));
-			GitSourceControlUtils::RunCommand(TEXT("pull"), PathToGitBinary, PathToRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages);
-
-			TArray<FString> Parameters1;
-			Parameters1.Add("--recursive");
-			Parameters1.Add("--remote");
-			GitSourceControlUtils::RunCommand(TEXT("submodule update"), PathToGitBinary, PathToRepositoryRoot, Parameters1, TArray<FString>(), Results, ErrorMessages);
-
-			TArray<FString> AllProjects;
-			GitSourceControlUtils::GetSubModulesRoots(AllProjects);
-			AllProjects.Add(TEXT(""));
-			// now update the status of our files
-			TArray<FGitSourceControlState> States;
-			for (const auto& Sub : AllProjects) {
-				FString RepoRoot = PathToRepositoryRoot;
-				if (Sub != TEXT("")) RepoRoot += TEXT("/") + Sub;
-				TArray<FString> ProjectDirs;
-				ProjectDirs.Add(RepoRoot + TEXT("/"));
-				GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, RepoRoot, true, ProjectDirs, ErrorMessages, States);
+		else
+		{
+			GitSourceControlUtils::RunCommand(command.Command, command.PathToGitBinary, command.RepositoryRoot, command.Parameters, command.Files, Results, ErrorMessage);
+		}
+	}
+}
+
+bool FGitSourceControlLocksWorker::RefreshLocks()
+{
+	TArray<FString> ChangedFiles;
+	if (!GitSourceControlUtils::UpdateLockCaches(ChangedFiles, PathToGitBinary, PathToRepositoryRoot, LfsUserName))
+	{
+		return false;
+	}
+
+	// Update the status of the files locked or unlocked since the last refresh, with one status per repository
+	TMap<FString, TArray<FString>> FilesByRepoRoot;
+	FGitFileExistenceCache ExistenceCache;
+	for (const auto& File : ChangedFiles) {
+		FString RepoRoot = PathToRepositoryRoot;
+		GitSourceControlUtils::FindRepoRoot(File, RepoRoot, ExistenceCache);
+		FilesByRepoRoot.FindOrAdd(RepoRoot).Add(File);
+	}
+	for (const auto& Files : FilesByRepoRoot) {
+		TArray<FGitSourceControlState> States;
+		TArray<FString> ErrorMessages;
+		if (GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, Files.Key, true, Files.Value, ErrorMessages, States)) {
+			GitSourceControlUtils::UpdateCachedStates(States);
+		}
+	}
+	return true;
+}
+
+void FGitSourceControlLocksWorker::PullAndUpdateSubmodules()
+{
+	GEngine->AddOnScreenDebugMessage(-1, 8.f, FColor::Green, TEXT("Updating Submodules to the latest version!"));
+
+	TArray<FString> Results;
+	TArray<FString> ErrorMessages;
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("--rebase"));
+	Parameters.Add(TEXT("--autostash"));
+	// TODO Configure origin
+	Parameters.Add(TEXT("origin"));
+	Parameters.Add(TEXT("HEAD"));
+	GitSourceControlUtils::RunCommand(TEXT("pull"), PathToGitBinary, PathToRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages);
+
+	TArray<FString> Parameters1;
+	Parameters1.Add("--recursive");
+	Parameters1.Add("--remote");
+	GitSourceControlUtils::RunCommand(TEXT("submodule update"), PathToGitBinary, PathToRepositoryRoot, Parameters1, TArray<FString>(), Results, ErrorMessages);
+
+	TArray<FString> AllProjects;
+	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
+	AllProjects.Add(TEXT(""));
+	// now update the status of our files
+	TArray<FGitSourceControlState> States;
+	for (const auto& Sub : AllProjects) {
+		FString RepoRoot = PathToRepositoryRoot;
+		if (Sub != TEXT("")) RepoRoot += TEXT("/") + Sub;
+		TArray<FString> ProjectDirs;
+		ProjectDirs.Add(RepoRoot + TEXT("/"));
+		GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, RepoRoot, true, ProjectDirs, ErrorMessages, States);
+	}
+}
+
+void FGitSourceControlLocksWorker::UpdateModifiedFiles()
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FGitSourceControlChangeTracker& ChangeTracker = GitSourceControl.GetProvider().GetChangeTracker();
+
+	TArray<FString> ModifiedFiles;
+	ChangeTracker.GetModifiedFiles(MaxModifiedFiles, ModifiedFiles);
+	if (ModifiedFiles.Num() == 0) return;
+
+	const uint32 ChangeSequence = ChangeTracker.GetSequence();
+	UE_LOG(LogSourceControl, Log, TEXT("Updating the status of %d files modified on disk"), ModifiedFiles.Num());
+
+	// Submodules first, as their files are also under the root of the main repository
+	TArray<FString> AllProjects;
+	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
+	AllProjects.Add(TEXT(""));
+	for (const auto& Sub : AllProjects) {
+		FString RepoRoot = PathToRepositoryRoot;
+		if (Sub != TEXT("")) RepoRoot += TEXT("/") + Sub;
+		TArray<FString> Files;
+		for (int32 Index = ModifiedFiles.Num() - 1; Index >= 0; --Index) {
+			if (ModifiedFiles[Index].StartsWith(RepoRoot)) {
+				Files.Add(ModifiedFiles[Index]);
+				ModifiedFiles.RemoveAtSwap(Index);
 			}
 		}
-		else {
-			CurIteration = (CurIteration + 1) % MaxIteration;
-			FPlatformProcess::Sleep(0.03);
+		if (Files.Num() == 0) continue;
+
+		TArray<FGitSourceControlState> States;
+		TArray<FString> ErrorMessages;
+		if (GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, RepoRoot, true, Files, ErrorMessages, States)) {
+			GitSourceControlUtils::UpdateCachedStates(States);
+			ChangeTracker.MarkClean(Files, ChangeSequence);
 		}
 	}
-	UE_LOG(LogSourceControl, Warning, TEXT("Run finished"));
-	return 0;
 }
 
 void FGitSourceControlLocksWorker::Stop()
 {
 	StopTaskCounter.Increment();
+	WakeUpEvent->Trigger();
+	QueueNotFullEvent->Trigger();
+	// Do not wait for the responses of the LFS server to stop the thread
+	FGitLfsLocksClient::Get().Abort();
 }
 
 void FGitSourceControlLocksWorker::EnsureCompletion()
@@ -135,57 +295,71 @@ void FGitSourceControlLocksWorker::EnsureCompletion()
 	Thread->WaitForCompletion();
 }
 
-FGitSourceControlLocksWorker * FGitSourceControlLocksWorker::JoyInit()
+TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> FGitSourceControlLocksWorker::JoyInit()
 {
-	if (!Runnable && FPlatformProcess::SupportsMultithreading()) 
+	FScopeLock ScopeLock(&RunnableCriticalSection);
+	if (!Runnable.IsValid() && !bShutdown && FPlatformProcess::SupportsMultithreading()) 
 	{
 		UE_LOG(LogSourceControl, Warning, TEXT("lock worker joyinit"));
-		Runnable = new FGitSourceControlLocksWorker();
+		Runnable = MakeShareable(new FGitSourceControlLocksWorker());
 	}
 	return Runnable;
 }
 
 void FGitSourceControlLocksWorker::PushCommand(const FString & InCommand, const FString & InPathToGitBinary, const FString & InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles)
 {
-	COMMAND node(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles);
-	if(Runnable == NULL) JoyInit();
-	Runnable->CommandQueue.push(node);
+	// Keeps the worker alive until the command is queued, even if it shuts down meanwhile
+	const TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> Worker = JoyInit();
+	if (!Worker.IsValid()) return;
+
+	// Backpressure: wait (without spinning) for the thread to make room in the queue
+	if (Worker->NumQueuedCommands.GetValue() >= Worker->MaxQueuedCommands)
+	{
+		INC_DWORD_STAT(STAT_GitLockCommandsBlocked);
+		const uint32 StartCycles = FPlatformTime::Cycles();
+		while (Worker->NumQueuedCommands.GetValue() >= Worker->MaxQueuedCommands && Worker->StopTaskCounter.GetValue() == 0)
+		{
+			Worker->QueueNotFullEvent->Wait(10);
+		}
+		INC_FLOAT_STAT_BY(STAT_GitLockCommandsWaitTime, FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles));
+	}
+
+	SET_DWORD_STAT(STAT_GitLockCommandsQueued, Worker->NumQueuedCommands.Increment());
+	Worker->CommandQueue.Enqueue(COMMAND(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles));
+	Worker->WakeUpEvent->Trigger();
 }
 
 void FGitSourceControlLocksWorker::PushUpdates(const int32 OpCode)
 {
-	if (Runnable == NULL) JoyInit();
-	Runnable->CurIteration = OpCode;
+	const TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> Worker = JoyInit();
+	if (!Worker.IsValid()) return;
+
+	// The status updates of the locks thread itself must not request another refresh
+	if (Worker->Thread != NULL && FPlatformTLS::GetCurrentThreadId() == Worker->Thread->GetThreadID()) return;
+
+	if (OpCode == -1) Worker->bPullRequested = true;
+	else Worker->bRefreshRequested = true;
+	Worker->WakeUpEvent->Trigger();
 }
 
 void FGitSourceControlLocksWorker::Shutdown()
 {
-	if (Runnable)
+	TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> Worker;
+	{
+		FScopeLock ScopeLock(&RunnableCriticalSection);
+		bShutdown = true;
+		Worker = MoveTemp(Runnable);
+	}
+	// Outside of the lock, as the thread can push updates while it completes; deleted once the last producer lets it go
+	if (Worker.IsValid())
 	{
-		Runnable->EnsureCompletion();
-		delete Runnable;
-		Runnable = NULL;
+		Worker->EnsureCompletion();
 	}
 }
 
 bool FGitSourceControlLocksWorker::IsThreadFinished()
 {
-	if (Runnable) return Runnable->IsFinished();
+	FScopeLock ScopeLock(&RunnableCriticalSection);
+	if (Runnable.IsValid()) return Runnable->IsFinished();
 	return true;
 }
-
-bool FGitSourceControlLocksWorker::IsWrittingCache()
-{
-	if (Runnable != NULL) return Runnable->mutex;
-	else return false;
-}
-
-void FGitSourceControlLocksWorker::LockCache()
-{
-	if (Runnable != NULL) Runnable->mutex = true;
-}
-
-void FGitSourceControlLocksWorker::UnlockCache()
-{
-	if (Runnable != NULL) Runnable->mutex = false;
-}
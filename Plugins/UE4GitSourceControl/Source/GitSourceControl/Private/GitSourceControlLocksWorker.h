@@ -3,6 +3,9 @@
 #include "HAL/Runnable.h"
 #include "HAL/ThreadSafeCounter.h"
 #include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Containers/Queue.h"
 
 #include "CoreMinimal.h"
 
@@ -13,7 +16,6 @@
 #include "HAL/FileManager.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
-#include <queue>
 
 // tonyxia changed
 #include "GenericPlatform/GenericPlatformFile.h"
@@ -25,6 +27,7 @@ struct COMMAND
 	FString RepositoryRoot;
 	TArray<FString> Parameters;
 	TArray<FString> Files;
+	COMMAND() = default;
 	COMMAND(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles)
 		: Command(InCommand), PathToGitBinary(InPathToGitBinary), RepositoryRoot(InRepositoryRoot), Parameters(InParameters), Files(InFiles)
 	{
@@ -33,18 +36,46 @@ struct COMMAND
 
 class FGitSourceControlLocksWorker : public FRunnable 
 {
-	static FGitSourceControlLocksWorker* Runnable;
+	/** The worker, shared with the producers still pushing to it while it shuts down (guarded by RunnableCriticalSection) */
+	static TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> Runnable;
+
+	/** Set by Shutdown(), never reset: no worker is created anymore once the module shuts down (guarded by RunnableCriticalSection) */
+	static bool bShutdown;
 
 	FRunnableThread* Thread;
 
 	FThreadSafeCounter StopTaskCounter;
 
 private:
-	const int32 MaxDecayV = 2;
+	/** Maximum number of files modified on disk to refresh in one cycle */
+	const int32 MaxModifiedFiles = 1000;
+
+	/** Maximum number of lock commands waiting for the thread, before PushCommand() waits for room in the queue */
+	const int32 MaxQueuedCommands = 1024;
+
+	/** Lock commands pushed by the workers of the provider (multiple producers) and run by this thread (single consumer) */
+	TQueue<COMMAND, EQueueMode::Mpsc> CommandQueue;
+
+	/** Number of commands in the queue, to bound it */
+	FThreadSafeCounter NumQueuedCommands;
+
+	/** Triggered each time a command is taken out of the queue, to wake up the producers waiting for room */
+	FEvent* QueueNotFullEvent = nullptr;
+
+	/** Triggered by new commands, requests and Stop(), to wake up the thread sleeping until its next refresh */
+	FEvent* WakeUpEvent = nullptr;
+
+	/** Refresh of the locks requested by a status update (PushUpdates(0)) */
+	FThreadSafeBool bRefreshRequested;
+
+	/** Pull and update of the submodules requested (PushUpdates(-1)) */
+	FThreadSafeBool bPullRequested;
 
-	const int32 MaxIteration = 300;
-	int32 CurIteration = 1;
-	std::queue<COMMAND> CommandQueue;
+	/** Current interval between two tries while the LFS server is unreachable, 0 if it answered the last time */
+	double RefreshBackoffSeconds = 0.0;
+
+	/** Random jitter of the interval between two refreshes */
+	FRandomStream RandomStream;
 
 	/** Path to the Git binary */
 	FString PathToGitBinary;
@@ -54,8 +85,6 @@ private:
 
 	FString LfsUserName;
 
-	bool mutex = false;
-
 public:
 
 	bool IsFinished() const
@@ -72,14 +101,27 @@ public:
 
 	void EnsureCompletion();
 
-	static FGitSourceControlLocksWorker* JoyInit();
+	/** Run all the lock commands of the queue */
+	void RunQueuedCommands();
+
+	/** Replace the lock table by the locks of the server, and update the status of the files whose lock changed; false if the server did not answer */
+	bool RefreshLocks();
+
+	/** Pull, update the submodules, and update the status of all the files */
+	void PullAndUpdateSubmodules();
+
+	/** Delay until the next refresh, with a random jitter */
+	double GetRefreshDelay(const double InDelay);
+
+	/** Query the status of the files modified on disk since their last query, so that the next UpdateStatus serves them from the cache */
+	void UpdateModifiedFiles();
+
+	/** Get the worker, creating it the first time, or nullptr after Shutdown() */
+	static TSharedPtr<FGitSourceControlLocksWorker, ESPMode::ThreadSafe> JoyInit();
 
 	static void PushCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles);
+	/** Request a refresh of the locks (0), or a pull and update of the submodules (-1), waking up the thread */
 	static void PushUpdates(const int32 OpCode);
 	static void Shutdown();
 	static bool IsThreadFinished();
-
-	static bool IsWrittingCache();
-	static void LockCache();
-	static void UnlockCache();
 };
\ No newline at end of file
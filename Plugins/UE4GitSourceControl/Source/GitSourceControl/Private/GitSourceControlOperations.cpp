@@ -12,6 +12,7 @@
 #include "GitSourceControlModule.h"
 #include "GitSourceControlCommand.h"
 #include "GitSourceControlUtils.h"
+#include "GitSourceControlFileExistenceCache.h"
 #include "Logging/MessageLog.h"
 
 #include "GitSourceControlLocksWorker.h"
@@ -44,11 +45,32 @@ bool FGitConnectWorker::Execute(FGitSourceControlCommand& InCommand)
 	// Check Git Availability
 	if((InCommand.PathToGitBinary.Len() > 0) && GitSourceControlUtils::CheckGitAvailability(InCommand.PathToGitBinary))
 	{
+		FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+		if(GitSourceControl.AccessSettings().IsUsingStatusAcceleration())
+		{
+			// Speed up "git status" in the repository and each submodule before running the first one
+			const FGitVersion& GitVersion = GitSourceControl.GetProvider().GetGitVersion();
+			TArray<FString> SubModules;
+			GitSourceControlUtils::GetSubModulesRoots(SubModules);
+			GitSourceControlUtils::ConfigureStatusAcceleration(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, GitVersion);
+			for(const FString& SubModule : SubModules)
+			{
+				GitSourceControlUtils::ConfigureStatusAcceleration(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot / SubModule, GitVersion);
+			}
+		}
+
 		// Now update the status of assets in Content/ directory and also Config files
 		TArray<FString> ProjectDirs;
 		ProjectDirs.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()));
 		ProjectDirs.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectConfigDir()));
 		InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, ProjectDirs, InCommand.ErrorMessages, States);
+
+		// Reconcile the files loaded from the snapshot modified or locked: the status of directories does not list them anymore if reverted or unlocked since
+		const TArray<FString> FilesToReconcile = GitSourceControl.GetProvider().TakeFilesToReconcile();
+		if(InCommand.bCommandSuccessful && FilesToReconcile.Num() > 0)
+		{
+			InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToReconcile, InCommand.ErrorMessages, States);
+		}
 		if(!InCommand.bCommandSuccessful || InCommand.ErrorMessages.Num() > 0)
 		{
 			Operation->SetErrorText(LOCTEXT("NotAGitRepository", "Failed to enable Git source control. You need to initialize the project as a Git repository first."));
@@ -112,18 +134,10 @@ bool FGitCheckOutWorker::Execute(FGitSourceControlCommand& InCommand)
 	{
 		// lock files: execute the LFS command on relative filenames
 		const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(InCommand.Files, PathToRepositoryRoot);
-		for(const auto& File : RelativeFiles)
-		{
-			TArray<FString> OneFile;
-			OneFile.Add(File);
-			while (FGitSourceControlLocksWorker::IsWrittingCache()) {}
-			FGitSourceControlLocksWorker::LockCache();
-			GitSourceControlUtils::CacheLock(OneFile);
-			FGitSourceControlLocksWorker::UnlockCache();
-			//InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("lfs lock"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
-			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("checkout"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
-			FGitSourceControlLocksWorker::PushCommand(TEXT("lfs lock"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OneFile);
-		}
+		GitSourceControlUtils::CacheLock(PathToRepositoryRoot, RelativeFiles);
+		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("checkout"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), RelativeFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+		// all the files locked by one command of the locks worker thread
+		FGitSourceControlLocksWorker::PushCommand(TEXT("lfs lock"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), RelativeFiles);
 
 		// now update the status of our files
 		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
@@ -185,6 +199,7 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	TArray<FString> InFiles;
 	for (const auto& File : InCommand.Files) InFiles.Add(File);
 	for (const auto& Sub : AllProjects) {
@@ -194,7 +209,7 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 		for (const auto& File : InFiles) {
 			if (FPaths::IsRelative(File)) {
 				FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-				if (FPaths::FileExists(AbsFileName)) {
+				if (FileExistenceCache.FileExists(AbsFileName)) {
 					Files.Add(File);
 				}
 			}
@@ -316,21 +331,11 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 						// unlock files: execute the LFS command on relative filenames
 						// (unlock only locked files, that is, not Added files)
 						TArray<FString> LockedFiles = GetLockedFiles(Files);
-						if (LockedFiles.Num() >= 0)
+						if (LockedFiles.Num() > 0)
 						{
 							const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(LockedFiles, PathToRepositoryRoot);
-							for (const auto& RelativeFile : RelativeFiles)
-							{
-								TArray<FString> OneFile;
-								OneFile.Add(RelativeFile);
-
-								//GitSourceControlUtils::RunCommand(TEXT("lfs unlock"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
-								while (FGitSourceControlLocksWorker::IsWrittingCache()) {}
-								FGitSourceControlLocksWorker::LockCache();
-								GitSourceControlUtils::CacheLockRemove(OneFile);
-								FGitSourceControlLocksWorker::UnlockCache();
-								FGitSourceControlLocksWorker::PushCommand(TEXT("lfs unlock"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OneFile);
-							}
+							GitSourceControlUtils::CacheLockRemove(PathToRepositoryRoot, RelativeFiles);
+							FGitSourceControlLocksWorker::PushCommand(TEXT("lfs unlock"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), RelativeFiles);
 						}
 					}
 				}
@@ -361,6 +366,7 @@ bool FGitMarkForAddWorker::Execute(FGitSourceControlCommand& InCommand)
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	TArray<FString> InFiles;
 	for (const auto& File : InCommand.Files) InFiles.Add(File);
 	for (const auto& Sub : AllProjects) {
@@ -370,7 +376,7 @@ bool FGitMarkForAddWorker::Execute(FGitSourceControlCommand& InCommand)
 		for (const auto& File : InFiles) {
 			if (FPaths::IsRelative(File)) {
 				FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-				if (FPaths::FileExists(AbsFileName)) {
+				if (FileExistenceCache.FileExists(AbsFileName)) {
 					Files.Add(File);
 				}
 			}
@@ -384,7 +390,7 @@ bool FGitMarkForAddWorker::Execute(FGitSourceControlCommand& InCommand)
 			UE_LOG(LogSourceControl, Warning, TEXT("Adding file: %s at dir: %s"), *File, *PathToRepositoryRoot);
 			InFiles.RemoveSwap(File, true);
 		}
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("add"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommandWithPathspecs(TEXT("add"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, InCommand.InfoMessages, InCommand.ErrorMessages);
 
 		// now update the status of our files
 		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, Files, InCommand.ErrorMessages, States);
@@ -409,6 +415,7 @@ bool FGitDeleteWorker::Execute(FGitSourceControlCommand& InCommand)
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	TArray<FString> InFiles;
 	for (const auto& File : InCommand.Files) InFiles.Add(File);
 	for (const auto& Sub : AllProjects) {
@@ -418,7 +425,7 @@ bool FGitDeleteWorker::Execute(FGitSourceControlCommand& InCommand)
 		for (const auto& File : InFiles) {
 			if (FPaths::IsRelative(File)) {
 				FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-				if (FPaths::FileExists(AbsFileName)) {
+				if (FileExistenceCache.FileExists(AbsFileName)) {
 					Files.Add(File);
 				}
 			}
@@ -433,7 +440,7 @@ bool FGitDeleteWorker::Execute(FGitSourceControlCommand& InCommand)
 			InFiles.RemoveSwap(File, true);
 		}
 
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("rm"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommandWithPathspecs(TEXT("rm"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, InCommand.InfoMessages, InCommand.ErrorMessages);
 
 		// now update the status of our files
 		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, Files, InCommand.ErrorMessages, States);
@@ -457,9 +464,10 @@ void GetMissingVsExistingFiles(const TArray<FString>& InFiles, TArray<FString>&
 
 	TArray<TSharedRef<ISourceControlState, ESPMode::ThreadSafe>> LocalStates;
 	Provider.GetState(Files, LocalStates, EStateCacheUsage::Use);
+	FGitFileExistenceCache FileExistenceCache;
 	for(const auto& State : LocalStates)
 	{
-		if(FPaths::FileExists(State->GetFilename()))
+		if(FileExistenceCache.FileExists(State->GetFilename()))
 		{
 			if(State->IsAdded())
 			{
@@ -496,6 +504,7 @@ bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	TArray<FString> InFiles;
 	for (const auto& File : InCommand.Files) InFiles.Add(File);
 	for (const auto& Sub : AllProjects) {
@@ -505,7 +514,7 @@ bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 		for (const auto& File : InFiles) {
 			if (FPaths::IsRelative(File)) {
 				FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-				if (FPaths::FileExists(AbsFileName)) {
+				if (FileExistenceCache.FileExists(AbsFileName)) {
 					Files.Add(File);
 				}
 			}
@@ -531,17 +540,17 @@ bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 		if (MissingFiles.Num() > 0)
 		{
 			// "Added" files that have been deleted needs to be removed from source control
-			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("rm"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), MissingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommandWithPathspecs(TEXT("rm"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), MissingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
 		}
 		if (AllExistingFiles.Num() > 0)
 		{
 			// reset any changes already added to the index
-			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("reset"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), AllExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommandWithPathspecs(TEXT("reset"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), AllExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
 		}
 		if (OtherThanAddedExistingFiles.Num() > 0)
 		{
 			// revert any changes in working copy (this would fails if the asset was in "Added" state, since after "reset" it is now "untracked")
-			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("checkout"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OtherThanAddedExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommandWithPathspecs(TEXT("checkout"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), OtherThanAddedExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
 		}
 
 		//if (InCommand.bUsingGitLfsLocking)
@@ -737,9 +746,24 @@ bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	if (InCommand.Files.Num() > 0) {
+		TSharedRef<FUpdateStatus, ESPMode::ThreadSafe> Operation = StaticCastSharedRef<FUpdateStatus>(InCommand.Operation);
+		FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+		FGitSourceControlChangeTracker& ChangeTracker = GitSourceControl.GetProvider().GetChangeTracker();
+		const uint32 ChangeSequence = ChangeTracker.GetSequence();
+
 		TArray<FString> InFiles;
-		for (const auto& File : InCommand.Files) InFiles.Add(File);
+		if (Operation->ShouldUpdateHistory()) {
+			InFiles = InCommand.Files;
+		}
+		else {
+			// Only query the status of the files modified since their last query: the others are served from the state cache
+			TArray<FString> CleanFiles;
+			ChangeTracker.SplitDirtyFiles(InCommand.Files, InFiles, CleanFiles);
+			UE_LOG(LogSourceControl, Log, TEXT("UpdateStatus: %d modified files to query, %d unchanged files served from the cache"), InFiles.Num(), CleanFiles.Num());
+		}
+		InCommand.bCommandSuccessful = true;
 		for (const auto& Sub : AllProjects) {
 			FString PathToRepositoryRoot = InCommand.PathToRepositoryRoot;
 			if (Sub != TEXT("")) PathToRepositoryRoot += TEXT("/") + Sub;
@@ -747,7 +771,7 @@ bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 			for (const auto& File : InFiles) {
 				if (FPaths::IsRelative(File)) {
 					FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-					if (FPaths::FileExists(AbsFileName)) {
+					if (FileExistenceCache.FileExists(AbsFileName)) {
 						Files.Add(File);
 					}
 				}
@@ -762,8 +786,11 @@ bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 				InFiles.RemoveSwap(File, true);
 			}
 
-			TSharedRef<FUpdateStatus, ESPMode::ThreadSafe> Operation = StaticCastSharedRef<FUpdateStatus>(InCommand.Operation);
-			InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, Files, InCommand.ErrorMessages, States);
+			const bool bStatusSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, Files, InCommand.ErrorMessages, States);
+			if (bStatusSuccessful) {
+				ChangeTracker.MarkClean(Files, ChangeSequence);
+			}
+			InCommand.bCommandSuccessful &= bStatusSuccessful;
 			GitSourceControlUtils::RemoveRedundantErrors(InCommand, TEXT("' is outside repository"));
 
 			if (Operation->ShouldUpdateHistory())
@@ -803,23 +830,36 @@ bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 
 bool FGitUpdateStatusWorker::UpdateStates() const
 {
-	bool bUpdated = GitSourceControlUtils::UpdateCachedStates(States);
+	if(Histories.Num() == 0)
+	{
+		return GitSourceControlUtils::UpdateCachedStates(States);
+	}
 
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>( "GitSourceControl" );
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 
-	const FDateTime Now = FDateTime::Now();
-
-	// add history, if any
+	// add history, if any, to the states to apply, so that it is applied (and notified) along with the status of the file
+	TArray<FGitSourceControlState> StatesWithHistory = States;
+	TSet<FString> FilesWithHistory;
+	for(FGitSourceControlState& State : StatesWithHistory)
+	{
+		if(const TGitSourceControlHistory* History = Histories.Find(State.LocalFilename))
+		{
+			State.History = *History;
+			FilesWithHistory.Add(State.LocalFilename);
+		}
+	}
 	for(const auto& History : Histories)
 	{
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = Provider.GetStateInternal(History.Key);
-		State->History = History.Value;
-		State->TimeStamp = Now;
-		bUpdated = true;
+		if(!FilesWithHistory.Contains(History.Key))
+		{
+			FGitSourceControlState State(*Provider.GetStateInternal(History.Key));
+			State.History = History.Value;
+			StatesWithHistory.Add(MoveTemp(State));
+		}
 	}
 
-	return bUpdated;
+	return GitSourceControlUtils::UpdateCachedStates(StatesWithHistory);
 }
 
 FName FGitCopyWorker::GetName() const
@@ -834,6 +874,7 @@ bool FGitCopyWorker::Execute(FGitSourceControlCommand& InCommand)
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	TArray<FString> InFiles;
 	for (const auto& File : InCommand.Files) InFiles.Add(File);
 	for (const auto& Sub : AllProjects) {
@@ -843,7 +884,7 @@ bool FGitCopyWorker::Execute(FGitSourceControlCommand& InCommand)
 		for (const auto& File : InFiles) {
 			if (FPaths::IsRelative(File)) {
 				FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-				if (FPaths::FileExists(AbsFileName)) {
+				if (FileExistenceCache.FileExists(AbsFileName)) {
 					Files.Add(File);
 				}
 			}
@@ -862,7 +903,7 @@ bool FGitCopyWorker::Execute(FGitSourceControlCommand& InCommand)
 		// but after a Move the Editor create a redirector file with the old asset name that points to the new asset.
 		// The redirector needs to be commited with the new asset to perform a real rename.
 		// => the following is to "MarkForAdd" the redirector, but it still need to be committed by selecting the whole directory and "check-in"
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("add"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommandWithPathspecs(TEXT("add"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, InCommand.InfoMessages, InCommand.ErrorMessages);
 
 		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, Files, InCommand.ErrorMessages, States);
 	}
@@ -886,6 +927,7 @@ bool FGitResolveWorker::Execute( class FGitSourceControlCommand& InCommand )
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+	FGitFileExistenceCache FileExistenceCache;
 	TArray<FString> InFiles;
 	for (const auto& File : InCommand.Files) InFiles.Add(File);
 	for (const auto& Sub : AllProjects) {
@@ -895,7 +937,7 @@ bool FGitResolveWorker::Execute( class FGitSourceControlCommand& InCommand )
 		for (const auto& File : InFiles) {
 			if (FPaths::IsRelative(File)) {
 				FString AbsFileName = PathToRepositoryRoot + TEXT("/") + File;
-				if (FPaths::FileExists(AbsFileName)) {
+				if (FileExistenceCache.FileExists(AbsFileName)) {
 					Files.Add(File);
 				}
 			}
@@ -912,7 +954,7 @@ bool FGitResolveWorker::Execute( class FGitSourceControlCommand& InCommand )
 
 		// mark the conflicting files as resolved:
 		TArray<FString> Results;
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("add"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, Results, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommandWithPathspecs(TEXT("add"), InCommand.PathToGitBinary, PathToRepositoryRoot, TArray<FString>(), Files, Results, InCommand.ErrorMessages);
 
 		// now update the status of our files
 		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, Files, InCommand.ErrorMessages, States);
@@ -0,0 +1,123 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlOutputReader.h"
+
+FGitOutputReader::FGitOutputReader(const TCHAR InDelimiter, const bool bInCullEmpty)
+	: Delimiter(InDelimiter)
+	, bCullEmpty(bInCullEmpty)
+{
+}
+
+void FGitOutputReader::Append(const uint8* InData, const int32 InNumBytes)
+{
+	NumBytes += InNumBytes;
+
+	// The delimiter is an ASCII character, so it can never be found inside of a multi-bytes UTF-8 sequence
+	const uint8 DelimiterByte = static_cast<uint8>(Delimiter);
+	int32 LastDelimiter = InNumBytes - 1;
+	while(LastDelimiter >= 0 && InData[LastDelimiter] != DelimiterByte)
+	{
+		--LastDelimiter;
+	}
+
+	if(LastDelimiter < 0)
+	{
+		// No complete record in this chunk
+		const int32 PreviousMax = Incomplete.Max();
+		Incomplete.Append(InData, InNumBytes);
+		NumAllocations += (Incomplete.Max() != PreviousMax) ? 1 : 0;
+		return;
+	}
+
+	if(Incomplete.Num() > 0)
+	{
+		// Complete the pending record with the start of this chunk
+		const int32 PreviousMax = Incomplete.Max();
+		Incomplete.Append(InData, LastDelimiter + 1);
+		NumAllocations += (Incomplete.Max() != PreviousMax) ? 1 : 0;
+		Decode(Incomplete.GetData(), Incomplete.Num());
+		Incomplete.Reset();
+	}
+	else
+	{
+		Decode(InData, LastDelimiter + 1);
+	}
+
+	if(LastDelimiter + 1 < InNumBytes)
+	{
+		const int32 PreviousMax = Incomplete.Max();
+		Incomplete.Append(InData + LastDelimiter + 1, InNumBytes - LastDelimiter - 1);
+		NumAllocations += (Incomplete.Max() != PreviousMax) ? 1 : 0;
+	}
+}
+
+void FGitOutputReader::Finish()
+{
+	if(Incomplete.Num() > 0)
+	{
+		// Last record without a delimiter
+		const uint8 DelimiterByte = static_cast<uint8>(Delimiter);
+		Incomplete.Add(DelimiterByte);
+		Decode(Incomplete.GetData(), Incomplete.Num());
+		Incomplete.Reset();
+	}
+
+	const int32 PreviousMax = Records.Max();
+	Records.Reset(Ranges.Num());
+	NumAllocations += (Records.Max() != PreviousMax) ? 1 : 0;
+	for(const TPair<int32, int32>& Range : Ranges)
+	{
+		Records.Emplace(Arena.GetData() + Range.Key, Range.Value);
+	}
+}
+
+void FGitOutputReader::Reset()
+{
+	Incomplete.Reset();
+	Arena.Reset();
+	Ranges.Reset();
+	Records.Reset();
+	NumBytes = 0;
+}
+
+void FGitOutputReader::Decode(const uint8* InData, const int32 InNumBytes)
+{
+	const ANSICHAR* Source = reinterpret_cast<const ANSICHAR*>(InData);
+	const int32 ConvertedLength = FUTF8ToTCHAR_Convert::ConvertedLength(Source, InNumBytes);
+
+	const int32 Start = Arena.Num();
+	const int32 PreviousMax = Arena.Max();
+	if(Start + ConvertedLength > PreviousMax)
+	{
+		// Geometric growth of the arena to keep the number of reallocations logarithmic with the size of the output
+		Arena.Reserve(FMath::Max(Start + ConvertedLength, PreviousMax * 2));
+		++NumAllocations;
+	}
+	Arena.AddUninitialized(ConvertedLength);
+	FUTF8ToTCHAR_Convert::Convert(Arena.GetData() + Start, ConvertedLength, Source, InNumBytes);
+
+	// Split the decoded characters into records (the data always ends with a delimiter)
+	int32 RecordStart = Start;
+	for(int32 Index = Start; Index < Arena.Num(); ++Index)
+	{
+		if(Arena[Index] == Delimiter)
+		{
+			AddRecord(RecordStart, Index - RecordStart);
+			RecordStart = Index + 1;
+		}
+	}
+}
+
+void FGitOutputReader::AddRecord(const int32 InStart, const int32 InLen)
+{
+	if(bCullEmpty && InLen == 0)
+	{
+		return;
+	}
+	const int32 PreviousMax = Ranges.Max();
+	Ranges.Emplace(InStart, InLen);
+	NumAllocations += (Ranges.Max() != PreviousMax) ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+
+/**
+ * Streaming reader of the output of a Git command.
+ *
+ * Bytes read from the pipe are decoded from UTF-8 into one single character arena as soon as a record is complete,
+ * and records (lines, or NUL terminated entries with "-z") are exposed as views into this arena.
+ * This replaces the FString of the whole output and the FString per line of FString::ParseIntoArray().
+ *
+ * The views are only valid until the reader is reset or destroyed.
+ */
+class FGitOutputReader
+{
+public:
+	/**
+	 * @param	InDelimiter		The character terminating each record: '\n' for lines, '\0' for outputs produced with "-z"
+	 * @param	bInCullEmpty	Skip empty records, like FString::ParseIntoArray(..., true) did
+	 */
+	explicit FGitOutputReader(const TCHAR InDelimiter = TEXT('\n'), const bool bInCullEmpty = true);
+
+	/** Append a chunk of raw output, as read from the pipe */
+	void Append(const uint8* InData, const int32 InNumBytes);
+
+	/** Signal the end of the output, decoding the last record even if it is not terminated, and build the views */
+	void Finish();
+
+	/** Forget all the output but keep the memory to read another command */
+	void Reset();
+
+	/** The records of the output, valid after Finish() */
+	const TArray<FStringView>& GetRecords() const
+	{
+		return Records;
+	}
+
+	/** Number of heap allocations made by the reader (arena and records growth) since its creation */
+	int32 GetNumAllocations() const
+	{
+		return NumAllocations;
+	}
+
+	/** Number of bytes read */
+	int64 GetNumBytes() const
+	{
+		return NumBytes;
+	}
+
+private:
+	/** Decode complete records from UTF-8 into the arena */
+	void Decode(const uint8* InData, const int32 InNumBytes);
+
+	/** Record the start and length of a record in the arena */
+	void AddRecord(const int32 InStart, const int32 InLen);
+
+	/** The character terminating each record */
+	TCHAR Delimiter;
+
+	/** Skip empty records */
+	bool bCullEmpty;
+
+	/** Bytes of an incomplete record, waiting for the next chunk (never split a multi-bytes UTF-8 character) */
+	TArray<uint8> Incomplete;
+
+	/** All the decoded records, without their delimiters */
+	TArray<TCHAR> Arena;
+
+	/** Start and length of each record in the arena (the arena can move while growing, so views are only built in Finish()) */
+	TArray<TPair<int32, int32>> Ranges;
+
+	/** Views on each record in the arena */
+	TArray<FStringView> Records;
+
+	int32 NumAllocations = 0;
+	int64 NumBytes = 0;
+};
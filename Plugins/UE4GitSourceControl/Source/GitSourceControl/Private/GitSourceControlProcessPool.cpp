@@ -0,0 +1,390 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlProcessPool.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlUtils.h"
+
+namespace GitProcessPoolConstants
+{
+	/** Maximum time to wait for the answer of a helper process before giving up on it */
+	const double ReadTimeoutSeconds = 10.0;
+
+	/** Time to wait before polling the pipe again when the helper has not answered yet */
+	const float ReadPollSeconds = 0.001f;
+
+	/**
+	 * Maximum length of the requests written at once, so that they fit in the smallest pipe buffer (4 KB on Windows) even in UTF-8:
+	 * the helper answers while reading, so writing more than it can buffer before reading its answers would deadlock
+	 */
+	const int32 MaxRequestLength = 1024;
+}
+
+FThreadSafeCounter FGitProcessPool::NumProcessSpawns;
+FThreadSafeCounter FGitProcessPool::NumPooledRequests;
+
+/** Convert a UTF-8 record read from a pipe into a string */
+static FString StringFromUtf8(const TArray<uint8>& InRecord)
+{
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(InRecord.GetData()), InRecord.Num());
+	return FString(Converter.Length(), Converter.Get());
+}
+
+FGitHelperProcess::FGitHelperProcess(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InCommand)
+	: PathToGitBinary(InPathToGitBinary)
+	, RepositoryRoot(InRepositoryRoot)
+	, Command(InCommand)
+{
+}
+
+FGitHelperProcess::~FGitHelperProcess()
+{
+	Terminate();
+}
+
+bool FGitHelperProcess::Launch()
+{
+	if(!FPlatformProcess::CreatePipe(StdOutRead, StdOutWrite))
+	{
+		return false;
+	}
+	// The write end of stdin stays on our side (not inherited by the child process)
+	if(!FPlatformProcess::CreatePipe(StdInRead, StdInWrite, true))
+	{
+		FPlatformProcess::ClosePipe(StdOutRead, StdOutWrite);
+		StdOutRead = StdOutWrite = nullptr;
+		return false;
+	}
+
+	FString FullCommand = FString::Printf(TEXT("-C \"%s\" %s"), *RepositoryRoot, *Command);
+	const FString PathToGitOrEnvBinary = GitSourceControlUtils::GetGitOrEnvBinary(PathToGitBinary, FullCommand);
+
+	UE_LOG(LogSourceControl, Log, TEXT("Launching helper: 'git %s'"), *FullCommand);
+
+	const bool bLaunchDetached = false;
+	const bool bLaunchHidden = true;
+	const bool bLaunchReallyHidden = bLaunchHidden;
+	ProcessHandle = FPlatformProcess::CreateProc(*PathToGitOrEnvBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *RepositoryRoot, StdOutWrite, StdInRead);
+	FGitProcessPool::CountProcessSpawn();
+	if(!ProcessHandle.IsValid())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to launch 'git %s'"), *Command);
+		Terminate();
+		return false;
+	}
+
+	return true;
+}
+
+void FGitHelperProcess::Terminate()
+{
+	// Closing stdin is enough to make the helper exit on its own
+	if(StdInRead || StdInWrite)
+	{
+		FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+		StdInRead = StdInWrite = nullptr;
+	}
+	if(ProcessHandle.IsValid())
+	{
+		if(FPlatformProcess::IsProcRunning(ProcessHandle))
+		{
+			FPlatformProcess::Sleep(0.01f);
+			if(FPlatformProcess::IsProcRunning(ProcessHandle))
+			{
+				FPlatformProcess::TerminateProc(ProcessHandle);
+			}
+		}
+		FPlatformProcess::CloseProc(ProcessHandle);
+		ProcessHandle.Reset();
+	}
+	if(StdOutRead || StdOutWrite)
+	{
+		FPlatformProcess::ClosePipe(StdOutRead, StdOutWrite);
+		StdOutRead = StdOutWrite = nullptr;
+	}
+	Pending.Empty();
+}
+
+bool FGitHelperProcess::WaitForExit()
+{
+	if(StdInRead || StdInWrite)
+	{
+		FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+		StdInRead = StdInWrite = nullptr;
+	}
+	const double StartTime = FPlatformTime::Seconds();
+	while(IsRunning())
+	{
+		// Drain the output, so that the process never blocks on a full pipe
+		FillPending();
+		Pending.Reset();
+		if(FPlatformTime::Seconds() - StartTime > GitProcessPoolConstants::ReadTimeoutSeconds)
+		{
+			return false;
+		}
+	}
+	return ProcessHandle.IsValid();
+}
+
+bool FGitHelperProcess::IsRunning()
+{
+	return ProcessHandle.IsValid() && FPlatformProcess::IsProcRunning(ProcessHandle);
+}
+
+bool FGitHelperProcess::Write(const FString& InRequest)
+{
+	FTCHARToUTF8 Converter(*InRequest, InRequest.Len());
+	int32 Written = 0;
+	const bool bWritten = FPlatformProcess::WritePipe(StdInWrite, reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length(), &Written);
+	return bWritten && (Written == Converter.Length());
+}
+
+bool FGitHelperProcess::FillPending()
+{
+	TArray<uint8> Data;
+	FPlatformProcess::ReadPipeToArray(StdOutRead, Data);
+	if(Data.Num() > 0)
+	{
+		Pending.Append(MoveTemp(Data));
+		return true;
+	}
+	// Nothing available yet: wait a bit instead of spinning on the pipe
+	FPlatformProcess::Sleep(GitProcessPoolConstants::ReadPollSeconds);
+	return false;
+}
+
+bool FGitHelperProcess::ReadUntil(const uint8 InDelimiter, TArray<uint8>& OutRecord)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	int32 SearchFrom = 0;
+	while(true)
+	{
+		for(int32 Index = SearchFrom; Index < Pending.Num(); ++Index)
+		{
+			if(Pending[Index] == InDelimiter)
+			{
+				OutRecord.Append(Pending.GetData(), Index);
+				Pending.RemoveAt(0, Index + 1, false);
+				return true;
+			}
+		}
+		SearchFrom = Pending.Num();
+
+		if(!FillPending())
+		{
+			if(!IsRunning() || (FPlatformTime::Seconds() - StartTime > GitProcessPoolConstants::ReadTimeoutSeconds))
+			{
+				return false;
+			}
+		}
+	}
+}
+
+bool FGitHelperProcess::ReadBytes(const int32 InNumBytes, TArray<uint8>& OutBytes)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	while(Pending.Num() < InNumBytes)
+	{
+		if(!FillPending())
+		{
+			if(!IsRunning() || (FPlatformTime::Seconds() - StartTime > GitProcessPoolConstants::ReadTimeoutSeconds))
+			{
+				return false;
+			}
+		}
+	}
+	OutBytes.Append(Pending.GetData(), InNumBytes);
+	Pending.RemoveAt(0, InNumBytes, false);
+	return true;
+}
+
+FGitProcessPool& FGitProcessPool::Get()
+{
+	static FGitProcessPool ProcessPool;
+	return ProcessPool;
+}
+
+FString FGitProcessPool::MakeKey(const FString& InRepositoryRoot, const EGitHelperKind::Type InKind)
+{
+	return FString::Printf(TEXT("%d|%s"), static_cast<int32>(InKind), *InRepositoryRoot);
+}
+
+TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe> FGitProcessPool::AcquireHelper(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const EGitHelperKind::Type InKind)
+{
+	if(!bEnabled || InPathToGitBinary.IsEmpty() || InRepositoryRoot.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	FScopeLock ScopeLock(&CriticalSection);
+
+	const FString Key = MakeKey(InRepositoryRoot, InKind);
+	if(TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe>* Helper = Helpers.Find(Key))
+	{
+		if((*Helper)->IsRunning())
+		{
+			return *Helper;
+		}
+		Helpers.Remove(Key);
+	}
+
+	FString Command;
+	switch(InKind)
+	{
+	case EGitHelperKind::CatFileBatchCheck:
+		Command = TEXT("cat-file --batch-check");
+		break;
+	case EGitHelperKind::CatFileBatch:
+		Command = TEXT("cat-file --batch");
+		break;
+	default:
+		return nullptr;
+	}
+
+	TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe> NewHelper = MakeShared<FGitHelperProcess, ESPMode::ThreadSafe>(InPathToGitBinary, InRepositoryRoot, Command);
+	if(!NewHelper->Launch())
+	{
+		return nullptr;
+	}
+	Helpers.Add(Key, NewHelper);
+	return NewHelper;
+}
+
+void FGitProcessPool::DiscardHelper(const FString& InRepositoryRoot, const EGitHelperKind::Type InKind)
+{
+	TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe> Helper;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		Helpers.RemoveAndCopyValue(MakeKey(InRepositoryRoot, InKind), Helper);
+	}
+	if(Helper.IsValid())
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("Git helper process for '%s' stopped answering, it will be relaunched"), *InRepositoryRoot);
+	}
+}
+
+/**
+ * Parse one answer of "cat-file --batch-check" or one header of "cat-file --batch"
+ *
+ * Example outputs:
+a14347dc3b589b78fb19ba62a7e3982f343718bc blob 70731
+HEAD:Content/Missing.uasset missing
+ */
+static bool ParseObjectInfo(const FString& InLine, FGitObjectInfo& OutInfo)
+{
+	TArray<FString> Tokens;
+	InLine.ParseIntoArray(Tokens, TEXT(" "), true);
+	if((Tokens.Num() == 3) && (Tokens[0].Len() == 40))
+	{
+		OutInfo.Hash = MoveTemp(Tokens[0]);
+		OutInfo.Type = MoveTemp(Tokens[1]);
+		OutInfo.Size = FCString::Atoi64(*Tokens[2]);
+		return true;
+	}
+	// "missing" or "ambiguous" object name
+	OutInfo = FGitObjectInfo();
+	return false;
+}
+
+bool FGitProcessPool::BatchCheck(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InObjectNames, TArray<FGitObjectInfo>& OutInfos)
+{
+	TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe> Helper = AcquireHelper(InPathToGitBinary, InRepositoryRoot, EGitHelperKind::CatFileBatchCheck);
+	if(!Helper.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&Helper->CriticalSection);
+
+	// Write the object names in chunks, reading all the answers of a chunk before writing the next one
+	bool bResult = true;
+	int32 NextIndex = 0;
+	while(bResult && NextIndex < InObjectNames.Num())
+	{
+		FString Request;
+		const int32 FirstIndex = NextIndex;
+		do
+		{
+			Request += InObjectNames[NextIndex++];
+			Request += TEXT("\n");
+		}
+		while(NextIndex < InObjectNames.Num() && Request.Len() + InObjectNames[NextIndex].Len() < GitProcessPoolConstants::MaxRequestLength);
+
+		bResult = Helper->Write(Request);
+		for(int32 Index = FirstIndex; bResult && Index < NextIndex; ++Index)
+		{
+			TArray<uint8> Line;
+			bResult = Helper->ReadUntil('\n', Line);
+			if(bResult)
+			{
+				FGitObjectInfo Info;
+				ParseObjectInfo(StringFromUtf8(Line), Info);
+				OutInfos.Add(MoveTemp(Info));
+			}
+		}
+	}
+
+	if(bResult)
+	{
+		NumPooledRequests.Increment();
+	}
+	else
+	{
+		Helper->Terminate();
+		DiscardHelper(InRepositoryRoot, EGitHelperKind::CatFileBatchCheck);
+	}
+	return bResult;
+}
+
+bool FGitProcessPool::CatFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, FGitObjectInfo& OutInfo, TArray<uint8>& OutContent)
+{
+	TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe> Helper = AcquireHelper(InPathToGitBinary, InRepositoryRoot, EGitHelperKind::CatFileBatch);
+	if(!Helper.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&Helper->CriticalSection);
+
+	TArray<uint8> Header;
+	bool bResult = Helper->Write(InObjectName + TEXT("\n")) && Helper->ReadUntil('\n', Header);
+	if(bResult)
+	{
+		NumPooledRequests.Increment();
+		if(!ParseObjectInfo(StringFromUtf8(Header), OutInfo))
+		{
+			// The helper is still in a good state: the object simply does not exist
+			return false;
+		}
+		// The content is followed by a line feed
+		TArray<uint8> LineFeed;
+		bResult = Helper->ReadBytes(static_cast<int32>(OutInfo.Size), OutContent) && Helper->ReadBytes(1, LineFeed);
+	}
+
+	if(!bResult)
+	{
+		Helper->Terminate();
+		DiscardHelper(InRepositoryRoot, EGitHelperKind::CatFileBatch);
+	}
+	return bResult;
+}
+
+void FGitProcessPool::Shutdown()
+{
+	TMap<FString, TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe>> HelpersToTerminate;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		HelpersToTerminate = MoveTemp(Helpers);
+		Helpers.Reset();
+	}
+	for(auto& Helper : HelpersToTerminate)
+	{
+		FScopeLock ScopeLock(&Helper.Value->CriticalSection);
+		Helper.Value->Terminate();
+	}
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/** Kinds of long-lived Git helper processes, each one reading its requests from stdin */
+namespace EGitHelperKind
+{
+	enum Type
+	{
+		CatFileBatchCheck,	// git cat-file --batch-check
+		CatFileBatch,		// git cat-file --batch
+		Count,
+	};
+}
+
+/**
+ * A long-lived Git process answering requests written to its standard input.
+ *
+ * Request/answer round trips must be serialized by holding its CriticalSection.
+ */
+class FGitHelperProcess
+{
+public:
+	FGitHelperProcess(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InCommand);
+	~FGitHelperProcess();
+
+	/** Launch the process with its stdin/stdout pipes */
+	bool Launch();
+
+	/** Close the pipes and terminate the process if it does not exit by itself */
+	void Terminate();
+
+	/** Close the standard input and wait for the process to exit by itself (for one-shot commands like "credential approve") */
+	bool WaitForExit();
+
+	/** Tell if the process is still alive and usable */
+	bool IsRunning();
+
+	/** Write raw bytes to the standard input of the process */
+	bool Write(const FString& InRequest);
+
+	/** Read the standard output up to (and excluding) the given delimiter */
+	bool ReadUntil(const uint8 InDelimiter, TArray<uint8>& OutRecord);
+
+	/** Read exactly the given number of bytes from the standard output */
+	bool ReadBytes(const int32 InNumBytes, TArray<uint8>& OutBytes);
+
+	/** The critical section serializing request/answer round trips */
+	FCriticalSection CriticalSection;
+
+private:
+	/** Pull any available data from the pipe into the pending buffer, waiting a bit if nothing is available */
+	bool FillPending();
+
+	FString PathToGitBinary;
+	FString RepositoryRoot;
+	FString Command;
+
+	FProcHandle ProcessHandle;
+	void* StdOutRead = nullptr;
+	void* StdOutWrite = nullptr;
+	void* StdInRead = nullptr;
+	void* StdInWrite = nullptr;
+
+	/** Data read from the pipe but not yet consumed */
+	TArray<uint8> Pending;
+};
+
+/** Result of a "cat-file --batch-check" request on an object name */
+struct FGitObjectInfo
+{
+	/** Full SHA1 of the object, empty if missing */
+	FString Hash;
+	/** "blob", "tree", "commit" or "tag", empty if missing */
+	FString Type;
+	/** Size of the object in bytes */
+	int64 Size = 0;
+};
+
+/**
+ * Pool of long-lived Git helper processes, one of each kind per repository root.
+ *
+ * Replaces a process spawn per query for the commands that can be served by a "--batch" or "--stdin" mode.
+ * Helpers are launched on first use and kept alive until Shutdown() (called when the provider closes).
+ */
+class FGitProcessPool
+{
+public:
+	static FGitProcessPool& Get();
+
+	/** Enable or disable the use of the helpers (used to compare both paths) */
+	void SetEnabled(const bool bInEnabled)
+	{
+		bEnabled = bInEnabled;
+	}
+	bool IsEnabled() const
+	{
+		return bEnabled;
+	}
+
+	/** Resolve object names ("HEAD", "<rev>:<path>"...) with "cat-file --batch-check" */
+	bool BatchCheck(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InObjectNames, TArray<FGitObjectInfo>& OutInfos);
+
+	/** Get the content of one object with "cat-file --batch" */
+	bool CatFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InObjectName, FGitObjectInfo& OutInfo, TArray<uint8>& OutContent);
+
+	/** Terminate all helper processes */
+	void Shutdown();
+
+	/** Count a new Git process spawned, by the pool or by a one-shot command */
+	static void CountProcessSpawn()
+	{
+		NumProcessSpawns.Increment();
+	}
+
+	/** Number of Git processes spawned since the last reset */
+	static int32 GetNumProcessSpawns()
+	{
+		return NumProcessSpawns.GetValue();
+	}
+
+	/** Number of requests served by a helper process since the last reset */
+	static int32 GetNumPooledRequests()
+	{
+		return NumPooledRequests.GetValue();
+	}
+
+	static void ResetCounters()
+	{
+		NumProcessSpawns.Reset();
+		NumPooledRequests.Reset();
+	}
+
+private:
+	FGitProcessPool() = default;
+
+	/** Find or launch the helper of the given kind for the given repository */
+	TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe> AcquireHelper(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const EGitHelperKind::Type InKind);
+
+	/** Forget a helper that failed, so that it is relaunched on next use */
+	void DiscardHelper(const FString& InRepositoryRoot, const EGitHelperKind::Type InKind);
+
+	/** Key of the helpers map: repository root and kind of helper */
+	static FString MakeKey(const FString& InRepositoryRoot, const EGitHelperKind::Type InKind);
+
+	/** Guards the map of helpers (not the requests themselves) */
+	FCriticalSection CriticalSection;
+
+	/** Running helper processes, by repository and kind */
+	TMap<FString, TSharedPtr<FGitHelperProcess, ESPMode::ThreadSafe>> Helpers;
+
+	bool bEnabled = true;
+
+	static FThreadSafeCounter NumProcessSpawns;
+	static FThreadSafeCounter NumPooledRequests;
+};
@@ -5,15 +5,24 @@
 
 #include "GitSourceControlProvider.h"
 
+#include "HAL/IConsoleManager.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/Paths.h"
 #include "Misc/QueuedThreadPool.h"
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
+#include "Stats/Stats.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
 #include "GitSourceControlCommand.h"
 #include "ISourceControlModule.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlUtils.h"
+#include "GitSourceControlProcessPool.h"
+#include "GitSourceControlIndex.h"
+#include "GitSourceControlLfsLocksClient.h"
+#include "GitSourceControlRefs.h"
+#include "GitSourceControlSnapshot.h"
 #include "SGitSourceControlSettings.h"
 #include "Logging/MessageLog.h"
 #include "ScopedSourceControlProgress.h"
@@ -25,6 +34,14 @@
 
 static FName ProviderName("Git LFS 2");
 
+static TAutoConsoleVariable<float> CVarGitTickBudgetMs(
+	TEXT("Git.TickBudgetMs"),
+	5.0f,
+	TEXT("Time budget in milliseconds of the Git provider on each tick of the Editor, to process the results of completed source control commands (at least one command per tick)."));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("States applied per frame"), STAT_GitStatesAppliedPerFrame, STATGROUP_GitSourceControl);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frames spent applying states"), STAT_GitFramesApplyingStates, STATGROUP_GitSourceControl);
+
 void FGitSourceControlProvider::Init(bool bForceConnection)
 {
 	// Init() is called multiple times at startup: do not check git each time
@@ -89,6 +106,12 @@ void FGitSourceControlProvider::CheckRepositoryStatus(const FString& InPathToGit
 		if(bGitRepositoryFound)
 		{
 			GitSourceControlUtils::GetRemoteUrl(InPathToGitBinary, PathToRepositoryRoot, RemoteUrl);
+
+			// Watch the project for changes, to only query the status of modified files
+			ChangeTracker.Start(PathToRepositoryRoot);
+
+			// Show the states of the last session until the "Connect" operation reconciles them
+			LoadStateSnapshot();
 		}
 		else
 		{
@@ -106,10 +129,39 @@ void FGitSourceControlProvider::CheckRepositoryStatus(const FString& InPathToGit
 
 void FGitSourceControlProvider::Close()
 {
-	// clear the cache
+	if(NumCoalescedUpdateStatus > 0)
+	{
+		// Not measured: a request on clean files (served by the change tracker) would have run no Git command at all
+		TArray<FString> SubModules;
+		GitSourceControlUtils::GetSubModulesRoots(SubModules);
+		UE_LOG(LogSourceControl, Log, TEXT("%d UpdateStatus requests coalesced, saving up to an estimated %d Git invocations (one status per repository each)"),
+			NumCoalescedUpdateStatus, NumCoalescedUpdateStatus * (1 + SubModules.Num()));
+		NumCoalescedUpdateStatus = 0;
+	}
+
+	// Apply all the states still queued, keep them for the next startup, then clear the cache
+	ApplyQueuedStates(TNumericLimits<double>::Max());
+	ChangedFiles.Reset();
+	if(bGitRepositoryFound)
+	{
+		SaveStateSnapshot();
+	}
 	StateCache.Empty();
+	{
+		FScopeLock ScopeLock(&FilesToReconcileCriticalSection);
+		FilesToReconcile.Reset();
+	}
+	// Stop watching the project for changes
+	ChangeTracker.Stop();
 	// Remove all extensions to the "Source Control" menu in the Editor Toolbar
 	GitSourceControlMenu.Unregister();
+	// Terminate the long-lived Git helper processes
+	FGitProcessPool::Get().Shutdown();
+	// Forget the parsed Git indexes and HEADs
+	FGitIndexCache::Get().Reset();
+	FGitRefsCache::Get().Reset();
+	// Forget the endpoints and credentials of the LFS servers, in case the settings change
+	FGitLfsLocksClient::Get().Reset();
 
 	bGitAvailable = false;
 	bGitRepositoryFound = false;
@@ -119,31 +171,63 @@ void FGitSourceControlProvider::Close()
 
 TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlProvider::GetStateInternal(const FString& Filename)
 {
-	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* State = StateCache.Find(Filename);
-	if(State != NULL)
+	// Find the cached item, else cache an unknown state for this item
+	return StateCache.FindOrAdd(Filename, bUsingGitLfsLocking);
+}
+
+bool FGitSourceControlProvider::LoadStateSnapshot()
+{
+	TArray<FString> SnapshotFilesToReconcile;
+	if(!FGitSourceControlSnapshot::Load(PathToRepositoryRoot, bUsingGitLfsLocking, StateCache, SnapshotFilesToReconcile))
 	{
-		// found cached item
-		return (*State);
+		return false;
 	}
-	else
+
 	{
-		// cache an unknown state for this item
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> NewState = MakeShareable( new FGitSourceControlState(Filename, bUsingGitLfsLocking) );
-		StateCache.Add(Filename, NewState);
-		return NewState;
+		FScopeLock ScopeLock(&FilesToReconcileCriticalSection);
+		FilesToReconcile.Append(MoveTemp(SnapshotFilesToReconcile));
 	}
+	OnSourceControlStateChanged.Broadcast();
+	return true;
+}
+
+bool FGitSourceControlProvider::SaveStateSnapshot() const
+{
+	return FGitSourceControlSnapshot::Save(PathToRepositoryRoot, StateCache);
+}
+
+TArray<FString> FGitSourceControlProvider::TakeFilesToReconcile()
+{
+	FScopeLock ScopeLock(&FilesToReconcileCriticalSection);
+	return MoveTemp(FilesToReconcile);
 }
 
 FText FGitSourceControlProvider::GetStatusText() const
 {
+	// Read the current branch and commit natively, since they can change outside of the Editor
+	FGitHeadInfo Head;
+	if(FGitRefsCache::Get().GetHead(PathToRepositoryRoot, Head))
+	{
+		if(Head.CommitSummary.IsEmpty() && (Head.CommitId == CommitId))
+		{
+			Head.CommitSummary = CommitSummary;
+		}
+	}
+	else
+	{
+		Head.BranchName = BranchName;
+		Head.CommitId = CommitId;
+		Head.CommitSummary = CommitSummary;
+	}
+
 	FFormatNamedArguments Args;
 	Args.Add( TEXT("RepositoryName"), FText::FromString(PathToRepositoryRoot) );
 	Args.Add( TEXT("RemoteUrl"), FText::FromString(RemoteUrl) );
 	Args.Add( TEXT("UserName"), FText::FromString(UserName) );
 	Args.Add( TEXT("UserEmail"), FText::FromString(UserEmail) );
-	Args.Add( TEXT("BranchName"), FText::FromString(BranchName) );
-	Args.Add( TEXT("CommitId"), FText::FromString(CommitId.Left(8)) );
-	Args.Add( TEXT("CommitSummary"), FText::FromString(CommitSummary) );
+	Args.Add( TEXT("BranchName"), FText::FromString(Head.BranchName) );
+	Args.Add( TEXT("CommitId"), FText::FromString(Head.CommitId.Left(8)) );
+	Args.Add( TEXT("CommitSummary"), FText::FromString(Head.CommitSummary) );
 
 	return FText::Format( NSLOCTEXT("Status", "Provider: Git\nEnabledLabel", "Local repository: {RepositoryName}\nRemote origin: {RemoteUrl}\nUser: {UserName}\nE-mail: {UserEmail}\n[{BranchName} {CommitId}] {CommitSummary}"), Args );
 }
@@ -189,10 +273,15 @@ ECommandResult::Type FGitSourceControlProvider::GetState( const TArray<FString>&
 
 TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCachedStateByPredicate(TFunctionRef<bool(const FSourceControlStateRef&)> Predicate) const
 {
+	// The predicate is opaque: this is a full scan, see the typed queries like GetModifiedCachedStates() using the indexes of the cache.
+	// Run the predicate on a snapshot, to never hold a lock of the cache while calling back into the Editor
+	TArray<FGitSourceControlStateRef> States;
+	StateCache.GetStates(States);
+
 	TArray<FSourceControlStateRef> Result;
-	for(const auto& CacheItem : StateCache)
+	for(const FGitSourceControlStateRef& GitState : States)
 	{
-		FSourceControlStateRef State = CacheItem.Value;
+		FSourceControlStateRef State = GitState;
 		if(Predicate(State))
 		{
 			Result.Add(State);
@@ -201,19 +290,81 @@ TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCachedStateByPredic
 	return Result;
 }
 
+/** Convert the states of the cache to the type returned to the Editor */
+static TArray<FSourceControlStateRef> ToSourceControlStates(const TArray<FGitSourceControlStateRef>& InStates)
+{
+	TArray<FSourceControlStateRef> Result;
+	Result.Reserve(InStates.Num());
+	for(const FGitSourceControlStateRef& State : InStates)
+	{
+		Result.Add(State);
+	}
+	return Result;
+}
+
+TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCachedStatesByWorkingCopyState(const EWorkingCopyState::Type InWorkingCopyState) const
+{
+	TArray<FGitSourceControlStateRef> States;
+	StateCache.GetStatesByWorkingCopyState(InWorkingCopyState, States);
+	return ToSourceControlStates(States);
+}
+
+TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCachedStatesByLockState(const ELockState::Type InLockState) const
+{
+	TArray<FGitSourceControlStateRef> States;
+	StateCache.GetStatesByLockState(InLockState, States);
+	return ToSourceControlStates(States);
+}
+
+TArray<FSourceControlStateRef> FGitSourceControlProvider::GetModifiedCachedStates() const
+{
+	// All the working copy states for which FGitSourceControlState::IsModified() is true
+	static const EWorkingCopyState::Type ModifiedStates[] = {
+		EWorkingCopyState::Added,
+		EWorkingCopyState::Deleted,
+		EWorkingCopyState::Modified,
+		EWorkingCopyState::Renamed,
+		EWorkingCopyState::Copied,
+		EWorkingCopyState::Missing,
+		EWorkingCopyState::Conflicted,
+	};
+
+	TArray<FGitSourceControlStateRef> States;
+	for(const EWorkingCopyState::Type ModifiedState : ModifiedStates)
+	{
+		StateCache.GetStatesByWorkingCopyState(ModifiedState, States);
+	}
+	return ToSourceControlStates(States);
+}
+
+TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCheckedOutCachedStates() const
+{
+	if(bUsingGitLfsLocking)
+	{
+		return GetCachedStatesByLockState(ELockState::Locked);
+	}
+	else
+	{
+		// With Git all tracked files in the working copy are always checked-out
+		return GetCachedStateByPredicate([](const FSourceControlStateRef& State) { return State->IsCheckedOut(); });
+	}
+}
+
+TArray<FSourceControlStateRef> FGitSourceControlProvider::GetConflictedCachedStates() const
+{
+	return GetCachedStatesByWorkingCopyState(EWorkingCopyState::Conflicted);
+}
+
 bool FGitSourceControlProvider::RemoveFileFromCache(const FString& Filename)
 {
-	return StateCache.Remove(Filename) > 0;
+	return StateCache.Remove(Filename);
 }
 
 /** Get files in cache */
 TArray<FString> FGitSourceControlProvider::GetFilesInCache()
 {
 	TArray<FString> Files;
-	for (const auto& State : StateCache)
-	{
-		Files.Add(State.Key);
-	}
+	StateCache.GetFilenames(Files);
 	return Files;
 }
 
@@ -227,6 +378,16 @@ void FGitSourceControlProvider::UnregisterSourceControlStateChanged_Handle( FDel
 	OnSourceControlStateChanged.Remove( Handle );
 }
 
+FDelegateHandle FGitSourceControlProvider::RegisterFilesChanged(const FGitSourceControlFilesChanged::FDelegate& InFilesChanged)
+{
+	return OnFilesChanged.Add(InFilesChanged);
+}
+
+void FGitSourceControlProvider::UnregisterFilesChanged(FDelegateHandle InHandle)
+{
+	OnFilesChanged.Remove(InHandle);
+}
+
 ECommandResult::Type FGitSourceControlProvider::Execute( const TSharedRef<ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const TArray<FString>& InFiles, EConcurrency::Type InConcurrency, const FSourceControlOperationComplete& InOperationCompleteDelegate )
 {
 	if(!IsEnabled() && !(InOperation->GetName() == "Connect")) // Only Connect operation allowed while not Enabled (Repository found)
@@ -253,6 +414,12 @@ ECommandResult::Type FGitSourceControlProvider::Execute( const TSharedRef<ISourc
 		return ECommandResult::Failed;
 	}
 
+	// Merge the request into an "UpdateStatus" command already querying or about to query the same files
+	if((InConcurrency == EConcurrency::Asynchronous) && CoalesceUpdateStatus(InOperation, AbsoluteFiles, InOperationCompleteDelegate))
+	{
+		return ECommandResult::Succeeded;
+	}
+
 	FGitSourceControlCommand* Command = new FGitSourceControlCommand(InOperation, Worker.ToSharedRef());
 	Command->Files = AbsoluteFiles;
 	Command->OperationCompleteDelegate = InOperationCompleteDelegate;
@@ -274,6 +441,45 @@ ECommandResult::Type FGitSourceControlProvider::Execute( const TSharedRef<ISourc
 	}
 }
 
+bool FGitSourceControlProvider::CoalesceUpdateStatus(const TSharedRef<ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const TArray<FString>& InFiles, const FSourceControlOperationComplete& InOperationCompleteDelegate)
+{
+	static const FName UpdateStatusName("UpdateStatus");
+
+	// The history is gathered for the requested files only: never merge such requests
+	if(InOperation->GetName() != UpdateStatusName || StaticCastSharedRef<FUpdateStatus>(InOperation)->ShouldUpdateHistory())
+	{
+		return false;
+	}
+
+	TArray<FGitSourceControlCommand*> UpdateStatusCommands;
+	for(FGitSourceControlCommand* Command : CommandQueue)
+	{
+		if(!Command->bExecuteProcessed && Command->Operation->GetName() == UpdateStatusName && !StaticCastSharedRef<FUpdateStatus>(Command->Operation)->ShouldUpdateHistory())
+		{
+			UpdateStatusCommands.Add(Command);
+		}
+	}
+
+	// Drop the request if a queued or running command already covers it (files saved while it runs are caught by the change tracker),
+	// else merge it into the first command still waiting for a worker thread
+	FGitSourceControlCommand* const* MergeCommandPtr = UpdateStatusCommands.FindByPredicate([&InFiles](FGitSourceControlCommand* Command) { return Command->CoversFiles(InFiles); });
+	if(MergeCommandPtr == nullptr)
+	{
+		MergeCommandPtr = UpdateStatusCommands.FindByPredicate([&InFiles](FGitSourceControlCommand* Command) { return Command->TryAddFiles(InFiles); });
+	}
+	if(MergeCommandPtr == nullptr)
+	{
+		return false;
+	}
+	FGitSourceControlCommand* MergeCommand = *MergeCommandPtr;
+
+	MergeCommand->AddCoalescedOperation(InOperation, InOperationCompleteDelegate);
+
+	++NumCoalescedUpdateStatus;
+	UE_LOG(LogSourceControl, Verbose, TEXT("UpdateStatus of %d files coalesced into a command of %d files (%d requests coalesced so far)"), InFiles.Num(), MergeCommand->Files.Num(), NumCoalescedUpdateStatus);
+	return true;
+}
+
 bool FGitSourceControlProvider::CanCancelOperation( const TSharedRef<ISourceControlOperation, ESPMode::ThreadSafe>& InOperation ) const
 {
 	return false;
@@ -340,45 +546,156 @@ void FGitSourceControlProvider::UpdateRepositoryStatus(const class FGitSourceCon
 }
 
 void FGitSourceControlProvider::Tick()
-{	
-	bool bStatesUpdated = false;
-
-	for(int32 CommandIndex = 0; CommandIndex < CommandQueue.Num(); ++CommandIndex)
+{
+	// First move all the finished commands out of the queue, since the completion delegates can issue new commands (modifying the queue)
+	for(int32 CommandIndex = 0; CommandIndex < CommandQueue.Num();)
 	{
-		FGitSourceControlCommand& Command = *CommandQueue[CommandIndex];
-		if(Command.bExecuteProcessed)
+		if(CommandQueue[CommandIndex]->bExecuteProcessed)
 		{
-			// Remove command from the queue
+			CompletedCommands.Add(CommandQueue[CommandIndex]);
 			CommandQueue.RemoveAt(CommandIndex);
+		}
+		else
+		{
+			++CommandIndex;
+		}
+	}
+
+	// Then process them in order, as many as the budget of the frame allows (at least one), and notify the Editor once for all:
+	// the states of each command are applied to the cache in slices, possibly over several frames, before its results are returned
+	const double EndTime = FPlatformTime::Seconds() + CVarGitTickBudgetMs.GetValueOnGameThread() / 1000.0;
+	const uint64 NumStatesAppliedBefore = NumStatesApplied;
+	int32 NumCommandsFinished = 0;
+	for(;;)
+	{
+		if(CommandApplyingStates == nullptr)
+		{
+			if(CompletedCommands.Num() == 0 || (NumCommandsFinished > 0 && FPlatformTime::Seconds() >= EndTime))
+			{
+				break;
+			}
+
+			// Remove the command from the list before running its delegate, which can tick the provider again (synchronous command)
+			FGitSourceControlCommand& Command = *CompletedCommands[0];
+			CompletedCommands.RemoveAt(0);
 
 			// Update respository status on UpdateStatus operations
 			UpdateRepositoryStatus(Command);
 
-			// let command update the states of any files
-			bStatesUpdated |= Command.Worker->UpdateStates();
+			// let command queue the states of any files: only those that really change are notified below
+			Command.Worker->UpdateStates();
+
+			CommandApplyingStates = &Command;
+			FScopeLock ScopeLock(&QueuedStatesCriticalSection);
+			CommandStatesEnd = NumStatesQueued;
+		}
+
+		ApplyQueuedStates(EndTime);
+		if(NumStatesApplied < CommandStatesEnd)
+		{
+			// Budget spent: continue on the next tick
+			break;
+		}
+
+		FGitSourceControlCommand& Command = *CommandApplyingStates;
+		CommandApplyingStates = nullptr;
+		FinishCommand(Command);
+		++NumCommandsFinished;
+	}
 
-			// dump any messages to output log
-			OutputCommandMessages(Command);
+	// States queued by the locks worker, outside of any command
+	if(CommandApplyingStates == nullptr)
+	{
+		ApplyQueuedStates(EndTime);
+	}
+
+	const uint64 NumStatesAppliedThisFrame = NumStatesApplied - NumStatesAppliedBefore;
+	if(NumStatesAppliedThisFrame > 0)
+	{
+		++NumFramesApplyingStates;
+		INC_DWORD_STAT_BY(STAT_GitStatesAppliedPerFrame, NumStatesAppliedThisFrame);
+		SET_DWORD_STAT(STAT_GitFramesApplyingStates, NumFramesApplyingStates);
+	}
+	{
+		FScopeLock ScopeLock(&QueuedStatesCriticalSection);
+		if(NumFramesApplyingStates > 0 && NumStatesApplied == NumStatesQueued)
+		{
+			UE_LOG(LogSourceControl, Verbose, TEXT("All the queued states applied in %d frames"), NumFramesApplyingStates);
+			NumFramesApplyingStates = 0;
+		}
+	}
 
-			// run the completion delegate callback if we have one bound
-			Command.ReturnResults();
+	if(ChangedFiles.Num() > 0)
+	{
+		const TArray<FString> Files = ChangedFiles.Array();
+		ChangedFiles.Reset();
+		OnSourceControlStateChanged.Broadcast();
+		OnFilesChanged.Broadcast(Files);
+	}
+}
+
+void FGitSourceControlProvider::QueueStates(const TArray<FGitSourceControlState>& InStates, const FDateTime& InTimeStamp)
+{
+	FScopeLock ScopeLock(&QueuedStatesCriticalSection);
+	QueuedStates.Reserve(QueuedStates.Num() + InStates.Num());
+	for(const FGitSourceControlState& InState : InStates)
+	{
+		const int32 Index = QueuedStates.Add(InState);
+		QueuedStates[Index].TimeStamp = InTimeStamp;
+	}
+	NumStatesQueued += InStates.Num();
+}
 
-			// commands that are left in the array during a tick need to be deleted
-			if(Command.bAutoDelete)
+bool FGitSourceControlProvider::ApplyQueuedStates(const double InEndTime)
+{
+	// Check the time only once per slice of states, and apply at least one slice per call so that the queue always progresses
+	static const int32 SliceSize = 64;
+
+	FScopeLock ScopeLock(&QueuedStatesCriticalSection);
+	while(QueuedStatesIndex < QueuedStates.Num())
+	{
+		const int32 SliceEnd = FMath::Min(QueuedStatesIndex + SliceSize, QueuedStates.Num());
+		for(; QueuedStatesIndex < SliceEnd; ++QueuedStatesIndex)
+		{
+			// Move the prepared state into the cache, under the lock of its shard
+			FGitSourceControlState& State = QueuedStates[QueuedStatesIndex];
+			const FDateTime TimeStamp = State.TimeStamp;
+			const TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> ChangedState = StateCache.Update(MoveTemp(State), TimeStamp);
+			if(ChangedState.IsValid())
 			{
-				// Only delete commands that are not running 'synchronously'
-				delete &Command;
+				ChangedFiles.Add(ChangedState->LocalFilename);
 			}
-
-			// only do one command per tick loop, as we dont want concurrent modification
-			// of the command queue (which can happen in the completion delegate)
+			++NumStatesApplied;
+		}
+		if(FPlatformTime::Seconds() >= InEndTime)
+		{
 			break;
 		}
 	}
 
-	if(bStatesUpdated)
+	if(QueuedStatesIndex < QueuedStates.Num())
 	{
-		OnSourceControlStateChanged.Broadcast();
+		return false;
+	}
+	// Keep the allocation for the next states
+	QueuedStates.Reset();
+	QueuedStatesIndex = 0;
+	return true;
+}
+
+void FGitSourceControlProvider::FinishCommand(FGitSourceControlCommand& InCommand)
+{
+	// dump any messages to output log
+	OutputCommandMessages(InCommand);
+
+	// run the completion delegate callback if we have one bound
+	InCommand.ReturnResults();
+
+	// commands that are left in the array during a tick need to be deleted
+	if(InCommand.bAutoDelete)
+	{
+		// Only delete commands that are not running 'synchronously'
+		delete &InCommand;
 	}
 }
 
@@ -422,8 +739,13 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 			FPlatformProcess::Sleep(0.01f);
 		}
 
-		// always do one more Tick() to make sure the command queue is cleaned up.
-		Tick();
+		// always do one more Tick() to make sure the command queue is cleaned up,
+		// and more if the budget of the frame was spent on the other commands completed before this one, or on the states of this one.
+		do
+		{
+			Tick();
+		}
+		while(CompletedCommands.Contains(&InCommand) || CommandApplyingStates == &InCommand);
 
 		if(InCommand.bCommandSuccessful)
 		{
@@ -9,14 +9,23 @@
 #include "ISourceControlOperation.h"
 #include "ISourceControlState.h"
 #include "ISourceControlProvider.h"
+#include "Stats/Stats.h"
 #include "IGitSourceControlWorker.h"
 #include "GitSourceControlState.h"
 #include "GitSourceControlMenu.h"
+#include "GitSourceControlChangeTracker.h"
+#include "GitSourceControlStateCache.h"
 
 class FGitSourceControlCommand;
 
+/** Stats of the provider, its worker threads and its caches ("stat GitSourceControl") */
+DECLARE_STATS_GROUP(TEXT("GitSourceControl"), STATGROUP_GitSourceControl, STATCAT_Advanced);
+
 DECLARE_DELEGATE_RetVal(FGitSourceControlWorkerRef, FGetGitSourceControlWorker)
 
+/** Delegate called with the files whose state really changed in the cache (absolute paths) */
+DECLARE_MULTICAST_DELEGATE_OneParam(FGitSourceControlFilesChanged, const TArray<FString>& /*InChangedFiles*/);
+
 /// Git version and capabilites extracted from the string "git version 2.11.0.windows.3"
 struct FGitVersion
 {
@@ -29,6 +38,14 @@ struct FGitVersion
 	uint32 bHasCatFileWithFilters : 1;
 	uint32 bHasGitLfs : 1;
 	uint32 bHasGitLfsLocking : 1;
+	uint32 bHasGitLfsMultiPathLocking : 1;
+	uint32 bHasPathspecFromFile : 1;
+	uint32 bHasRmPathspecFromFile : 1;
+	uint32 bHasStatusPorcelainV2 : 1;
+	uint32 bHasFsMonitorDaemon : 1;
+	uint32 bHasUntrackedCache : 1;
+	uint32 bHasFeatureManyFiles : 1;
+	uint32 bHasIndexV4 : 1;
 
 	FGitVersion() 
 		: Major(0)
@@ -38,6 +55,14 @@ struct FGitVersion
 		, bHasCatFileWithFilters(false)
 		, bHasGitLfs(false)
 		, bHasGitLfsLocking(false)
+		, bHasGitLfsMultiPathLocking(false)
+		, bHasPathspecFromFile(false)
+		, bHasRmPathspecFromFile(false)
+		, bHasStatusPorcelainV2(false)
+		, bHasFsMonitorDaemon(false)
+		, bHasUntrackedCache(false)
+		, bHasFeatureManyFiles(false)
+		, bHasIndexV4(false)
 	{
 	}
 
@@ -129,7 +154,13 @@ public:
 		return RemoteUrl;
 	}
 
-	/** Helper function used to update state cache */
+	/** Tracker of the files modified on disk since their status was last queried */
+	inline FGitSourceControlChangeTracker& GetChangeTracker()
+	{
+		return ChangeTracker;
+	}
+
+	/** Helper function used to update state cache (thread-safe: also called by the worker threads) */
 	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> GetStateInternal(const FString& Filename);
 
 	/**
@@ -144,6 +175,50 @@ public:
 	/** Get files in cache */
 	TArray<FString> GetFilesInCache();
 
+	/** State cache, to update the states of files along with its indexes */
+	inline FGitSourceControlStateCache& GetStateCache()
+	{
+		return StateCache;
+	}
+
+	/**
+	 * Typed alternatives to GetCachedStateByPredicate(), answered from the indexes of the state cache:
+	 * they cost the number of files returned instead of a scan of the whole cache (except for the Unknown, Unchanged and NotLocked states).
+	 */
+	TArray<FSourceControlStateRef> GetCachedStatesByWorkingCopyState(const EWorkingCopyState::Type InWorkingCopyState) const;
+	TArray<FSourceControlStateRef> GetCachedStatesByLockState(const ELockState::Type InLockState) const;
+
+	/** Cached states of all the files IsModified() ("all modified" view, and files to check-in) */
+	TArray<FSourceControlStateRef> GetModifiedCachedStates() const;
+
+	/** Cached states of all the files IsCheckedOut(): locked by the user with Git LFS, else all the tracked files (scan) */
+	TArray<FSourceControlStateRef> GetCheckedOutCachedStates() const;
+
+	/** Cached states of all the files IsConflicted() */
+	TArray<FSourceControlStateRef> GetConflictedCachedStates() const;
+
+	/** Fill the state cache from the snapshot saved at the last close, if still valid, to show the icons before the first status completes */
+	bool LoadStateSnapshot();
+
+	/** Save the state cache to a snapshot for the next startup */
+	bool SaveStateSnapshot() const;
+
+	/** Get (and forget) the files loaded from the snapshot whose status must be queried again by the "Connect" operation (thread-safe) */
+	TArray<FString> TakeFilesToReconcile();
+
+	/**
+	 * Register to be notified of the files whose state changed, to refresh only them,
+	 * along with the global OnSourceControlStateChanged notification (called once per tick, only if a state changed).
+	 */
+	FDelegateHandle RegisterFilesChanged(const FGitSourceControlFilesChanged::FDelegate& InFilesChanged);
+	void UnregisterFilesChanged(FDelegateHandle InHandle);
+
+	/**
+	 * Queue new states of files, to be applied to the state cache by Tick() within the budget of each frame (thread-safe).
+	 * The completion delegate of a command runs only once all the states it queued are applied.
+	 */
+	void QueueStates(const TArray<FGitSourceControlState>& InStates, const FDateTime& InTimeStamp);
+
 private:
 
 	/** Is git binary found and working. */
@@ -158,6 +233,14 @@ private:
 	/** Helper function for Execute() */
 	TSharedPtr<class IGitSourceControlWorker, ESPMode::ThreadSafe> CreateWorker(const FName& InOperationName) const;
 
+	/**
+	 * Merge an asynchronous "UpdateStatus" request into a command already issued, instead of issuing one more command:
+	 * - dropped if a queued or running command already queries all of its files, sharing the results of this command,
+	 * - else merged into a command still waiting for a worker thread.
+	 * @return true if the request was coalesced, and will be completed along with the command
+	 */
+	bool CoalesceUpdateStatus(const TSharedRef<ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const TArray<FString>& InFiles, const FSourceControlOperationComplete& InOperationCompleteDelegate);
+
 	/** Helper function for running command synchronously. */
 	ECommandResult::Type ExecuteSynchronousCommand(class FGitSourceControlCommand& InCommand, const FText& Task);
 	/** Issue a command asynchronously if possible. */
@@ -169,6 +252,15 @@ private:
 	/** Update repository status on Connect and UpdateStatus operations */
 	void UpdateRepositoryStatus(const class FGitSourceControlCommand& InCommand);
 
+	/**
+	 * Apply the queued states to the state cache, in order, until the given time.
+	 * @return true if all the states queued so far are applied
+	 */
+	bool ApplyQueuedStates(const double InEndTime);
+
+	/** Run the completion delegate of a command whose states are all applied, and delete it if auto-deleted */
+	void FinishCommand(class FGitSourceControlCommand& InCommand);
+
 	/** Path to the root of the Git repository: can be the ProjectDir itself, or any parent directory (found by the "Connect" operation) */
 	FString PathToRepositoryRoot;
 
@@ -190,8 +282,8 @@ private:
 	/** Current Commit description's Summary */
 	FString CommitSummary;
 
-	/** State cache */
-	TMap<FString, TSharedRef<class FGitSourceControlState, ESPMode::ThreadSafe> > StateCache;
+	/** State cache, shared by the game thread and the worker threads */
+	FGitSourceControlStateCache StateCache;
 
 	/** The currently registered source control operations */
 	TMap<FName, FGetGitSourceControlWorker> WorkersMap;
@@ -199,12 +291,53 @@ private:
 	/** Queue for commands given by the main thread */
 	TArray < FGitSourceControlCommand* > CommandQueue;
 
+	/** Commands finished by their worker thread, waiting for their results to be processed by Tick() within the budget of the frame */
+	TArray<FGitSourceControlCommand*> CompletedCommands;
+
+	/** Command whose states are being applied to the cache, its results to be returned once they are all applied */
+	FGitSourceControlCommand* CommandApplyingStates = nullptr;
+
+	/** Number of states queued before the command applying its states, included: all applied once NumStatesApplied reaches it */
+	uint64 CommandStatesEnd = 0;
+
+	/** States queued by the commands and the locks worker (with their time stamp), applied from the index QueuedStatesIndex on */
+	TArray<FGitSourceControlState> QueuedStates;
+	int32 QueuedStatesIndex = 0;
+
+	/** Total number of states queued and applied since the start (the difference is the number of states still queued) */
+	uint64 NumStatesQueued = 0;
+	uint64 NumStatesApplied = 0;
+
+	/** Number of frames spent applying the states queued so far */
+	int32 NumFramesApplyingStates = 0;
+
+	/** Guards the queue of states, filled by the locks worker thread */
+	FCriticalSection QueuedStatesCriticalSection;
+
+	/** Files whose state changed when applying the queued states, notified at the end of the tick */
+	TSet<FString> ChangedFiles;
+
+	/** Number of "UpdateStatus" requests coalesced into another command */
+	int32 NumCoalescedUpdateStatus = 0;
+
 	/** For notifying when the source control states in the cache have changed */
 	FSourceControlStateChanged OnSourceControlStateChanged;
 
+	/** For notifying which files changed state in the cache */
+	FGitSourceControlFilesChanged OnFilesChanged;
+
 	/** Git version for feature checking */
 	FGitVersion GitVersion;
 
+	/** Files modified on disk since their status was last queried */
+	FGitSourceControlChangeTracker ChangeTracker;
+
+	/** Files loaded from the snapshot modified, in conflict or locked, to query again at "Connect" */
+	TArray<FString> FilesToReconcile;
+
+	/** Guards FilesToReconcile, taken by the worker thread of the "Connect" operation */
+	FCriticalSection FilesToReconcileCriticalSection;
+
 	/** Source Control Menu Extension */
 	FGitSourceControlMenu GitSourceControlMenu;
 };
@@ -0,0 +1,183 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlRefs.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "GitSourceControlUtils.h"
+
+namespace GitRefsConstants
+{
+
+/** Prefix of a symbolic ref, like the content of ".git/HEAD" when on a branch */
+static const FString SymbolicRefPrefix = TEXT("ref: ");
+
+/** Prefix of the ref of a local branch */
+static const FString BranchRefPrefix = TEXT("refs/heads/");
+
+/** Maximum number of symbolic refs to follow */
+static const int32 MaxRefDepth = 5;
+
+}
+
+FGitRefsCache& FGitRefsCache::Get()
+{
+	static FGitRefsCache Instance;
+	return Instance;
+}
+
+bool FGitRefsCache::GetHead(const FString& InRepositoryRoot, FGitHeadInfo& OutHead)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	FCachedHead* CachedHead = Heads.Find(InRepositoryRoot);
+	if(CachedHead != nullptr && IsUpToDate(*CachedHead))
+	{
+		OutHead = CachedHead->Head;
+		return true;
+	}
+
+	FCachedHead NewHead;
+	if(!ReadHead(InRepositoryRoot, NewHead))
+	{
+		Heads.Remove(InRepositoryRoot);
+		return false;
+	}
+	if(CachedHead != nullptr && CachedHead->Head.CommitId == NewHead.Head.CommitId)
+	{
+		// Same commit on another branch: keep its summary
+		NewHead.Head.CommitSummary = CachedHead->Head.CommitSummary;
+	}
+
+	OutHead = NewHead.Head;
+	Heads.Add(InRepositoryRoot, MoveTemp(NewHead));
+	return true;
+}
+
+void FGitRefsCache::SetCommitSummary(const FString& InRepositoryRoot, const FString& InCommitId, const FString& InCommitSummary)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+
+	FCachedHead* CachedHead = Heads.Find(InRepositoryRoot);
+	if(CachedHead != nullptr && CachedHead->Head.CommitId == InCommitId)
+	{
+		CachedHead->Head.CommitSummary = InCommitSummary;
+	}
+}
+
+void FGitRefsCache::Reset()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Heads.Reset();
+}
+
+bool FGitRefsCache::ReadHead(const FString& InRepositoryRoot, FCachedHead& OutCachedHead)
+{
+	using namespace GitRefsConstants;
+
+	const FString GitDirectory = GitSourceControlUtils::GetGitDirectory(InRepositoryRoot);
+	if(GitDirectory.IsEmpty())
+	{
+		return false;
+	}
+
+	// Refs are shared by all the worktrees of a repository: they are in the "common" Git directory
+	FString CommonDir = GitDirectory;
+	FString CommonDirContent;
+	if(FFileHelper::LoadFileToString(CommonDirContent, *(GitDirectory / TEXT("commondir"))))
+	{
+		CommonDir = FPaths::ConvertRelativePathToFull(GitDirectory, CommonDirContent.TrimStartAndEnd());
+	}
+
+	const FString HeadFile = GitDirectory / TEXT("HEAD");
+	FString HeadContent;
+	OutCachedHead.Timestamps.Add(HeadFile, IFileManager::Get().GetTimeStamp(*HeadFile));
+	if(!FFileHelper::LoadFileToString(HeadContent, *HeadFile))
+	{
+		return false;
+	}
+	HeadContent.TrimStartAndEndInline();
+
+	FGitHeadInfo& Head = OutCachedHead.Head;
+	if(HeadContent.StartsWith(SymbolicRefPrefix))
+	{
+		const FString RefName = HeadContent.RightChop(SymbolicRefPrefix.Len());
+		Head.BranchName = RefName.StartsWith(BranchRefPrefix) ? RefName.RightChop(BranchRefPrefix.Len()) : RefName;
+		// A branch without commit yet (before the initial commit) has no ref file
+		ResolveRef(CommonDir, RefName, OutCachedHead);
+	}
+	else
+	{
+		Head.bDetached = true;
+		Head.CommitId = HeadContent;
+		Head.BranchName = TEXT("HEAD detached at ");
+		Head.BranchName += HeadContent.Left(7);
+	}
+
+	return true;
+}
+
+bool FGitRefsCache::ResolveRef(const FString& InCommonDir, const FString& InRefName, FCachedHead& InOutCachedHead, const int32 InDepth)
+{
+	using namespace GitRefsConstants;
+
+	if(InDepth > MaxRefDepth)
+	{
+		return false;
+	}
+
+	// Loose ref file first: it has precedence over the "packed-refs" file
+	const FString LooseRefFile = InCommonDir / InRefName;
+	InOutCachedHead.Timestamps.Add(LooseRefFile, IFileManager::Get().GetTimeStamp(*LooseRefFile));
+	FString RefContent;
+	if(FFileHelper::LoadFileToString(RefContent, *LooseRefFile))
+	{
+		RefContent.TrimStartAndEndInline();
+		if(RefContent.StartsWith(SymbolicRefPrefix))
+		{
+			return ResolveRef(InCommonDir, RefContent.RightChop(SymbolicRefPrefix.Len()), InOutCachedHead, InDepth + 1);
+		}
+		InOutCachedHead.Head.CommitId = MoveTemp(RefContent);
+		return true;
+	}
+
+	// "packed-refs": a header line "# pack-refs with: ...", then "<sha1> <refname>" lines, each one optionally followed by a "^<sha1>" peeled tag line
+	const FString PackedRefsFile = InCommonDir / TEXT("packed-refs");
+	InOutCachedHead.Timestamps.Add(PackedRefsFile, IFileManager::Get().GetTimeStamp(*PackedRefsFile));
+	TArray<FString> PackedRefs;
+	if(FFileHelper::LoadFileToStringArray(PackedRefs, *PackedRefsFile))
+	{
+		for(const FString& PackedRef : PackedRefs)
+		{
+			if(PackedRef.StartsWith(TEXT("#")) || PackedRef.StartsWith(TEXT("^")))
+			{
+				continue;
+			}
+			int32 SpaceIndex;
+			if(PackedRef.FindChar(TEXT(' '), SpaceIndex) && FCString::Strcmp(*PackedRef + SpaceIndex + 1, *InRefName) == 0)
+			{
+				InOutCachedHead.Head.CommitId = PackedRef.Left(SpaceIndex);
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool FGitRefsCache::IsUpToDate(const FCachedHead& InCachedHead)
+{
+	for(const TPair<FString, FDateTime>& Timestamp : InCachedHead.Timestamps)
+	{
+		if(IFileManager::Get().GetTimeStamp(*Timestamp.Key) != Timestamp.Value)
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Current branch and commit of a repository */
+struct FGitHeadInfo
+{
+	/** Short name of the current branch ("main"), or "HEAD detached at <commit>" */
+	FString BranchName;
+
+	/** Full SHA1 of the current commit, empty on an unborn branch (before the initial commit) */
+	FString CommitId;
+
+	/** Summary line of the message of the current commit, empty if not known yet */
+	FString CommitSummary;
+
+	/** Is HEAD detached (not on a branch) */
+	bool bDetached = false;
+};
+
+/**
+ * Native reader of the HEAD of each repository (and submodule), without spawning Git.
+ *
+ * Reads ".git/HEAD", then the loose ref file or "packed-refs" of the current branch,
+ * and caches the result until the modification time of one of those files changes.
+ * The summary of the commit cannot be read natively (objects are compressed): it is stored by GetCommitInfo() once known.
+ */
+class FGitRefsCache
+{
+public:
+	static FGitRefsCache& Get();
+
+	/** Get the current branch and commit of the repository (thread-safe) */
+	bool GetHead(const FString& InRepositoryRoot, FGitHeadInfo& OutHead);
+
+	/** Remember the summary of a commit, to be returned with the HEAD as long as it does not move */
+	void SetCommitSummary(const FString& InRepositoryRoot, const FString& InCommitId, const FString& InCommitSummary);
+
+	/** Forget all the cached information */
+	void Reset();
+
+private:
+	FGitRefsCache() = default;
+
+	/** HEAD of a repository, and the modification times of the files it was read from */
+	struct FCachedHead
+	{
+		FGitHeadInfo Head;
+		TMap<FString, FDateTime> Timestamps;
+	};
+
+	/** Read the HEAD of a repository from its files */
+	static bool ReadHead(const FString& InRepositoryRoot, FCachedHead& OutCachedHead);
+
+	/** Resolve a ref name ("refs/heads/main") to a commit, from its loose file or the "packed-refs" file */
+	static bool ResolveRef(const FString& InCommonDir, const FString& InRefName, FCachedHead& InOutCachedHead, const int32 InDepth = 0);
+
+	/** Tell if all the files the HEAD was read from are unchanged */
+	static bool IsUpToDate(const FCachedHead& InCachedHead);
+
+	/** Guards the map of cached HEADs */
+	FCriticalSection CriticalSection;
+
+	/** HEAD of each repository */
+	TMap<FString, FCachedHead> Heads;
+};
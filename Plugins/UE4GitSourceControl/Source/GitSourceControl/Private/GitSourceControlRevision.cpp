@@ -10,6 +10,7 @@
 #include "Modules/ModuleManager.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlUtils.h"
+#include "GitSourceControlFileExistenceCache.h"
 
 #define LOCTEXT_NAMESPACE "GitSourceControl"
 
@@ -43,12 +44,13 @@ bool FGitSourceControlRevision::Get( FString& InOutFilename ) const
 		TArray<FString> AllProjects;
 		GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 		AllProjects.Add(TEXT(""));
+		FGitFileExistenceCache ExistenceCache;
 		for (const auto& Sub : AllProjects) {
 			FString TempRoot = PathToRepositoryRoot;
 			if(Sub != TEXT("")) TempRoot += TEXT("/") + Sub;
 			FString AbsFilename = TempRoot + TEXT("/") + Filename;
 			//UE_LOG(LogSourceControl, Error, TEXT("Dump Abs file name is: %s"), *AbsFilename);
-			if (FPaths::FileExists(AbsFilename)) {
+			if (ExistenceCache.FileExists(AbsFilename)) {
 				PathToRepositoryRoot = TempRoot;
 				break;
 			}
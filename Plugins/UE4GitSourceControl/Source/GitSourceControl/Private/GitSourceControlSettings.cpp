@@ -71,6 +71,20 @@ bool FGitSourceControlSettings::SetUsingGitLfsLocking(const bool InUsingGitLfsLo
 	return bChanged;
 }
 
+bool FGitSourceControlSettings::IsUsingStatusAcceleration() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bUsingStatusAcceleration;
+}
+
+bool FGitSourceControlSettings::SetUsingStatusAcceleration(const bool InUsingStatusAcceleration)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const bool bChanged = (bUsingStatusAcceleration != InUsingStatusAcceleration);
+	bUsingStatusAcceleration = InUsingStatusAcceleration;
+	return bChanged;
+}
+
 const FString FGitSourceControlSettings::GetLfsUserName() const
 {
 	FScopeLock ScopeLock(&CriticalSection);
@@ -88,6 +102,23 @@ bool FGitSourceControlSettings::SetLfsUserName(const FString& InString)
 	return bChanged;
 }
 
+const FString FGitSourceControlSettings::GetLfsLocksUrl() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return LfsLocksUrl; // Return a copy to be thread-safe
+}
+
+bool FGitSourceControlSettings::SetLfsLocksUrl(const FString& InString)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const bool bChanged = (LfsLocksUrl != InString);
+	if (bChanged)
+	{
+		LfsLocksUrl = InString;
+	}
+	return bChanged;
+}
+
 // This is called at startup nearly before anything else in our module: BinaryPath will then be used by the provider
 void FGitSourceControlSettings::LoadSettings()
 {
@@ -95,7 +126,9 @@ void FGitSourceControlSettings::LoadSettings()
 	const FString& IniFile = SourceControlHelpers::GetSettingsIni();
 	GConfig->GetString(*GitSettingsConstants::SettingsSection, TEXT("BinaryPath"), BinaryPath, IniFile);
 	GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("UsingGitLfsLocking"), bUsingGitLfsLocking, IniFile);
+	GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("UsingStatusAcceleration"), bUsingStatusAcceleration, IniFile);
 	GConfig->GetString(*GitSettingsConstants::SettingsSection, TEXT("LfsUserName"), LfsUserName, IniFile);
+	GConfig->GetString(*GitSettingsConstants::SettingsSection, TEXT("LfsLocksUrl"), LfsLocksUrl, IniFile);
 	GConfig->GetString(*GitSettingsConstants::SettingsSection, TEXT("RepositoryPath"), RepositoryRootPath, IniFile);
 }
 
@@ -105,6 +138,8 @@ void FGitSourceControlSettings::SaveSettings() const
 	const FString& IniFile = SourceControlHelpers::GetSettingsIni();
 	GConfig->SetString(*GitSettingsConstants::SettingsSection, TEXT("BinaryPath"), *BinaryPath, IniFile);
 	GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("UsingGitLfsLocking"), bUsingGitLfsLocking, IniFile);
+	GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("UsingStatusAcceleration"), bUsingStatusAcceleration, IniFile);
 	GConfig->SetString(*GitSettingsConstants::SettingsSection, TEXT("LfsUserName"), *LfsUserName, IniFile);
+	GConfig->SetString(*GitSettingsConstants::SettingsSection, TEXT("LfsLocksUrl"), *LfsLocksUrl, IniFile);
 	GConfig->SetString(*GitSettingsConstants::SettingsSection, TEXT("RepositoryPath"), *RepositoryRootPath, IniFile);
 }
@@ -28,12 +28,24 @@ public:
 	/** Configure the usage of Git LFS file Locking workflow */
 	bool SetUsingGitLfsLocking(const bool InUsingGitLfsLocking);
 
+	/** Tell if the repository and its submodules are configured to speed up "git status" at Connect */
+	bool IsUsingStatusAcceleration() const;
+
+	/** Configure the repository and its submodules to speed up "git status" (file system monitor, untracked cache...) */
+	bool SetUsingStatusAcceleration(const bool InUsingStatusAcceleration);
+
 	/** Get the username used by the Git LFS 2 File Locks server */
 	const FString GetLfsUserName() const;
 
 	/** Set the username used by the Git LFS 2 File Locks server */
 	bool SetLfsUserName(const FString& InString);
 
+	/** Get the URL of the Git LFS locking API of the repository, overriding the one derived from the Git configuration (empty for none) */
+	const FString GetLfsLocksUrl() const;
+
+	/** Set the URL of the Git LFS locking API of the repository (empty to derive it from the Git configuration) */
+	bool SetLfsLocksUrl(const FString& InString);
+
 	/** Load settings from ini file */
 	void LoadSettings();
 
@@ -53,6 +65,12 @@ private:
 	/** Tells if using the Git LFS file Locking workflow */
 	bool bUsingGitLfsLocking;
 
+	/** Tells if the repository is configured to speed up "git status" */
+	bool bUsingStatusAcceleration = false;
+
 	/** Username used by the Git LFS 2 File Locks server */
 	FString LfsUserName;
+
+	/** URL of the Git LFS locking API, like "https://example.com/org/repo.git/info/lfs" */
+	FString LfsLocksUrl;
 };
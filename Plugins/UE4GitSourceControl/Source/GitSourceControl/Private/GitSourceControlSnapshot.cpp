@@ -0,0 +1,283 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlSnapshot.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlIndex.h"
+#include "GitSourceControlRefs.h"
+#include "GitSourceControlStateCache.h"
+#include "GitSourceControlUtils.h"
+
+namespace GitSnapshotConstants
+{
+
+/** "GSCS" */
+static const uint32 Magic = 0x53435347;
+
+/** Version of the format, to be incremented on each change of the layout below */
+static const uint32 Version = 1;
+
+/** Size of the header: magic, version, size and CRC of the payload */
+static const int64 HeaderSize = 4 + 4 + 8 + 4;
+
+/** No user in the table of lock owners */
+static const int32 NoUser = -1;
+
+}
+
+/**
+ * Layout of the snapshot file (little-endian):
+ * - header: magic, version, payload size (int64) and CRC32 of the payload,
+ * - payload: key (HEAD commits and index checksums), table of the users owning locks,
+ *   then for each file: path relative to the repository root, working copy state, lock state, index of the lock owner, and merge base if any.
+ */
+FString FGitSourceControlSnapshot::GetSnapshotFile()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir()) / TEXT("GitSourceControl") / TEXT("StateSnapshot.bin");
+}
+
+FString FGitSourceControlSnapshot::ComputeKey(const FString& InRepositoryRoot)
+{
+	TArray<FString> RepositoryRoots;
+	RepositoryRoots.Add(InRepositoryRoot);
+	TArray<FString> SubModules;
+	GitSourceControlUtils::GetSubModulesRoots(SubModules);
+	for(const FString& SubModule : SubModules)
+	{
+		RepositoryRoots.Add(InRepositoryRoot / SubModule);
+	}
+
+	FString Key;
+	for(const FString& RepositoryRoot : RepositoryRoots)
+	{
+		FGitHeadInfo Head;
+		const TSharedPtr<const FGitIndex, ESPMode::ThreadSafe> Index = FGitIndexCache::Get().GetIndex(RepositoryRoot);
+		if(!FGitRefsCache::Get().GetHead(RepositoryRoot, Head) || !Index.IsValid())
+		{
+			// Without a reliable key, never use a snapshot
+			return FString();
+		}
+		Key += FString::Printf(TEXT("%s:%s:%s;"), *RepositoryRoot, *Head.CommitId, *Index->GetChecksum());
+	}
+	return Key;
+}
+
+bool FGitSourceControlSnapshot::Save(const FString& InRepositoryRoot, const FGitSourceControlStateCache& InStateCache)
+{
+	using namespace GitSnapshotConstants;
+
+	const double StartTime = FPlatformTime::Seconds();
+	FString Key = ComputeKey(InRepositoryRoot);
+	if(Key.IsEmpty())
+	{
+		return false;
+	}
+
+	TArray<FGitSourceControlStateRef> States;
+	InStateCache.GetStates(States);
+
+	const FString RootPrefix = InRepositoryRoot.EndsWith(TEXT("/")) ? InRepositoryRoot : InRepositoryRoot + TEXT("/");
+	TArray<FString> Users;
+	TMap<FGitLockUser, int32> UserIndexes;
+
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	Writer << Key;
+
+	// Gather the table of users first, to write it before the files
+	for(const FGitSourceControlStateRef& State : States)
+	{
+		if(!State->LockUser.IsNone() && !UserIndexes.Contains(State->LockUser))
+		{
+			UserIndexes.Add(State->LockUser, Users.Add(State->LockUser.ToString()));
+		}
+	}
+	Writer << Users;
+
+	int32 NumFiles = 0;
+	const int64 NumFilesOffset = Writer.Tell();
+	Writer << NumFiles;
+	for(const FGitSourceControlStateRef& State : States)
+	{
+		// Only the files of the repository (and its submodules) whose status is known
+		if(State->WorkingCopyState == EWorkingCopyState::Unknown || !State->LocalFilename.StartsWith(RootPrefix))
+		{
+			continue;
+		}
+		FString RelativePath = State->LocalFilename.RightChop(RootPrefix.Len());
+		uint8 WorkingCopyState = State->WorkingCopyState;
+		uint8 LockState = State->LockState;
+		int32 UserIndex = State->LockUser.IsNone() ? NoUser : UserIndexes.FindChecked(State->LockUser);
+		uint8 bHasMergeBase = (State->PendingMergeBaseFileHash != FSHAHash()) ? 1 : 0;
+		Writer << RelativePath << WorkingCopyState << LockState << UserIndex << bHasMergeBase;
+		if(bHasMergeBase)
+		{
+			Writer << State->PendingMergeBaseFileHash;
+		}
+		++NumFiles;
+	}
+	const int64 EndOffset = Writer.Tell();
+	Writer.Seek(NumFilesOffset);
+	Writer << NumFiles;
+	Writer.Seek(EndOffset);
+
+	TArray<uint8> Content;
+	FMemoryWriter ContentWriter(Content);
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	int64 PayloadSize = Payload.Num();
+	uint32 PayloadCrc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+	ContentWriter << FileMagic << FileVersion << PayloadSize << PayloadCrc;
+	Content.Append(Payload);
+
+	const FString SnapshotFile = GetSnapshotFile();
+	if(!FFileHelper::SaveArrayToFile(Content, *SnapshotFile))
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("Cannot write the state snapshot '%s'"), *SnapshotFile);
+		return false;
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("State snapshot of %d files written in %.3lfs (%d bytes)"), NumFiles, FPlatformTime::Seconds() - StartTime, Content.Num());
+	return true;
+}
+
+bool FGitSourceControlSnapshot::Load(const FString& InRepositoryRoot, const bool bInUsingLfsLocking, FGitSourceControlStateCache& InOutStateCache, TArray<FString>& OutFilesToReconcile)
+{
+	const FString SnapshotFile = GetSnapshotFile();
+	if(!FPaths::FileExists(SnapshotFile))
+	{
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	bool bLoaded = false;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*SnapshotFile));
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	if(MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+	if(MappedRegion.IsValid())
+	{
+		bLoaded = Parse(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), InRepositoryRoot, bInUsingLfsLocking, InOutStateCache, OutFilesToReconcile);
+	}
+	else
+	{
+		// Platforms without memory-mapped files
+		TArray<uint8> Content;
+		if(FFileHelper::LoadFileToArray(Content, *SnapshotFile, FILEREAD_Silent))
+		{
+			bLoaded = Parse(Content.GetData(), Content.Num(), InRepositoryRoot, bInUsingLfsLocking, InOutStateCache, OutFilesToReconcile);
+		}
+	}
+
+	if(bLoaded)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("State snapshot loaded in %.3lfs (%d files to reconcile)"), FPlatformTime::Seconds() - StartTime, OutFilesToReconcile.Num());
+	}
+	return bLoaded;
+}
+
+void FGitSourceControlSnapshot::Delete()
+{
+	IFileManager::Get().Delete(*GetSnapshotFile(), false, false, true);
+}
+
+bool FGitSourceControlSnapshot::Parse(const uint8* InData, const int64 InSize, const FString& InRepositoryRoot, const bool bInUsingLfsLocking, FGitSourceControlStateCache& InOutStateCache, TArray<FString>& OutFilesToReconcile)
+{
+	using namespace GitSnapshotConstants;
+
+	if(InSize < HeaderSize)
+	{
+		return false;
+	}
+	FLargeMemoryReader HeaderReader(InData, HeaderSize);
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	int64 PayloadSize = 0;
+	uint32 PayloadCrc = 0;
+	HeaderReader << FileMagic << FileVersion << PayloadSize << PayloadCrc;
+	if(FileMagic != Magic || FileVersion != Version || PayloadSize != InSize - HeaderSize)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("State snapshot ignored: version %u not supported"), FileVersion);
+		return false;
+	}
+	const uint8* Payload = InData + HeaderSize;
+	if(FCrc::MemCrc32(Payload, PayloadSize) != PayloadCrc)
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("State snapshot ignored: corrupted"));
+		return false;
+	}
+
+	FLargeMemoryReader Reader(Payload, PayloadSize);
+	FString Key;
+	Reader << Key;
+	if(Key.IsEmpty() || Key != ComputeKey(InRepositoryRoot))
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("State snapshot ignored: the HEAD or the index changed since it was written"));
+		return false;
+	}
+
+	TArray<FString> Users;
+	Reader << Users;
+	TArray<FGitLockUser> UserNames;
+	for(const FString& User : Users)
+	{
+		UserNames.Add(FGitLockUser(User));
+	}
+
+	int32 NumFiles = 0;
+	Reader << NumFiles;
+	const FString RootPrefix = InRepositoryRoot.EndsWith(TEXT("/")) ? InRepositoryRoot : InRepositoryRoot + TEXT("/");
+	const FDateTime NoTimeStamp;
+	for(int32 Index = 0; Index < NumFiles && !Reader.IsError(); ++Index)
+	{
+		FString RelativePath;
+		uint8 WorkingCopyState = 0;
+		uint8 LockState = 0;
+		int32 UserIndex = NoUser;
+		uint8 bHasMergeBase = 0;
+		Reader << RelativePath << WorkingCopyState << LockState << UserIndex << bHasMergeBase;
+		FGitSourceControlState State(RootPrefix + RelativePath, bInUsingLfsLocking);
+		if(bHasMergeBase)
+		{
+			Reader << State.PendingMergeBaseFileHash;
+		}
+		if(Reader.IsError() || WorkingCopyState > EWorkingCopyState::Ignored || LockState > ELockState::LockedOther || !(UserIndex == NoUser || UserNames.IsValidIndex(UserIndex)))
+		{
+			break;
+		}
+		State.WorkingCopyState = static_cast<EWorkingCopyState::Type>(WorkingCopyState);
+		State.LockState = static_cast<ELockState::Type>(LockState);
+		if(UserIndex != NoUser)
+		{
+			State.LockUser = UserNames[UserIndex];
+		}
+
+		// The status of the directories at Connect lists the files modified since, but not the files reverted or unlocked since
+		if(State.WorkingCopyState != EWorkingCopyState::Unchanged || (State.LockState != ELockState::NotLocked && State.LockState != ELockState::Unknown))
+		{
+			OutFilesToReconcile.Add(State.LocalFilename);
+		}
+
+		// Keep the states already queried since startup, if any
+		if(!InOutStateCache.Find(State.LocalFilename).IsValid())
+		{
+			InOutStateCache.Update(State, NoTimeStamp);
+		}
+	}
+
+	return !Reader.IsError();
+}
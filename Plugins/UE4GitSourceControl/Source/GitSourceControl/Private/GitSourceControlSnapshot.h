@@ -0,0 +1,44 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FGitSourceControlStateCache;
+
+/**
+ * Persistent snapshot of the state cache (working copy states and lock ownership), saved in Saved/ when the provider is closed,
+ * and loaded at the next startup to show the source control icons before the first "git status" completes.
+ *
+ * The snapshot is a versioned binary file, valid only for the same HEAD commit and the same content of the index,
+ * of the repository and of each submodule: it is ignored as soon as one of them changed.
+ * Files loaded in a state other than unchanged, or locked, are reported by Load() so that the "Connect" operation queries them again.
+ */
+class FGitSourceControlSnapshot
+{
+public:
+	/** Path of the snapshot file of the project */
+	static FString GetSnapshotFile();
+
+	/** Write the known states of the cache to the snapshot file */
+	static bool Save(const FString& InRepositoryRoot, const FGitSourceControlStateCache& InStateCache);
+
+	/**
+	 * Memory-map the snapshot file, and fill the cache with its states if it matches the current HEAD and index.
+	 * @param	OutFilesToReconcile	Files loaded modified, in conflict or locked, whose status must be queried again
+	 */
+	static bool Load(const FString& InRepositoryRoot, const bool bInUsingLfsLocking, FGitSourceControlStateCache& InOutStateCache, TArray<FString>& OutFilesToReconcile);
+
+	/** Delete the snapshot file */
+	static void Delete();
+
+private:
+	/** Key of the current HEAD commit and index of the repository and of its submodules */
+	static FString ComputeKey(const FString& InRepositoryRoot);
+
+	/** Parse the content of the snapshot file */
+	static bool Parse(const uint8* InData, const int64 InSize, const FString& InRepositoryRoot, const bool bInUsingLfsLocking, FGitSourceControlStateCache& InOutStateCache, TArray<FString>& OutFilesToReconcile);
+};
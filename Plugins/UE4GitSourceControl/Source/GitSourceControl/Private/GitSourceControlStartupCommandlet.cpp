@@ -0,0 +1,73 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlStartupCommandlet.h"
+
+#include "HAL/PlatformTime.h"
+#include "Modules/ModuleManager.h"
+#include "ISourceControlModule.h"
+#include "SourceControlOperations.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlSnapshot.h"
+
+/** Timings of one startup of the provider */
+struct FGitStartupTimings
+{
+	/** Time to initialize the provider, until the first states are shown (loaded from the snapshot, if any) */
+	double InitSeconds = 0.0;
+	int32 NumStatesAfterInit = 0;
+
+	/** Time of the "Connect" operation, until all the states are up to date */
+	double ConnectSeconds = 0.0;
+	int32 NumStatesAfterConnect = 0;
+};
+
+static bool RunStartup(FGitSourceControlProvider& InProvider, FGitStartupTimings& OutTimings)
+{
+	double StartTime = FPlatformTime::Seconds();
+	InProvider.Init(true);
+	OutTimings.InitSeconds = FPlatformTime::Seconds() - StartTime;
+	OutTimings.NumStatesAfterInit = InProvider.GetStateCache().Num();
+	if(!InProvider.IsAvailable())
+	{
+		return false;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	const ECommandResult::Type Result = InProvider.Execute(ISourceControlOperation::Create<FConnect>(), TArray<FString>(), EConcurrency::Synchronous);
+	OutTimings.ConnectSeconds = FPlatformTime::Seconds() - StartTime;
+	OutTimings.NumStatesAfterConnect = InProvider.GetStateCache().Num();
+	return (Result == ECommandResult::Succeeded);
+}
+
+int32 UGitSourceControlStartupCommandlet::Main(const FString& Params)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::LoadModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
+
+	// Cold startup: no snapshot, the states are known only once the full status of "Connect" completes
+	Provider.Close();
+	FGitSourceControlSnapshot::Delete();
+	FGitStartupTimings ColdTimings;
+	if(!RunStartup(Provider, ColdTimings))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("GitSourceControlStartup: cannot connect to the Git repository of the project"));
+		return 1;
+	}
+
+	// Close the provider, saving the snapshot, then warm startup
+	Provider.Close();
+	FGitStartupTimings WarmTimings;
+	if(!RunStartup(Provider, WarmTimings))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("GitSourceControlStartup: cannot connect again to the Git repository of the project"));
+		return 1;
+	}
+
+	UE_LOG(LogSourceControl, Display, TEXT("Startup of the Git provider:"));
+	UE_LOG(LogSourceControl, Display, TEXT("  cold: %5d states after init in %.3lfs, %5d states after Connect in %.3lfs"), ColdTimings.NumStatesAfterInit, ColdTimings.InitSeconds, ColdTimings.NumStatesAfterConnect, ColdTimings.ConnectSeconds);
+	UE_LOG(LogSourceControl, Display, TEXT("  warm: %5d states after init in %.3lfs, %5d states after Connect in %.3lfs"), WarmTimings.NumStatesAfterInit, WarmTimings.InitSeconds, WarmTimings.NumStatesAfterConnect, WarmTimings.ConnectSeconds);
+	return 0;
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "GitSourceControlStartupCommandlet.generated.h"
+
+/**
+ * Measure the cold and warm startup of the Git provider: the time until the states of the files are known,
+ * without a snapshot (full status at "Connect"), then with the snapshot saved when closing the provider.
+ *
+ * Usage: UE4Editor-Cmd.exe <Project>.uproject -run=GitSourceControlStartup
+ */
+UCLASS()
+class UGitSourceControlStartupCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	virtual int32 Main(const FString& Params) override;
+};
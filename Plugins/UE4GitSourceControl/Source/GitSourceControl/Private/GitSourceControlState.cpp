@@ -5,8 +5,71 @@
 
 #include "GitSourceControlState.h"
 
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+
 #define LOCTEXT_NAMESPACE "GitSourceControl.State"
 
+/** Case-sensitive keys for the table of users (the default ones of FString ignore the case) */
+struct FGitLockUserKeyFuncs : BaseKeyFuncs<TPair<FString, int32>, FString, false>
+{
+	static const FString& GetSetKey(const TPair<FString, int32>& InElement)
+	{
+		return InElement.Key;
+	}
+	static bool Matches(const FString& InA, const FString& InB)
+	{
+		return InA.Equals(InB, ESearchCase::CaseSensitive);
+	}
+	static uint32 GetKeyHash(const FString& InKey)
+	{
+		return FCrc::StrCrc32(*InKey);
+	}
+};
+
+/** Table of the names of the users locking files, never shrinking (there are only a few users) */
+struct FGitLockUserTable
+{
+	FCriticalSection CriticalSection;
+	TArray<FString> Names;
+	TMap<FString, int32, FDefaultSetAllocator, FGitLockUserKeyFuncs> Indexes;
+
+	static FGitLockUserTable& Get()
+	{
+		static FGitLockUserTable Table;
+		return Table;
+	}
+};
+
+FGitLockUser::FGitLockUser(const FString& InName)
+{
+	if(!InName.IsEmpty())
+	{
+		FGitLockUserTable& Table = FGitLockUserTable::Get();
+		FScopeLock ScopeLock(&Table.CriticalSection);
+		if(const int32* ExistingIndex = Table.Indexes.Find(InName))
+		{
+			Index = *ExistingIndex;
+		}
+		else
+		{
+			Index = Table.Names.Add(InName);
+			Table.Indexes.Add(InName, Index);
+		}
+	}
+}
+
+FString FGitLockUser::ToString() const
+{
+	if(Index == INDEX_NONE)
+	{
+		return FString();
+	}
+	FGitLockUserTable& Table = FGitLockUserTable::Get();
+	FScopeLock ScopeLock(&Table.CriticalSection);
+	return Table.Names[Index];
+}
+
 int32 FGitSourceControlState::GetHistorySize() const
 {
 	return History.Num();
@@ -46,10 +109,11 @@ TSharedPtr<class ISourceControlRevision, ESPMode::ThreadSafe> FGitSourceControlS
 
 TSharedPtr<class ISourceControlRevision, ESPMode::ThreadSafe> FGitSourceControlState::GetBaseRevForMerge() const
 {
+	const FString MergeBaseFileHash = PendingMergeBaseFileHash.ToString();
 	for(const auto& Revision : History)
 	{
 		// look for the the SHA1 id of the file, not the commit id (revision)
-		if(Revision->FileHash == PendingMergeBaseFileHash)
+		if(Revision->FileHash == MergeBaseFileHash)
 		{
 			return Revision;
 		}
@@ -58,6 +122,35 @@ TSharedPtr<class ISourceControlRevision, ESPMode::ThreadSafe> FGitSourceControlS
 	return nullptr;
 }
 
+void FGitSourceControlState::SetPendingMergeBaseFileHash(const FString& InFileHash)
+{
+	if(InFileHash.Len() == 2 * sizeof(PendingMergeBaseFileHash.Hash))
+	{
+		PendingMergeBaseFileHash.FromString(InFileHash);
+	}
+	else
+	{
+		PendingMergeBaseFileHash = FSHAHash();
+	}
+}
+
+bool FGitSourceControlState::HasSameStatus(const FGitSourceControlState& InOther) const
+{
+	// A new history (only queried on demand) is always a change
+	return InOther.History.Num() == 0
+		&& WorkingCopyState == InOther.WorkingCopyState
+		&& LockState == InOther.LockState
+		&& LockUser == InOther.LockUser
+		&& PendingMergeBaseFileHash == InOther.PendingMergeBaseFileHash
+		&& bUsingGitLfsLocking == InOther.bUsingGitLfsLocking
+		&& bNewerVersionOnServer == InOther.bNewerVersionOnServer;
+}
+
+SIZE_T FGitSourceControlState::GetAllocatedSize() const
+{
+	return LocalFilename.GetAllocatedSize() + History.GetAllocatedSize();
+}
+
 // @todo add Slate icons for git specific states (NotAtHead vs Conflicted...)
 FName FGitSourceControlState::GetIconName() const
 {
@@ -163,7 +256,7 @@ FText FGitSourceControlState::GetDisplayName() const
 	}
 	else if(LockState == ELockState::LockedOther)
 	{
-		return FText::Format( LOCTEXT("LockedOther", "Locked by "), FText::FromString(LockUser) );
+		return FText::Format( LOCTEXT("LockedOther", "Locked by "), FText::FromString(LockUser.ToString()) );
 	}
 	else if (!IsCurrent())
 	{
@@ -207,7 +300,7 @@ FText FGitSourceControlState::GetDisplayTooltip() const
 	}
 	else if(LockState == ELockState::LockedOther)
 	{
-		return FText::Format( LOCTEXT("LockedOther_Tooltip", "Locked for editing by: {0}"), FText::FromString(LockUser) );
+		return FText::Format( LOCTEXT("LockedOther_Tooltip", "Locked for editing by: {0}"), FText::FromString(LockUser.ToString()) );
 	}
 	else if (!IsCurrent())
 	{
@@ -303,7 +396,7 @@ bool FGitSourceControlState::IsCheckedOutOther(FString* Who) const
 {
 	if (Who != NULL)
 	{
-		*Who = LockUser;
+		*Who = LockUser.ToString();
 	}
 	return LockState == ELockState::LockedOther;
 }
@@ -6,13 +6,14 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
 #include "ISourceControlState.h"
 #include "ISourceControlRevision.h"
 #include "GitSourceControlRevision.h"
 
 namespace EWorkingCopyState
 {
-	enum Type
+	enum Type : uint8
 	{
 		Unknown,
 		Unchanged, // called "clean" in SVN, "Pristine" in Perforce
@@ -30,7 +31,7 @@ namespace EWorkingCopyState
 
 namespace ELockState
 {
-	enum Type
+	enum Type : uint8
 	{
 		Unknown,
 		NotLocked,
@@ -39,6 +40,119 @@ namespace ELockState
 	};
 }
 
+/**
+ * Name of the user locking a file, interned in a table shared by all the states: a single index per file, like an FName,
+ * but compared case-sensitively and keeping its case, so that two users whose names differ only by their case are not mixed up.
+ */
+class FGitLockUser
+{
+public:
+	FGitLockUser() = default;
+
+	/** Find or add the name in the table of users */
+	explicit FGitLockUser(const FString& InName);
+
+	/** No user */
+	bool IsNone() const
+	{
+		return Index == INDEX_NONE;
+	}
+
+	/** The name, as given to the constructor (empty if none) */
+	FString ToString() const;
+
+	bool operator==(const FGitLockUser& InOther) const
+	{
+		return Index == InOther.Index;
+	}
+
+	bool operator!=(const FGitLockUser& InOther) const
+	{
+		return Index != InOther.Index;
+	}
+
+	friend uint32 GetTypeHash(const FGitLockUser& InUser)
+	{
+		return ::GetTypeHash(InUser.Index);
+	}
+
+private:
+	/** Index in the table of users, INDEX_NONE if none */
+	int32 Index = INDEX_NONE;
+};
+
+/**
+ * History of a file, allocated only once queried (by the "History" and "Diff" windows): a single pointer for all the other files.
+ * Copied by value, like the array it replaces.
+ */
+class FGitSourceControlLazyHistory
+{
+public:
+	FGitSourceControlLazyHistory() = default;
+	FGitSourceControlLazyHistory(FGitSourceControlLazyHistory&&) = default;
+	FGitSourceControlLazyHistory& operator=(FGitSourceControlLazyHistory&&) = default;
+
+	FGitSourceControlLazyHistory(const FGitSourceControlLazyHistory& InOther)
+	{
+		*this = InOther;
+	}
+
+	FGitSourceControlLazyHistory& operator=(const FGitSourceControlLazyHistory& InOther)
+	{
+		if(this != &InOther)
+		{
+			History.Reset(InOther.History.IsValid() ? new TGitSourceControlHistory(*InOther.History) : nullptr);
+		}
+		return *this;
+	}
+
+	FGitSourceControlLazyHistory& operator=(TGitSourceControlHistory&& InHistory)
+	{
+		History.Reset(InHistory.Num() > 0 ? new TGitSourceControlHistory(MoveTemp(InHistory)) : nullptr);
+		return *this;
+	}
+
+	FGitSourceControlLazyHistory& operator=(const TGitSourceControlHistory& InHistory)
+	{
+		return *this = TGitSourceControlHistory(InHistory);
+	}
+
+	int32 Num() const
+	{
+		return History.IsValid() ? History->Num() : 0;
+	}
+
+	bool IsValidIndex(const int32 InIndex) const
+	{
+		return History.IsValid() && History->IsValidIndex(InIndex);
+	}
+
+	const TSharedRef<FGitSourceControlRevision, ESPMode::ThreadSafe>& operator[](const int32 InIndex) const
+	{
+		return (*History)[InIndex];
+	}
+
+	/** Support ranged-for like the array (an empty range when no history is attached) */
+	const TSharedRef<FGitSourceControlRevision, ESPMode::ThreadSafe>* begin() const
+	{
+		return History.IsValid() ? History->GetData() : nullptr;
+	}
+
+	const TSharedRef<FGitSourceControlRevision, ESPMode::ThreadSafe>* end() const
+	{
+		return History.IsValid() ? History->GetData() + History->Num() : nullptr;
+	}
+
+	/** Heap memory used by the history */
+	SIZE_T GetAllocatedSize() const
+	{
+		return History.IsValid() ? sizeof(TGitSourceControlHistory) + History->GetAllocatedSize() : 0;
+	}
+
+private:
+	TUniquePtr<TGitSourceControlHistory> History;
+};
+
 class FGitSourceControlState : public ISourceControlState, public TSharedFromThis<FGitSourceControlState, ESPMode::ThreadSafe>
 {
 public:
@@ -87,30 +201,48 @@ public:
 	virtual bool IsConflicted() const override;
 	virtual bool CanRevert() const override;
 
+	/** Set the File Id with which our local revision diverged from the remote revision, from its 40 hexadecimal digits */
+	void SetPendingMergeBaseFileHash(const FString& InFileHash);
+
+	/** Tell if another state of the same file has the same status, that is if applying it would change nothing but the time stamp */
+	bool HasSameStatus(const FGitSourceControlState& InOther) const;
+
+	/** Heap memory used by this state (not counting the state itself) */
+	SIZE_T GetAllocatedSize() const;
+
 public:
-	/** History of the item, if any */
-	TGitSourceControlHistory History;
+	/**
+	 * The layout is kept compact since there is one state per file of the project in the cache:
+	 * - the filename is the only copy of the path (the state cache is keyed by it),
+	 * - the user locking the file is interned in a table of users, shared by all the files locked by the same user,
+	 * - the merge base is a binary SHA1 instead of 40 hexadecimal characters,
+	 * - the history is allocated only once queried,
+	 * - the enums and flags are packed together.
+	 */
 
 	/** Filename on disk */
 	FString LocalFilename;
 
-	/** File Id with which our local revision diverged from the remote revision */
-	FString PendingMergeBaseFileHash;
+	/** History of the item, if any */
+	FGitSourceControlLazyHistory History;
+
+	/** Name of user who has locked the file */
+	FGitLockUser LockUser;
+
+	/** File Id with which our local revision diverged from the remote revision (all zeros if not in conflict) */
+	FSHAHash PendingMergeBaseFileHash;
 
 	/** State of the working copy */
-	EWorkingCopyState::Type WorkingCopyState;
+	EWorkingCopyState::Type WorkingCopyState : 4;
 
 	/** Lock state */
-	ELockState::Type LockState;
-
-	/** Name of user who has locked the file */
-	FString LockUser;
+	ELockState::Type LockState : 2;
 
 	/** Tells if using the Git LFS file Locking workflow */
-	bool bUsingGitLfsLocking;
+	uint8 bUsingGitLfsLocking : 1;
 
 	/** Whether a newer version exists on the server */
-	bool bNewerVersionOnServer;
+	uint8 bNewerVersionOnServer : 1;
 
 	/** The timestamp of the last update */
 	FDateTime TimeStamp;
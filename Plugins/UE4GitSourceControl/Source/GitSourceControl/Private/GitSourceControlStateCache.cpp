@@ -0,0 +1,274 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlStateCache.h"
+
+#include "Misc/ScopeRWLock.h"
+
+TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlStateCache::Find(const FString& InFilename) const
+{
+	const uint32 Hash = GetTypeHash(InFilename);
+	const FShard& Shard = GetShard(Hash);
+
+	FReadScopeLock ReadLock(Shard.Lock);
+	const FGitSourceControlStateRef* State = Shard.States.FindByHash(Hash, InFilename);
+	if(State != nullptr)
+	{
+		return *State;
+	}
+	return nullptr;
+}
+
+FGitSourceControlStateRef FGitSourceControlStateCache::FindOrAdd(const FString& InFilename, const bool bInUsingLfsLocking)
+{
+	const uint32 Hash = GetTypeHash(InFilename);
+	FShard& Shard = GetShard(Hash);
+
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		const FGitSourceControlStateRef* State = Shard.States.FindByHash(Hash, InFilename);
+		if(State != nullptr)
+		{
+			// found cached item
+			return *State;
+		}
+	}
+
+	// Allocate the new state before taking the write lock
+	FGitSourceControlStateRef NewState = MakeShareable(new FGitSourceControlState(InFilename, bInUsingLfsLocking));
+
+	FWriteScopeLock WriteLock(Shard.Lock);
+	// Another thread may have cached the same file in between
+	const FGitSourceControlStateRef* State = Shard.States.FindByHash(Hash, InFilename);
+	if(State != nullptr)
+	{
+		return *State;
+	}
+	Shard.States.AddByHash(Hash, NewState);
+	return NewState;
+}
+
+TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlStateCache::Update(const FGitSourceControlState& InState, const FDateTime& InTimeStamp)
+{
+	return Update(FGitSourceControlState(InState), InTimeStamp);
+}
+
+TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlStateCache::Update(FGitSourceControlState&& InState, const FDateTime& InTimeStamp)
+{
+	const uint32 Hash = GetTypeHash(InState.LocalFilename);
+	FShard& Shard = GetShard(Hash);
+
+	{
+		// Most of the states of a status are unchanged: compare them under the read lock only
+		FReadScopeLock ReadLock(Shard.Lock);
+		const FGitSourceControlStateRef* CachedState = Shard.States.FindByHash(Hash, InState.LocalFilename);
+		if(CachedState != nullptr && (*CachedState)->HasSameStatus(InState))
+		{
+			return nullptr;
+		}
+	}
+
+	FWriteScopeLock WriteLock(Shard.Lock);
+	const FGitSourceControlStateRef* CachedState = Shard.States.FindByHash(Hash, InState.LocalFilename);
+	if(CachedState == nullptr)
+	{
+		FGitSourceControlStateRef NewState = MakeShareable(new FGitSourceControlState(MoveTemp(InState)));
+		NewState->TimeStamp = InTimeStamp;
+		Shard.States.AddByHash(Hash, NewState);
+		Shard.Index(NewState);
+		return NewState;
+	}
+
+	const FGitSourceControlStateRef State = *CachedState;
+	if(State->HasSameStatus(InState))
+	{
+		// Updated by another thread in between
+		return nullptr;
+	}
+	Shard.Unindex(State);
+	// The filename of the cached state is its key in the set, and only differs from the new one by case: the hash is unchanged
+	// A status does not query the history: keep the one already cached, if any
+	FGitSourceControlLazyHistory History = MoveTemp(State->History);
+	*State = MoveTemp(InState);
+	if(State->History.Num() == 0)
+	{
+		State->History = MoveTemp(History);
+	}
+	State->TimeStamp = InTimeStamp;
+	Shard.Index(State);
+	return State;
+}
+
+void FGitSourceControlStateCache::GetStatesByWorkingCopyState(const EWorkingCopyState::Type InWorkingCopyState, TArray<FGitSourceControlStateRef>& OutStates) const
+{
+	for(const FShard& Shard : Shards)
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		if(IsIndexed(InWorkingCopyState))
+		{
+			for(const FGitSourceControlStateRef& State : Shard.ByWorkingCopyState[InWorkingCopyState])
+			{
+				OutStates.Add(State);
+			}
+		}
+		else
+		{
+			for(const FGitSourceControlStateRef& State : Shard.States)
+			{
+				if(State->WorkingCopyState == InWorkingCopyState)
+				{
+					OutStates.Add(State);
+				}
+			}
+		}
+	}
+}
+
+void FGitSourceControlStateCache::GetStatesByLockState(const ELockState::Type InLockState, TArray<FGitSourceControlStateRef>& OutStates) const
+{
+	for(const FShard& Shard : Shards)
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		if(IsIndexed(InLockState))
+		{
+			for(const FGitSourceControlStateRef& State : Shard.ByLockState[InLockState])
+			{
+				OutStates.Add(State);
+			}
+		}
+		else
+		{
+			for(const FGitSourceControlStateRef& State : Shard.States)
+			{
+				if(State->LockState == InLockState)
+				{
+					OutStates.Add(State);
+				}
+			}
+		}
+	}
+}
+
+bool FGitSourceControlStateCache::Remove(const FString& InFilename)
+{
+	const uint32 Hash = GetTypeHash(InFilename);
+	FShard& Shard = GetShard(Hash);
+
+	FWriteScopeLock WriteLock(Shard.Lock);
+	const FGitSourceControlStateRef* State = Shard.States.FindByHash(Hash, InFilename);
+	if(State == nullptr)
+	{
+		return false;
+	}
+	Shard.Unindex(*State);
+	Shard.States.RemoveByHash(Hash, InFilename);
+	return true;
+}
+
+void FGitSourceControlStateCache::Empty()
+{
+	for(FShard& Shard : Shards)
+	{
+		// Release the states outside of the lock
+		FStateSet States;
+		{
+			FWriteScopeLock WriteLock(Shard.Lock);
+			States = MoveTemp(Shard.States);
+			Shard.States.Reset();
+			for(TSet<FGitSourceControlStateRef>& Index : Shard.ByWorkingCopyState)
+			{
+				Index.Reset();
+			}
+			for(TSet<FGitSourceControlStateRef>& Index : Shard.ByLockState)
+			{
+				Index.Reset();
+			}
+		}
+	}
+}
+
+void FGitSourceControlStateCache::GetStates(TArray<FGitSourceControlStateRef>& OutStates) const
+{
+	OutStates.Reserve(OutStates.Num() + Num());
+	for(const FShard& Shard : Shards)
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		for(const FGitSourceControlStateRef& State : Shard.States)
+		{
+			OutStates.Add(State);
+		}
+	}
+}
+
+void FGitSourceControlStateCache::GetFilenames(TArray<FString>& OutFilenames) const
+{
+	OutFilenames.Reserve(OutFilenames.Num() + Num());
+	for(const FShard& Shard : Shards)
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		for(const FGitSourceControlStateRef& State : Shard.States)
+		{
+			OutFilenames.Add(State->LocalFilename);
+		}
+	}
+}
+
+int32 FGitSourceControlStateCache::Num() const
+{
+	int32 Count = 0;
+	for(const FShard& Shard : Shards)
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		Count += Shard.States.Num();
+	}
+	return Count;
+}
+
+SIZE_T FGitSourceControlStateCache::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = 0;
+	for(const FShard& Shard : Shards)
+	{
+		FReadScopeLock ReadLock(Shard.Lock);
+		AllocatedSize += Shard.States.GetAllocatedSize();
+		for(const TSet<FGitSourceControlStateRef>& Index : Shard.ByWorkingCopyState)
+		{
+			AllocatedSize += Index.GetAllocatedSize();
+		}
+		for(const TSet<FGitSourceControlStateRef>& Index : Shard.ByLockState)
+		{
+			AllocatedSize += Index.GetAllocatedSize();
+		}
+		for(const FGitSourceControlStateRef& State : Shard.States)
+		{
+			AllocatedSize += sizeof(FGitSourceControlState) + State->GetAllocatedSize();
+		}
+	}
+	return AllocatedSize;
+}
+
+void FGitSourceControlStateCache::FShard::Index(const FGitSourceControlStateRef& InState)
+{
+	if(IsIndexed(InState->WorkingCopyState))
+	{
+		ByWorkingCopyState[InState->WorkingCopyState].Add(InState);
+	}
+	if(IsIndexed(InState->LockState))
+	{
+		ByLockState[InState->LockState].Add(InState);
+	}
+}
+
+void FGitSourceControlStateCache::FShard::Unindex(const FGitSourceControlStateRef& InState)
+{
+	if(IsIndexed(InState->WorkingCopyState))
+	{
+		ByWorkingCopyState[InState->WorkingCopyState].Remove(InState);
+	}
+	if(IsIndexed(InState->LockState))
+	{
+		ByLockState[InState->LockState].Remove(InState);
+	}
+}
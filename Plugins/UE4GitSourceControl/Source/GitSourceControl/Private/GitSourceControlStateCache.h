@@ -0,0 +1,133 @@
+// Copyright (c) 2014-2020 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GitSourceControlState.h"
+
+typedef TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlStateRef;
+
+/**
+ * Thread-safe cache of the state of each file, shared by the game thread and the worker threads.
+ *
+ * The cache is split into shards, each one a map guarded by its own read/write lock, selected by the hash of the filename.
+ * The hash is computed only once per call, and reused to look the filename up in the map of the shard.
+ * Lookups of cached files only take a read lock, so the Content Browser never waits on a worker thread querying other files:
+ * a shard is write-locked only for the short time needed to add, update or remove one entry.
+ *
+ * Each shard also indexes its files by working copy state and by lock state, so that views like "all modified files"
+ * cost the size of their result instead of a scan of the whole cache. The common states (Unknown and Unchanged, NotLocked)
+ * are not indexed, to keep the indexes small: querying them falls back to a scan.
+ * The indexed states must thus only be changed through Update().
+ */
+class FGitSourceControlStateCache
+{
+public:
+	/** Get the cached state of a file, or nullptr if not in the cache */
+	TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> Find(const FString& InFilename) const;
+
+	/** Get the cached state of a file, or cache an unknown state for it */
+	FGitSourceControlStateRef FindOrAdd(const FString& InFilename, const bool bInUsingLfsLocking);
+
+	/**
+	 * Copy a new state into the cached state of its file (or cache it), and update the indexes; the cached history is kept if the new state has none.
+	 * A state with the same status as the cached one is ignored, leaving its time stamp unchanged.
+	 * @return the cached state if the file was not in the cache or if its status changed, else nullptr
+	 */
+	TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> Update(const FGitSourceControlState& InState, const FDateTime& InTimeStamp);
+	TSharedPtr<FGitSourceControlState, ESPMode::ThreadSafe> Update(FGitSourceControlState&& InState, const FDateTime& InTimeStamp);
+
+	/** Get the cached states of the files in a given working copy state */
+	void GetStatesByWorkingCopyState(const EWorkingCopyState::Type InWorkingCopyState, TArray<FGitSourceControlStateRef>& OutStates) const;
+
+	/** Get the cached states of the files in a given lock state */
+	void GetStatesByLockState(const ELockState::Type InLockState, TArray<FGitSourceControlStateRef>& OutStates) const;
+
+	/** Remove a file from the cache */
+	bool Remove(const FString& InFilename);
+
+	/** Remove all the files from the cache */
+	void Empty();
+
+	/** Get the states of all the files of the cache (a snapshot, so that callers never run code under the lock of a shard) */
+	void GetStates(TArray<FGitSourceControlStateRef>& OutStates) const;
+
+	/** Get the names of all the files of the cache */
+	void GetFilenames(TArray<FString>& OutFilenames) const;
+
+	/** Number of files in the cache */
+	int32 Num() const;
+
+	/** Memory used by the cache: its sets and indexes, plus the states and the heap memory they use */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Power of two, a few times the number of worker threads */
+	static const uint32 NumShards = 32;
+
+	static const int32 NumWorkingCopyStates = EWorkingCopyState::Ignored + 1;
+	static const int32 NumLockStates = ELockState::LockedOther + 1;
+
+	/** Key the states by their own filename, instead of a map with a second copy of each path */
+	struct FStateKeyFuncs : BaseKeyFuncs<FGitSourceControlStateRef, FString>
+	{
+		static const FString& GetSetKey(const FGitSourceControlStateRef& InState)
+		{
+			return InState->LocalFilename;
+		}
+
+		static bool Matches(const FString& InA, const FString& InB)
+		{
+			return InA == InB;
+		}
+
+		static uint32 GetKeyHash(const FString& InKey)
+		{
+			return GetTypeHash(InKey);
+		}
+	};
+
+	typedef TSet<FGitSourceControlStateRef, FStateKeyFuncs> FStateSet;
+
+	/** One set of states, its indexes and its lock, on its own cache lines so that threads working on different shards do not contend */
+	struct alignas(PLATFORM_CACHE_LINE_SIZE) FShard
+	{
+		mutable FRWLock Lock;
+		FStateSet States;
+
+		/** Files of the shard in each indexed working copy state and lock state */
+		TSet<FGitSourceControlStateRef> ByWorkingCopyState[NumWorkingCopyStates];
+		TSet<FGitSourceControlStateRef> ByLockState[NumLockStates];
+
+		/** Add a state to, or remove it from, the indexes of its current working copy and lock states (under the write lock) */
+		void Index(const FGitSourceControlStateRef& InState);
+		void Unindex(const FGitSourceControlStateRef& InState);
+	};
+
+	/** Tell if the files in a given state are indexed, or if finding them requires a scan */
+	static bool IsIndexed(const EWorkingCopyState::Type InWorkingCopyState)
+	{
+		return InWorkingCopyState != EWorkingCopyState::Unknown && InWorkingCopyState != EWorkingCopyState::Unchanged;
+	}
+
+	static bool IsIndexed(const ELockState::Type InLockState)
+	{
+		return InLockState != ELockState::Unknown && InLockState != ELockState::NotLocked;
+	}
+
+	FShard& GetShard(const uint32 InHash)
+	{
+		return Shards[InHash & (NumShards - 1)];
+	}
+
+	const FShard& GetShard(const uint32 InHash) const
+	{
+		return Shards[InHash & (NumShards - 1)];
+	}
+
+	FShard Shards[NumShards];
+};
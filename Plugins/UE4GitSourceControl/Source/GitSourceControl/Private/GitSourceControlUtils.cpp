@@ -9,12 +9,21 @@
 #include "HAL/PlatformProcess.h"
 #include "HAL/PlatformFilemanager.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
+#include "Misc/EngineVersionComparison.h"
 #include "Modules/ModuleManager.h"
 #include "ISourceControlModule.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlProvider.h"
+#include "GitSourceControlProcessPool.h"
+#include "GitSourceControlOutputReader.h"
+#include "GitSourceControlIndex.h"
+#include "GitSourceControlRefs.h"
+#include "GitSourceControlFileExistenceCache.h"
+#include "GitSourceControlLfsLocksClient.h"
+#include "GitSourceControlLockTable.h"
 
 // tonyxia changed
 #include "GenericPlatform/GenericPlatformFile.h"
@@ -29,6 +38,9 @@ namespace GitSourceControlConstants
 {
 	/** The maximum number of files we submit in a single Git command */
 	const int32 MaxFilesPerBatch = 50;
+
+	/** The maximum total length of the paths we submit in a single Git status command (Windows command lines are limited to 32767 characters) */
+	const int32 MaxPathspecsLength = 16 * 1024;
 }
 
 FGitScopedTempFile::FGitScopedTempFile(const FText& InText)
@@ -60,6 +72,36 @@ const FString& FGitScopedTempFile::GetFilename() const
 namespace GitSourceControlUtils
 {
 void AbsoluteFilenames(const FString& InRepositoryRoot, TArray<FString>& InFileNames);
+
+FString GetGitOrEnvBinary(const FString& InPathToGitBinary, FString& InOutFullCommand)
+{
+	FString PathToGitOrEnvBinary = InPathToGitBinary;
+#if PLATFORM_MAC
+	// The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
+	FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
+	FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
+
+	TArray<FString> PathArray;
+	PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
+	bool bHasGitInstallPath = false;
+	for (auto Path : PathArray)
+	{
+		if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
+		{
+			bHasGitInstallPath = true;
+			break;
+		}
+	}
+
+	if (!bHasGitInstallPath)
+	{
+		PathToGitOrEnvBinary = FString("/usr/bin/env");
+		InOutFullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *InOutFullCommand);
+	}
+#endif
+	return PathToGitOrEnvBinary;
+}
+
 // Launch the Git command line process and extract its results & errors
 static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, const int32 ExpectedReturnCode = 0)
 {
@@ -129,30 +171,8 @@ static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPat
 	UE_LOG(LogSourceControl, Log, TEXT("RunCommand: 'git %s'"), *LogableCommand);
 	UE_LOG(LogSourceControl, Warning, TEXT("FullCommand: 'git %s'"), *FullCommand);
 
-	FString PathToGitOrEnvBinary = InPathToGitBinary;
-#if PLATFORM_MAC
-	// The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
-	FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
-	FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
-
-	TArray<FString> PathArray;
-	PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
-	bool bHasGitInstallPath = false;
-	for (auto Path : PathArray)
-	{
-		if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
-		{
-			bHasGitInstallPath = true;
-			break;
-		}
-	}
-
-	if (!bHasGitInstallPath)
-	{
-		PathToGitOrEnvBinary = FString("/usr/bin/env");
-		FullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *FullCommand);
-	}
-#endif
+	const FString PathToGitOrEnvBinary = GetGitOrEnvBinary(InPathToGitBinary, FullCommand);
+	FGitProcessPool::CountProcessSpawn();
 	FPlatformProcess::ExecProcess(*PathToGitOrEnvBinary, *FullCommand, &ReturnCode, &OutResults, &OutErrors);
 
 	// TODO: add a setting to easily enable Verbose logging
@@ -172,6 +192,126 @@ static bool RunCommandInternalRaw(const FString& InCommand, const FString& InPat
 	return ReturnCode == ExpectedReturnCode;
 }
 
+/**
+ * Serve the object lookups ("ls-tree --long <rev> <files>", "rev-parse --verify <rev>", "cat-file -t|-s|-e|-p <object>")
+ * with the long-lived "cat-file" helper processes of FGitProcessPool, producing the same output as the one-shot command line.
+ * @returns false if the command cannot be served by a helper, in which case a new Git process has to be spawned
+ */
+static bool TryRunPooledCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, bool& OutResult)
+{
+	FGitProcessPool& ProcessPool = FGitProcessPool::Get();
+	if(InRepositoryRoot.IsEmpty() || !ProcessPool.IsEnabled())
+	{
+		return false;
+	}
+
+	if(InCommand == TEXT("ls-tree") && InParameters.Num() == 2 && InParameters[0] == TEXT("--long") && !InParameters[1].StartsWith(TEXT("-")) && InFiles.Num() > 0)
+	{
+		// "<rev>:<path>" names a path relative to the root of the repository, as "ls-tree" run from the root
+		TArray<FString> ObjectNames;
+		for(const FString& File : InFiles)
+		{
+			if(!FPaths::IsRelative(File))
+			{
+				return false;
+			}
+			ObjectNames.Add(InParameters[1] + TEXT(":") + File);
+		}
+		TArray<FGitObjectInfo> Infos;
+		if(!ProcessPool.BatchCheck(InPathToGitBinary, InRepositoryRoot, ObjectNames, Infos) || Infos.Num() != InFiles.Num())
+		{
+			return false;
+		}
+		// "<mode> <type> <object> <size>\t<path>", the paths not found in the revision being ignored
+		for(int32 Index = 0; Index < InFiles.Num(); ++Index)
+		{
+			const FGitObjectInfo& Info = Infos[Index];
+			if(Info.Type == TEXT("blob"))
+			{
+				OutResults.Add(FString::Printf(TEXT("100644 blob %s %7lld\t%s"), *Info.Hash, Info.Size, *InFiles[Index]));
+			}
+			else if(Info.Type == TEXT("tree"))
+			{
+				OutResults.Add(FString::Printf(TEXT("040000 tree %s       -\t%s"), *Info.Hash, *InFiles[Index]));
+			}
+			else if(Info.Type == TEXT("commit"))
+			{
+				OutResults.Add(FString::Printf(TEXT("160000 commit %s       -\t%s"), *Info.Hash, *InFiles[Index]));
+			}
+		}
+		OutResult = true;
+		return true;
+	}
+	else if(InCommand == TEXT("rev-parse") && InParameters.Contains(TEXT("--verify")) && InFiles.Num() == 0)
+	{
+		// "rev-parse --verify [--quiet] <rev>" => the full SHA1 of the object, or an error
+		FString Revision;
+		for(const FString& Parameter : InParameters)
+		{
+			if(Parameter == TEXT("--verify") || Parameter == TEXT("--quiet") || Parameter == TEXT("-q"))
+			{
+				continue;
+			}
+			if(Parameter.StartsWith(TEXT("-")) || !Revision.IsEmpty())
+			{
+				return false;
+			}
+			Revision = Parameter;
+		}
+		TArray<FString> ObjectNames;
+		ObjectNames.Add(Revision);
+		TArray<FGitObjectInfo> Infos;
+		if(Revision.IsEmpty() || !ProcessPool.BatchCheck(InPathToGitBinary, InRepositoryRoot, ObjectNames, Infos) || Infos.Num() != 1)
+		{
+			return false;
+		}
+		if(!Infos[0].Hash.IsEmpty())
+		{
+			OutResults.Add(Infos[0].Hash);
+		}
+		OutResult = !Infos[0].Hash.IsEmpty();
+		return true;
+	}
+	else if(InCommand == TEXT("cat-file") && InParameters.Num() >= 1 && InParameters.Num() + InFiles.Num() == 2)
+	{
+		// "cat-file -t|-s|-e|-p <object>", the object being given either as a parameter or as a file
+		const FString& Option = InParameters[0];
+		const FString& ObjectName = (InFiles.Num() > 0) ? InFiles[0] : InParameters[1];
+		if(Option == TEXT("-p"))
+		{
+			FGitObjectInfo Info;
+			TArray<uint8> Content;
+			if(!ProcessPool.CatFile(InPathToGitBinary, InRepositoryRoot, ObjectName, Info, Content) || Info.Type == TEXT("tree"))
+			{
+				// Trees are pretty-printed differently from their raw content
+				return false;
+			}
+			FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Content.GetData()), Content.Num());
+			FString(Converter.Length(), Converter.Get()).ParseIntoArray(OutResults, TEXT("\n"), true);
+			OutResult = true;
+			return true;
+		}
+		if(Option == TEXT("-t") || Option == TEXT("-s") || Option == TEXT("-e"))
+		{
+			TArray<FString> ObjectNames;
+			ObjectNames.Add(ObjectName);
+			TArray<FGitObjectInfo> Infos;
+			if(!ProcessPool.BatchCheck(InPathToGitBinary, InRepositoryRoot, ObjectNames, Infos) || Infos.Num() != 1)
+			{
+				return false;
+			}
+			OutResult = !Infos[0].Hash.IsEmpty();
+			if(OutResult && Option != TEXT("-e"))
+			{
+				OutResults.Add((Option == TEXT("-t")) ? Infos[0].Type : FString::Printf(TEXT("%lld"), Infos[0].Size));
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
 // Basic parsing or results & errors from the Git command line process
 static bool RunCommandInternal(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
 {
@@ -179,6 +319,11 @@ static bool RunCommandInternal(const FString& InCommand, const FString& InPathTo
 	FString Results;
 	FString Errors;
 
+	if(TryRunPooledCommand(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, bResult))
+	{
+		return bResult;
+	}
+
 	bResult = RunCommandInternalRaw(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, Results, Errors);
 	Results.ParseIntoArray(OutResults, TEXT("\n"), true);
 	Errors.ParseIntoArray(OutErrorMessages, TEXT("\n"), true);
@@ -186,6 +331,144 @@ static bool RunCommandInternal(const FString& InCommand, const FString& InPathTo
 	return bResult;
 }
 
+#if UE_VERSION_OLDER_THAN(5, 1, 0)
+/**
+ * Run the command through the shell with its stderr redirected to a file,
+ * since CreateProc() gives the same pipe to stdout and stderr before UE 5.1, which would splice the errors into the records.
+ * On Unix the shell command goes in a script, as CreateProc() does not support nested quotes in its parameters.
+ */
+static void RedirectErrorsToFile(const FString& InErrorFilename, FString& InOutBinary, FString& InOutParams, TUniquePtr<FGitScopedTempFile>& OutScript)
+{
+#if PLATFORM_WINDOWS
+	// "cmd /s /c" removes the outer quotes and runs the rest as is
+	InOutParams = FString::Printf(TEXT("/s /c \"\"%s\" %s 2>\"%s\"\""), *FPaths::ConvertRelativePathToFull(InOutBinary).Replace(TEXT("/"), TEXT("\\")), *InOutParams, *InErrorFilename.Replace(TEXT("/"), TEXT("\\")));
+	InOutBinary = TEXT("cmd.exe");
+#else
+	// Nothing in the parameters is meant to be expanded by the shell
+	const FString Params = InOutParams.Replace(TEXT("\\"), TEXT("\\\\")).Replace(TEXT("$"), TEXT("\\$")).Replace(TEXT("`"), TEXT("\\`"));
+	OutScript = MakeUnique<FGitScopedTempFile>(FText::FromString(FString::Printf(TEXT("exec \"%s\" %s 2>\"%s\"\n"), *InOutBinary, *Params, *InErrorFilename)));
+	InOutParams = FString::Printf(TEXT("\"%s\""), *OutScript->GetFilename());
+	InOutBinary = TEXT("/bin/sh");
+#endif
+}
+#endif
+
+// Launch the Git command line process and stream its output into a reader, without an intermediate string per line
+static bool RunCommandInternalStreamed(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FGitOutputReader& OutReader, TArray<FString>& OutErrorMessages)
+{
+	int32 ReturnCode = -1;
+	FString FullCommand;
+
+	if(!InRepositoryRoot.IsEmpty())
+	{
+		// Specify the working copy (the root) of the git repository (before the command itself)
+		FullCommand  = TEXT("-C \"");
+		FullCommand += InRepositoryRoot;
+		FullCommand += TEXT("\" ");
+	}
+	FullCommand += InCommand;
+	for(const auto& Parameter : InParameters)
+	{
+		FullCommand += TEXT(" ");
+		FullCommand += Parameter;
+	}
+	for(const auto& File : InFiles)
+	{
+		FullCommand += TEXT(" \"");
+		FullCommand += File;
+		FullCommand += TEXT("\"");
+	}
+
+	UE_LOG(LogSourceControl, Log, TEXT("RunCommandStreamed: 'git %s'"), *FullCommand);
+
+	FString PathToGitOrEnvBinary = GetGitOrEnvBinary(InPathToGitBinary, FullCommand);
+	FGitProcessPool::CountProcessSpawn();
+	FString Errors;
+
+	void* PipeRead = nullptr;
+	void* PipeWrite = nullptr;
+	void* ErrorPipeRead = nullptr;
+	verify(FPlatformProcess::CreatePipe(PipeRead, PipeWrite));
+#if UE_VERSION_OLDER_THAN(5, 1, 0)
+	const FString ErrorFilename = FPaths::ConvertRelativePathToFull(FPaths::CreateTempFilename(*FPaths::ProjectLogDir(), TEXT("Git-Errors"), TEXT(".txt")));
+	TUniquePtr<FGitScopedTempFile> Script;
+	RedirectErrorsToFile(ErrorFilename, PathToGitOrEnvBinary, FullCommand, Script);
+#else
+	void* ErrorPipeWrite = nullptr;
+	verify(FPlatformProcess::CreatePipe(ErrorPipeRead, ErrorPipeWrite));
+#endif
+
+	const bool bLaunchDetached = false;
+	const bool bLaunchHidden = true;
+	const bool bLaunchReallyHidden = bLaunchHidden;
+#if UE_VERSION_OLDER_THAN(5, 1, 0)
+	FProcHandle ProcessHandle = FPlatformProcess::CreateProc(*PathToGitOrEnvBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *InRepositoryRoot, PipeWrite);
+#else
+	FProcHandle ProcessHandle = FPlatformProcess::CreateProc(*PathToGitOrEnvBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *InRepositoryRoot, PipeWrite, nullptr, ErrorPipeWrite);
+#endif
+	if(ProcessHandle.IsValid())
+	{
+		// Read chunks of output and of errors while the process is running, so that none of the pipes ever blocks it
+		TArray<uint8> Chunk;
+		TArray<uint8> ErrorChunk;
+		TArray<uint8> ErrorBytes;
+		while(true)
+		{
+			const bool bRunning = FPlatformProcess::IsProcRunning(ProcessHandle);
+			FPlatformProcess::ReadPipeToArray(PipeRead, Chunk);
+			if(Chunk.Num() > 0)
+			{
+				OutReader.Append(Chunk.GetData(), Chunk.Num());
+			}
+			ErrorChunk.Reset();
+			if(ErrorPipeRead != nullptr)
+			{
+				FPlatformProcess::ReadPipeToArray(ErrorPipeRead, ErrorChunk);
+				ErrorBytes.Append(ErrorChunk);
+			}
+			if(Chunk.Num() == 0 && ErrorChunk.Num() == 0)
+			{
+				if(!bRunning)
+				{
+					break;
+				}
+				FPlatformProcess::Sleep(0.001f);
+			}
+		}
+#if UE_VERSION_OLDER_THAN(5, 1, 0)
+		FFileHelper::LoadFileToString(Errors, *ErrorFilename);
+#else
+		FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(ErrorBytes.GetData()), ErrorBytes.Num());
+		Errors = FString(Converter.Length(), Converter.Get());
+#endif
+
+		FPlatformProcess::GetProcReturnCode(ProcessHandle, &ReturnCode);
+		FPlatformProcess::CloseProc(ProcessHandle);
+	}
+	else
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to launch 'git %s'"), *InCommand);
+	}
+	FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
+#if UE_VERSION_OLDER_THAN(5, 1, 0)
+	IFileManager::Get().Delete(*ErrorFilename, false, false, true);
+#else
+	FPlatformProcess::ClosePipe(ErrorPipeRead, ErrorPipeWrite);
+#endif
+
+	OutReader.Finish();
+
+	if(ReturnCode != 0 || Errors.Len() > 0)
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("RunCommandStreamed(%s) ReturnCode=%d:\n%s"), *InCommand, ReturnCode, *Errors);
+	}
+	if(ReturnCode != 0)
+	{
+		Errors.ParseIntoArray(OutErrorMessages, TEXT("\n"), true);
+	}
+	return ReturnCode == 0;
+}
+
 FString FindGitBinaryPath()
 {
 #if PLATFORM_WINDOWS
@@ -423,6 +706,19 @@ void FindGitCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersi
 	{
 		OutVersion->bHasCatFileWithFilters = true;
 	}
+	// "--pathspec-from-file" introduced in Git 2.25 for add, checkout, commit and reset, and in Git 2.26 for rm
+	OutVersion->bHasPathspecFromFile = OutVersion->IsGreaterOrEqualThan(2, 25);
+	OutVersion->bHasRmPathspecFromFile = OutVersion->IsGreaterOrEqualThan(2, 26);
+	// "status --porcelain=v2" introduced in Git 2.11
+	OutVersion->bHasStatusPorcelainV2 = OutVersion->IsGreaterOrEqualThan(2, 11);
+	// Builtin file system monitor daemon "core.fsmonitor=true" introduced in Git 2.36, only for Windows and Mac
+	OutVersion->bHasFsMonitorDaemon = (PLATFORM_WINDOWS || PLATFORM_MAC) && OutVersion->IsGreaterOrEqualThan(2, 36);
+	// "core.untrackedCache" config introduced in Git 2.8
+	OutVersion->bHasUntrackedCache = OutVersion->IsGreaterOrEqualThan(2, 8);
+	// "feature.manyFiles" config introduced in Git 2.24
+	OutVersion->bHasFeatureManyFiles = OutVersion->IsGreaterOrEqualThan(2, 24);
+	// Index format version 4 (path prefix compression) introduced in Git 1.8
+	OutVersion->bHasIndexV4 = OutVersion->IsGreaterOrEqualThan(1, 8);
 }
 
 void FindGitLfsCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersion)
@@ -438,6 +734,12 @@ void FindGitLfsCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVe
 		{
 			OutVersion->bHasGitLfsLocking = true; // Git LFS File Locking workflow introduced in "git-lfs/2.0.0"
 		}
+		// "git-lfs/3.4.0 (GitHub; windows amd64; go 1.20.6)"
+		FString LfsVersion;
+		if(InfoMessages.Split(TEXT("git-lfs/"), nullptr, &LfsVersion))
+		{
+			OutVersion->bHasGitLfsMultiPathLocking = (FCString::Atoi(*LfsVersion) >= 3); // "git lfs lock/unlock <path>..." introduced in "git-lfs/3.0.0"
+		}
 		UE_LOG(LogSourceControl, Log, TEXT("%s"), *InfoMessages);
 	}
 }
@@ -487,6 +789,29 @@ bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot)
 	return bFound;
 }
 
+FString GetGitDirectory(const FString& InRepositoryRoot)
+{
+	const FString DotGit = InRepositoryRoot / TEXT(".git");
+	if(FPaths::DirectoryExists(DotGit))
+	{
+		return DotGit;
+	}
+
+	// A submodule (or a worktree) has a ".git" file containing "gitdir: ../.git/modules/<name>"
+	FString GitFileContent;
+	if(FFileHelper::LoadFileToString(GitFileContent, *DotGit) && GitFileContent.StartsWith(TEXT("gitdir:")))
+	{
+		FString GitDir = GitFileContent.RightChop(7).TrimStartAndEnd();
+		if(FPaths::IsRelative(GitDir))
+		{
+			GitDir = FPaths::ConvertRelativePathToFull(InRepositoryRoot, GitDir);
+		}
+		return GitDir;
+	}
+
+	return FString();
+}
+
 void GetUserConfig(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutUserName, FString& OutUserEmail)
 {
 	bool bResults;
@@ -510,8 +835,96 @@ void GetUserConfig(const FString& InPathToGitBinary, const FString& InRepository
 	}
 }
 
+/** Get a config value of the repository itself (not the global one), empty if not set */
+static FString GetLocalConfig(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InKey)
+{
+	TArray<FString> InfoMessages;
+	TArray<FString> ErrorMessages;
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("--local"));
+	Parameters.Add(TEXT("--get"));
+	Parameters.Add(InKey);
+	const bool bResults = RunCommandInternal(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+	return (bResults && InfoMessages.Num() > 0) ? InfoMessages[0] : FString();
+}
+
+bool ConfigureStatusAcceleration(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FGitVersion& InVersion)
+{
+	// Config values speeding up "status", depending on the capabilities of Git
+	TArray<TPair<FString, FString>> Configs;
+	if(InVersion.bHasFeatureManyFiles)
+	{
+		Configs.Emplace(TEXT("feature.manyFiles"), TEXT("true"));
+	}
+	if(InVersion.bHasUntrackedCache)
+	{
+		Configs.Emplace(TEXT("core.untrackedCache"), TEXT("true"));
+	}
+	// "feature.manyFiles" implies "index.version=4" (and "index.skipHash" from Git 2.40)
+	const bool bSetIndexVersion = InVersion.bHasIndexV4 && !InVersion.bHasFeatureManyFiles;
+	if(bSetIndexVersion)
+	{
+		Configs.Emplace(TEXT("index.version"), TEXT("4"));
+	}
+	if(InVersion.bHasFsMonitorDaemon)
+	{
+		Configs.Emplace(TEXT("core.fsmonitor"), TEXT("true"));
+	}
+
+	TArray<TPair<FString, FString>> MissingConfigs;
+	for(const TPair<FString, FString>& Config : Configs)
+	{
+		if(GetLocalConfig(InPathToGitBinary, InRepositoryRoot, Config.Key) != Config.Value)
+		{
+			MissingConfigs.Add(Config);
+		}
+	}
+	if(MissingConfigs.Num() == 0)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Status acceleration already configured for '%s'"), *InRepositoryRoot);
+		return true;
+	}
+
+	bool bResults = true;
+	TArray<FString> InfoMessages;
+	TArray<FString> ErrorMessages;
+	for(const TPair<FString, FString>& Config : MissingConfigs)
+	{
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--local"));
+		Parameters.Add(Config.Key);
+		Parameters.Add(Config.Value);
+		bResults &= RunCommandInternal(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+	}
+	if(bSetIndexVersion)
+	{
+		// "index.version" only applies to new index files: rewrite the existing one
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--index-version"));
+		Parameters.Add(TEXT("4"));
+		bResults &= RunCommandInternal(TEXT("update-index"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+	}
+
+	// The latency of "git status" is measured on demand only, by "Git.Benchmark.StatusAcceleration": not while connecting
+	UE_LOG(LogSourceControl, Log, TEXT("Status acceleration configured for '%s' (%d settings)"), *InRepositoryRoot, MissingConfigs.Num());
+	for(const FString& ErrorMessage : ErrorMessages)
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("%s"), *ErrorMessage);
+	}
+
+	return bResults;
+}
+
 bool GetBranchName(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutBranchName)
 {
+	// Read the HEAD natively, else ask Git
+	FGitHeadInfo Head;
+	if(FGitRefsCache::Get().GetHead(InRepositoryRoot, Head))
+	{
+		OutBranchName = MoveTemp(Head.BranchName);
+		return true;
+	}
+
 	bool bResults;
 	TArray<FString> InfoMessages;
 	TArray<FString> ErrorMessages;
@@ -546,6 +959,40 @@ bool GetBranchName(const FString& InPathToGitBinary, const FString& InRepository
 
 bool GetCommitInfo(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutCommitId, FString& OutCommitSummary)
 {
+	// The HEAD commit is read natively, and its summary is cached until it moves
+	FGitHeadInfo Head;
+	const bool bHasHead = FGitRefsCache::Get().GetHead(InRepositoryRoot, Head);
+	if(bHasHead && !Head.CommitId.IsEmpty() && !Head.CommitSummary.IsEmpty())
+	{
+		OutCommitId = MoveTemp(Head.CommitId);
+		OutCommitSummary = MoveTemp(Head.CommitSummary);
+		return true;
+	}
+
+	// Else ask the long-lived "cat-file --batch" helper for the HEAD commit object, to avoid spawning a "git log" process
+	FGitObjectInfo CommitInfo;
+	TArray<uint8> CommitContent;
+	if(FGitProcessPool::Get().CatFile(InPathToGitBinary, InRepositoryRoot, TEXT("HEAD"), CommitInfo, CommitContent) && (CommitInfo.Type == TEXT("commit")))
+	{
+		// The commit object is made of header lines, an empty line, and then the message starting with its summary line
+		FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(CommitContent.GetData()), CommitContent.Num());
+		const FString Content(Converter.Length(), Converter.Get());
+		const int32 IdxMessage = Content.Find(TEXT("\n\n"), ESearchCase::CaseSensitive);
+		if(IdxMessage != INDEX_NONE)
+		{
+			FString Summary = Content.RightChop(IdxMessage + 2);
+			int32 IdxEndOfLine;
+			if(Summary.FindChar(TEXT('\n'), IdxEndOfLine))
+			{
+				Summary.LeftInline(IdxEndOfLine);
+			}
+			OutCommitId = CommitInfo.Hash;
+			OutCommitSummary = MoveTemp(Summary);
+			FGitRefsCache::Get().SetCommitSummary(InRepositoryRoot, OutCommitId, OutCommitSummary);
+			return true;
+		}
+	}
+
 	bool bResults;
 	TArray<FString> InfoMessages;
 	TArray<FString> ErrorMessages;
@@ -557,6 +1004,7 @@ bool GetCommitInfo(const FString& InPathToGitBinary, const FString& InRepository
 	{
 		OutCommitId = InfoMessages[0].Left(40);
 		OutCommitSummary = InfoMessages[0].RightChop(41);
+		FGitRefsCache::Get().SetCommitSummary(InRepositoryRoot, OutCommitId, OutCommitSummary);
 	}
 
 	return bResults;
@@ -609,14 +1057,125 @@ bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, cons
 	return bResult;
 }
 
-// Run a Git "commit" command by batches
+bool RunLfsLockCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutFailedFiles, TArray<FString>& OutErrorMessages)
+{
+	// Requests to the locking API of the LFS server, one per file in parallel
+	FGitLfsLocksClient& LocksClient = FGitLfsLocksClient::Get();
+	if(LocksClient.IsAvailable(InPathToGitBinary, InRepositoryRoot))
+	{
+		const bool bDone = (InCommand == TEXT("lfs lock")) ? LocksClient.CreateLocks(InPathToGitBinary, InRepositoryRoot, InFiles, OutFailedFiles) : LocksClient.DeleteLocks(InPathToGitBinary, InRepositoryRoot, InFiles, OutFailedFiles);
+		UE_LOG(LogSourceControl, Log, TEXT("%s: %d/%d files with the locking API"), *InCommand, InFiles.Num() - OutFailedFiles.Num(), InFiles.Num());
+		if(bDone || LocksClient.IsAvailable(InPathToGitBinary, InRepositoryRoot))
+		{
+			return bDone;
+		}
+		// The server refused the credentials: the git lfs commands may authenticate otherwise
+		OutFailedFiles.Reset();
+	}
+
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const bool bMultiPath = GitSourceControl.GetProvider().GetGitVersion().bHasGitLfsMultiPathLocking;
+
+	TArray<FString> Results;
+	if(bMultiPath)
+	{
+		// Many paths per request to the LFS server (batched by RunCommand() to stay within the command-line limits)
+		RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, TArray<FString>(), InFiles, Results, OutErrorMessages);
+	}
+	else
+	{
+		// Git LFS 2 locks only one path per command
+		for(const FString& File : InFiles)
+		{
+			TArray<FString> OneFile;
+			OneFile.Add(File);
+			RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, TArray<FString>(), OneFile, Results, OutErrorMessages);
+		}
+	}
+
+	// "Locked Content/Map.umap" or "Unlocked Content/Map.umap" for each path that succeeded
+	const FString Prefix = (InCommand == TEXT("lfs lock")) ? TEXT("Locked ") : TEXT("Unlocked ");
+	TSet<FString> SucceededFiles;
+	for(const FString& Result : Results)
+	{
+		if(Result.StartsWith(Prefix, ESearchCase::CaseSensitive))
+		{
+			SucceededFiles.Add(Result.RightChop(Prefix.Len()).TrimEnd());
+		}
+	}
+	for(const FString& File : InFiles)
+	{
+		if(!SucceededFiles.Contains(File))
+		{
+			OutFailedFiles.Add(File);
+		}
+	}
+
+	UE_LOG(LogSourceControl, Log, TEXT("%s: %d/%d files in %d commands"), *InCommand, InFiles.Num() - OutFailedFiles.Num(), InFiles.Num(), bMultiPath ? FMath::DivideAndRoundUp(InFiles.Num(), GitSourceControlConstants::MaxFilesPerBatch) : InFiles.Num());
+	return (OutFailedFiles.Num() == 0);
+}
+
+bool RunCommandStreamed(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FGitOutputReader& OutReader, TArray<FString>& OutErrorMessages)
+{
+	return RunCommandInternalStreamed(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutReader, OutErrorMessages);
+}
+
+// Tell if the Git command can read its list of files from a "--pathspec-from-file" with the detected version of Git
+static bool SupportsPathspecFromFile(const FString& InCommand)
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const FGitVersion& GitVersion = GitSourceControl.GetProvider().GetGitVersion();
+	if(InCommand == TEXT("rm"))
+	{
+		return GitVersion.bHasRmPathspecFromFile;
+	}
+	if(InCommand == TEXT("add") || InCommand == TEXT("checkout") || InCommand == TEXT("commit") || InCommand == TEXT("reset"))
+	{
+		return GitVersion.bHasPathspecFromFile;
+	}
+	return false;
+}
+
+bool RunCommandWithPathspecs(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+{
+	// Few files fit on a single command line anyway, and files outside the repository need the "migrate asset" detection of RunCommandInternalRaw()
+	const bool bOutsideRepository = (InFiles.Num() > 0) && !FPaths::IsRelative(InFiles[0]) && !InFiles[0].StartsWith(InRepositoryRoot);
+	if(InFiles.Num() <= GitSourceControlConstants::MaxFilesPerBatch || bOutsideRepository || !SupportsPathspecFromFile(InCommand))
+	{
+		return RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
+	}
+
+	// One pathspec per line; this is the same as a list of files on the command line as long as no path starts with a double quote
+	FString Pathspecs = FString::Join(InFiles, TEXT("\n"));
+	Pathspecs += TEXT("\n");
+	const FGitScopedTempFile PathspecFile(FText::FromString(Pathspecs));
+	if(PathspecFile.GetFilename().Len() == 0)
+	{
+		return RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
+	}
+
+	TArray<FString> Parameters(InParameters);
+	Parameters.Add(FString::Printf(TEXT("--pathspec-from-file=\"%s\""), *FPaths::ConvertRelativePathToFull(PathspecFile.GetFilename())));
+	return RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), OutResults, OutErrorMessages);
+}
+
+// Run a Git "commit" command, as a single commit whatever the number of files
 bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
 {
 	bool bResult = true;
 
-	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
+	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch && !SupportsPathspecFromFile(TEXT("commit")))
 	{
-		// Batch files up so we dont exceed command-line limits
+		// Before Git 2.25, batch files up so we dont exceed command-line limits, and amend the commit with each further batch.
+		// Remember the original HEAD to be able to rollback the whole commit if any batch fails (empty on the initial commit)
+		TArray<FString> OriginalHead;
+		TArray<FString> RevParseErrors;
+		TArray<FString> RevParseParameters;
+		RevParseParameters.Add(TEXT("--verify"));
+		RevParseParameters.Add(TEXT("--quiet"));
+		RevParseParameters.Add(TEXT("HEAD"));
+		RunCommandInternal(TEXT("rev-parse"), InPathToGitBinary, InRepositoryRoot, RevParseParameters, TArray<FString>(), OriginalHead, RevParseErrors);
+
 		int32 FileCount = 0;
 		{
 			TArray<FString> FilesInBatch;
@@ -635,7 +1194,7 @@ bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot
 		}
 		Parameters.Add(TEXT("--amend"));
 
-		while(FileCount < InFiles.Num())
+		while(bResult && FileCount < InFiles.Num())
 		{
 			TArray<FString> FilesInBatch;
 			for(int32 FileIndex = 0; FileCount < InFiles.Num() && FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
@@ -649,10 +1208,33 @@ bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot
 			OutResults += BatchResults;
 			OutErrorMessages += BatchErrors;
 		}
+
+		if(!bResult && FileCount > GitSourceControlConstants::MaxFilesPerBatch)
+		{
+			// Do not leave a half-amended commit behind: move the branch back to where it was, keeping the changes in the working copy
+			TArray<FString> RollbackResults;
+			TArray<FString> RollbackErrors;
+			TArray<FString> RollbackParameters;
+			if(OriginalHead.Num() > 0)
+			{
+				RollbackParameters.Add(TEXT("--soft"));
+				RollbackParameters.Add(OriginalHead[0]);
+				RunCommandInternal(TEXT("reset"), InPathToGitBinary, InRepositoryRoot, RollbackParameters, TArray<FString>(), RollbackResults, RollbackErrors);
+			}
+			else
+			{
+				RollbackParameters.Add(TEXT("-d"));
+				RollbackParameters.Add(TEXT("HEAD"));
+				RunCommandInternal(TEXT("update-ref"), InPathToGitBinary, InRepositoryRoot, RollbackParameters, TArray<FString>(), RollbackResults, RollbackErrors);
+			}
+			OutErrorMessages += RollbackErrors;
+			UE_LOG(LogSourceControl, Warning, TEXT("RunCommit: commit of %d files failed, rolled back to %s"), InFiles.Num(), (OriginalHead.Num() > 0) ? *OriginalHead[0] : TEXT("an empty branch"));
+		}
 	}
 	else
 	{
-		bResult = RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
+		// A single commit of all the files, that either fully succeeds or leaves the repository untouched
+		bResult = RunCommandWithPathspecs(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
 	}
 
 	return bResult;
@@ -668,77 +1250,33 @@ Content\ThirdPersonBP\Blueprints\ThirdPersonGameMode.uasset     SRombauts
 class FGitLfsLocksParser
 {
 public:
-	FGitLfsLocksParser(const FString& InRepositoryRoot, const FString& InStatus, const bool bAbsolutePaths = true)
+	FGitLfsLocksParser(const FString& InRepositoryRoot, const FStringView& InStatus, const bool bAbsolutePaths = true)
 	{
-		TArray<FString> Informations;
-		InStatus.ParseIntoArray(Informations, TEXT("\t"), true);
-		if(Informations.Num() >= 3)
+		int32 IdxFilenameEnd, IdxUserEnd;
+		if(InStatus.FindChar(TEXT('\t'), IdxFilenameEnd))
 		{
-			Informations[0].TrimEndInline(); // Trim whitespace from the end of the filename
-			Informations[1].TrimEndInline(); // Trim whitespace from the end of the username
-			if (bAbsolutePaths)
-				LocalFilename = FPaths::ConvertRelativePathToFull(InRepositoryRoot, Informations[0]);
-			else
-				LocalFilename = Informations[0];
-			LockUser = MoveTemp(Informations[1]);
+			const FStringView Remaining = InStatus.RightChop(IdxFilenameEnd + 1);
+			if(Remaining.FindChar(TEXT('\t'), IdxUserEnd))
+			{
+				const FStringView Filename = InStatus.Left(IdxFilenameEnd).TrimEnd(); // Trim whitespace from the end of the filename
+				const FStringView User = Remaining.Left(IdxUserEnd).TrimEnd(); // Trim whitespace from the end of the username
+				if (bAbsolutePaths)
+					LocalFilename = FPaths::ConvertRelativePathToFull(InRepositoryRoot, FString(Filename.Len(), Filename.GetData()));
+				else
+					LocalFilename = FString(Filename.Len(), Filename.GetData());
+				LockUser = FString(User.Len(), User.GetData());
+			}
 		}
 	}
 
-	FString LocalFilename;	///< Filename on disk
-	FString LockUser;		///< Name of user who has file locked
-};
-
-/**
- * @brief Extract the relative filename from a Git status result.
- *
- * Examples of status results:
-M  Content/Textures/T_Perlin_Noise_M.uasset
-R  Content/Textures/T_Perlin_Noise_M.uasset -> Content/Textures/T_Perlin_Noise_M2.uasset
-?? Content/Materials/M_Basic_Wall.uasset
-!! BasicCode.sln
- *
- * @param[in] InResult One line of status
- * @return Relative filename extracted from the line of status
- *
- * @see FGitStatusFileMatcher and StateFromGitStatus()
- */
-static FString FilenameFromGitStatus(const FString& InResult)
-{
-	int32 RenameIndex;
-	if(InResult.FindLastChar('>', RenameIndex))
-	{
-		// Extract only the second part of a rename "from -> to"
-		return InResult.RightChop(RenameIndex + 2);
-	}
-	else
-	{
-		// Extract the relative filename from the Git status result (after the 2 letters status and 1 space)
-		return InResult.RightChop(3);
-	}
-}
-
-/** Match the relative filename of a Git status result with a provided absolute filename */
-class FGitStatusFileMatcher
-{
-public:
-	FGitStatusFileMatcher(const FString& InAbsoluteFilename)
-		: AbsoluteFilename(InAbsoluteFilename)
-	{
-	}
-
-	bool operator()(const FString& InResult) const
-	{
-		return AbsoluteFilename.Contains(FilenameFromGitStatus(InResult));
-	}
-
-private:
-	const FString& AbsoluteFilename;
+	FString LocalFilename;	///< Filename on disk
+	FString LockUser;		///< Name of user who has file locked
 };
 
 /**
- * Extract and interpret the file state from the given Git status result.
+ * Extract and interpret the file state from the two letters "XY" of a Git status result (index and working copy).
  * @see http://git-scm.com/docs/git-status
- * ' ' = unmodified
+ * ' ' = unmodified ('.' with porcelain v2)
  * 'M' = modified
  * 'A' = added
  * 'D' = deleted
@@ -751,10 +1289,8 @@ private:
 class FGitStatusParser
 {
 public:
-	FGitStatusParser(const FString& InResult)
+	FGitStatusParser(const TCHAR IndexState, const TCHAR WCopyState)
 	{
-		TCHAR IndexState = InResult[0];
-		TCHAR WCopyState = InResult[1];
 		if(   (IndexState == 'U' || WCopyState == 'U')
 		   || (IndexState == 'A' && WCopyState == 'A')
 		   || (IndexState == 'D' && WCopyState == 'D'))
@@ -805,46 +1341,143 @@ public:
 	EWorkingCopyState::Type State;
 };
 
+/** State of one file extracted from the results of a "status" command */
+struct FGitStatusEntry
+{
+	EWorkingCopyState::Type State = EWorkingCopyState::Unknown;
+
+	/** SHA1 Id of the common ancestor of a conflicted file, if given by the status (porcelain v2 only) */
+	FString MergeBaseFileHash;
+};
+
+/** Results of a "status" command indexed by absolute filename */
+typedef TMap<FString, FGitStatusEntry> FGitStatusIndex;
+
+/** Skip the given number of space separated fields of a status record, returning the rest of the record */
+static bool SkipStatusFields(const FStringView& InRecord, const int32 InNumFields, FStringView& OutRemaining)
+{
+	int32 Index = 0;
+	for(int32 Field = 0; Field < InNumFields; ++Field)
+	{
+		while(Index < InRecord.Len() && InRecord[Index] != TEXT(' '))
+		{
+			++Index;
+		}
+		if(Index >= InRecord.Len())
+		{
+			return false;
+		}
+		++Index;
+	}
+	OutRemaining = InRecord.RightChop(Index);
+	return true;
+}
+
+/** Add one file to the index of status results */
+static FGitStatusEntry& AddStatusEntry(const FString& InRepositoryRoot, const FStringView& InRelativeFilename, const EWorkingCopyState::Type InState, FGitStatusIndex& OutIndex)
+{
+	const FString File = FPaths::ConvertRelativePathToFull(InRepositoryRoot, FString(InRelativeFilename.Len(), InRelativeFilename.GetData()));
+	FGitStatusEntry& Entry = OutIndex.FindOrAdd(File);
+	Entry.State = InState;
+	return Entry;
+}
+
 /**
- * Extract the status of a unmerged (conflict) file
- *
- * Example output of git ls-files --unmerged Content/Blueprints/BP_Test.uasset
-100644 d9b33098273547b57c0af314136f35b494e16dcb 1	Content/Blueprints/BP_Test.uasset
-100644 a14347dc3b589b78fb19ba62a7e3982f343718bc 2	Content/Blueprints/BP_Test.uasset
-100644 f3137a7167c840847cd7bd2bf07eefbfb2d9bcd2 3	Content/Blueprints/BP_Test.uasset
+ * Build the index of the NUL terminated records of a "git status --porcelain=v2 -z" command
  *
- * 1: The "common ancestor" of the file (the version of the file that both the current and other branch originated from).
- * 2: The version from the current branch (the master branch in this case).
- * 3: The version from the other branch (the test branch)
-*/
-class FGitConflictStatusParser
+ * Example records (paths can contain spaces, so they always come after a fixed number of fields):
+1 .M N... 100644 100644 100644 a14347dc3b589b78fb19ba62a7e3982f343718bc a14347dc3b589b78fb19ba62a7e3982f343718bc Content/Blueprints/BP_Test.uasset
+2 R. N... 100644 100644 100644 d9b33098273547b57c0af314136f35b494e16dcb d9b33098273547b57c0af314136f35b494e16dcb R100 Content/Textures/T_Perlin_Noise_M2.uasset
+Content/Textures/T_Perlin_Noise_M.uasset
+u UU N... 100644 100644 100644 100644 d9b33098273547b57c0af314136f35b494e16dcb a14347dc3b589b78fb19ba62a7e3982f343718bc f3137a7167c840847cd7bd2bf07eefbfb2d9bcd2 Content/Maps/Map.umap
+? Content/Materials/M_Basic_Wall.uasset
+! BasicCode.sln
+ */
+static void ParseStatusV2Records(const FString& InRepositoryRoot, const TArray<FStringView>& InRecords, FGitStatusIndex& OutIndex)
 {
-public:
-	/** Parse the unmerge status: extract the base SHA1 identifier of the file */
-	FGitConflictStatusParser(const TArray<FString>& InResults)
+	OutIndex.Reserve(OutIndex.Num() + InRecords.Num());
+	for(int32 IdxRecord = 0; IdxRecord < InRecords.Num(); ++IdxRecord)
 	{
-		const FString& FirstResult = InResults[0]; // 1: The common ancestor of merged branches
-		CommonAncestorFileId = FirstResult.Mid(7, 40);
+		const FStringView& Record = InRecords[IdxRecord];
+		if(Record.Len() < 3)
+		{
+			continue;
+		}
+		FStringView Path;
+		switch(Record[0])
+		{
+		case TEXT('1'): // Ordinary changed entry: "1 <XY> <sub> <mH> <mI> <mW> <hH> <hI> <path>"
+			if(SkipStatusFields(Record, 8, Path))
+			{
+				AddStatusEntry(InRepositoryRoot, Path, FGitStatusParser(Record[2], Record[3]).State, OutIndex);
+			}
+			break;
+		case TEXT('2'): // Renamed or copied entry: "2 <XY> <sub> <mH> <mI> <mW> <hH> <hI> <X><score> <path>" followed by the record "<origPath>"
+			if(SkipStatusFields(Record, 9, Path))
+			{
+				AddStatusEntry(InRepositoryRoot, Path, FGitStatusParser(Record[2], Record[3]).State, OutIndex);
+				if((IdxRecord + 1 < InRecords.Num()) && (Record[2] == TEXT('R')))
+				{
+					// The source of a rename is gone from the index
+					AddStatusEntry(InRepositoryRoot, InRecords[IdxRecord + 1], EWorkingCopyState::Deleted, OutIndex);
+				}
+			}
+			++IdxRecord; // skip the origPath record
+			break;
+		case TEXT('u'): // Unmerged entry: "u <XY> <sub> <m1> <m2> <m3> <mW> <h1> <h2> <h3> <path>"
+			if(SkipStatusFields(Record, 10, Path))
+			{
+				FGitStatusEntry& Entry = AddStatusEntry(InRepositoryRoot, Path, EWorkingCopyState::Conflicted, OutIndex);
+				// h1 is the "common ancestor" of the file (stage 1), or all zeros if there is none (added by both)
+				FStringView Base;
+				if(SkipStatusFields(Record, 7, Base) && Base.Len() >= 40 && !Base.StartsWith(TEXT("0000000000000000000000000000000000000000"), ESearchCase::CaseSensitive))
+				{
+					Entry.MergeBaseFileHash = FString(40, Base.GetData());
+				}
+			}
+			break;
+		case TEXT('?'): // Untracked: "? <path>"
+			AddStatusEntry(InRepositoryRoot, Record.RightChop(2), EWorkingCopyState::NotControlled, OutIndex);
+			break;
+		case TEXT('!'): // Ignored: "! <path>"
+			AddStatusEntry(InRepositoryRoot, Record.RightChop(2), EWorkingCopyState::Ignored, OutIndex);
+			break;
+		default: // "#" headers
+			break;
+		}
 	}
+}
 
-	FString CommonAncestorFileId;	///< SHA1 Id of the file (warning: not the commit Id)
-};
-
-/** Execute a command to get the details of a conflict */
-static void RunGetConflictStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, FGitSourceControlState& InOutFileState)
+/**
+ * Build the index of the NUL terminated records of a "git status --porcelain -z" command (before Git 2.11)
+ *
+ * Example records (the source of a rename or a copy follows it as a separate record):
+ M Content/Blueprints/BP_Test.uasset
+R  Content/Textures/T_Perlin_Noise_M2.uasset
+Content/Textures/T_Perlin_Noise_M.uasset
+?? Content/Materials/M_Basic_Wall.uasset
+!! BasicCode.sln
+ */
+static void ParseStatusV1Records(const FString& InRepositoryRoot, const TArray<FStringView>& InRecords, FGitStatusIndex& OutIndex)
 {
-	TArray<FString> ErrorMessages;
-	TArray<FString> Results;
-	TArray<FString> Files;
-	Files.Add(InFile);
-	TArray<FString> Parameters;
-	Parameters.Add(TEXT("--unmerged"));
-	bool bResult = RunCommandInternal(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Results, ErrorMessages);
-	if(bResult && Results.Num() == 3)
+	OutIndex.Reserve(OutIndex.Num() + InRecords.Num());
+	for(int32 IdxRecord = 0; IdxRecord < InRecords.Num(); ++IdxRecord)
 	{
-		// Parse the unmerge status: extract the base revision (or the other branch?)
-		FGitConflictStatusParser ConflictStatus(Results);
-		InOutFileState.PendingMergeBaseFileHash = ConflictStatus.CommonAncestorFileId;
+		const FStringView& Record = InRecords[IdxRecord];
+		if(Record.Len() < 4)
+		{
+			continue;
+		}
+		AddStatusEntry(InRepositoryRoot, Record.RightChop(3), FGitStatusParser(Record[0], Record[1]).State, OutIndex);
+		if((Record[0] == TEXT('R')) || (Record[0] == TEXT('C')))
+		{
+			if((IdxRecord + 1 < InRecords.Num()) && (Record[0] == TEXT('R')))
+			{
+				// The source of a rename is gone from the index
+				AddStatusEntry(InRepositoryRoot, InRecords[IdxRecord + 1], EWorkingCopyState::Deleted, OutIndex);
+			}
+			++IdxRecord; // skip the source record
+		}
 	}
 }
 
@@ -863,25 +1496,36 @@ void AbsoluteFilenames(const FString& InRepositoryRoot, TArray<FString>& InFileN
 */
 static bool ListFilesInDirectoryRecurse(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InDirectory, TArray<FString>& OutFiles)
 {
-	TArray<FString> ErrorMessages;
 	TArray<FString> Directory;
 	Directory.Add(InDirectory);
-	const bool bResult = RunCommandInternal(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), Directory, OutFiles, ErrorMessages);
-	AbsoluteFilenames(InRepositoryRoot, OutFiles);
+	FGitOutputReader Reader;
+	TArray<FString> ErrorMessages;
+	const bool bResult = RunCommandInternalStreamed(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), Directory, Reader, ErrorMessages);
+	if(bResult)
+	{
+		OutFiles.Reserve(OutFiles.Num() + Reader.GetRecords().Num());
+		for(const FStringView& RelativeFilename : Reader.GetRecords())
+		{
+			OutFiles.Add(FPaths::ConvertRelativePathToFull(InRepositoryRoot, FString(RelativeFilename.Len(), RelativeFilename.GetData())));
+		}
+	}
 	return bResult;
 }
 
-/** Parse the array of strings results of a 'git status' command for a provided list of files all in a common directory
+/** Path of a file relative to the root of the repository, as found in the index (empty if outside of the repository) */
+static FString RelativeToRepositoryRoot(const FString& InRepositoryRoot, const FString& InFile)
+{
+	const FString Root = InRepositoryRoot.EndsWith(TEXT("/")) ? InRepositoryRoot : InRepositoryRoot + TEXT("/");
+	return InFile.StartsWith(Root) ? InFile.RightChop(Root.Len()) : FString();
+}
+
+/** Match the indexed results of a 'git status' command with a provided list of files all in a common directory
  *
  * Called in case of a normal refresh of status on a list of assets in a the Content Browser (or user selected "Refresh" context menu).
  *
- * Example git status results:
-M  Content/Textures/T_Perlin_Noise_M.uasset
-R  Content/Textures/T_Perlin_Noise_M.uasset -> Content/Textures/T_Perlin_Noise_M2.uasset
-?? Content/Materials/M_Basic_Wall.uasset
-!! BasicCode.sln
+ * @see #ParseStatusV2Records() and #ParseStatusV1Records() for examples of 'git status' results
 */
-static void ParseFileStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const TMap<FString, FString>& InLockedFiles, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
+static void ParseFileStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const FGitStatusIndex& InResults, const FGitIndex* InIndex, FGitFileExistenceCache& InExistenceCache, TArray<FGitSourceControlState>& OutStates)
 {
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 	const FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
@@ -891,26 +1535,25 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 	for(const auto& File : InFiles)
 	{
 		FGitSourceControlState FileState(File, InUsingLfsLocking);
-		// Search the file in the list of status
-		int32 IdxResult = InResults.IndexOfByPredicate(FGitStatusFileMatcher(File));
-		if(IdxResult != INDEX_NONE)
+		// Search the file in the index of status
+		const FGitStatusEntry* Result = InResults.Find(File);
+		if(Result != nullptr)
 		{
 			// File found in status results; only the case for "changed" files
-			FGitStatusParser StatusParser(InResults[IdxResult]);
 			// TODO LFS Debug log
-			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) = '%s' => %d"), *File, *InResults[IdxResult], static_cast<int>(StatusParser.State));
+			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) => %d"), *File, static_cast<int>(Result->State));
 
-			FileState.WorkingCopyState = StatusParser.State;
+			FileState.WorkingCopyState = Result->State;
 			if(FileState.IsConflicted())
 			{
-				// In case of a conflict (unmerged file) get the base revision to merge
-				RunGetConflictStatus(InPathToGitBinary, InRepositoryRoot, File, FileState);
+				// The base revision to merge, if given by the status (porcelain v2), else found for all the conflicts at once by RunGetConflictStatus()
+				FileState.SetPendingMergeBaseFileHash(Result->MergeBaseFileHash);
 			}
 		}
 		else
 		{
-			// File not found in status
-			if(FPaths::FileExists(File))
+			// File not found in status: a file tracked by the index would have been listed if modified or deleted (no need to check the disk)
+			if(((InIndex != nullptr) && InIndex->IsTracked(RelativeToRepositoryRoot(InRepositoryRoot, File))) || InExistenceCache.FileExists(File))
 			{
 				// usually means the file is unchanged,
 				FileState.WorkingCopyState = EWorkingCopyState::Unchanged;
@@ -925,10 +1568,11 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 				UE_LOG(LogSourceControl, Log, TEXT("Status(%s) not found and does not exists => new/not controled"), *File);
 			}
 		}
-		if(InLockedFiles.Contains(File))
+		FString LockUser;
+		if(InUsingLfsLocking && FGitLockTable::Get().Find(File, LockUser))
 		{
-			FileState.LockUser = InLockedFiles[File];
-			if(LfsUserName == FileState.LockUser)
+			FileState.LockUser = FGitLockUser(LockUser);
+			if(LfsUserName == LockUser)
 			{
 				FileState.LockState = ELockState::Locked;
 			}
@@ -937,7 +1581,7 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 				FileState.LockState = ELockState::LockedOther;
 			}
 			// TODO LFS Debug log
-			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) Locked by '%s'"), *File, *FileState.LockUser);
+			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) Locked by '%s'"), *File, *LockUser);
 		}
 		else
 		{
@@ -953,26 +1597,30 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 	}
 }
 
-/** Parse the array of strings results of a 'git status' command for a directory
+/** Parse the indexed results of a 'git status' command for a directory
  *
  *  Called in case of a "directory status" (no file listed in the command) ONLY to detect Deleted/Missing/Untracked files
  * since those files are not listed by the 'git ls-files' command.
  *
- * @see #ParseFileStatusResult() above for an example of a 'git status' results
+ * @see #ParseStatusV2Records() above for an example of a 'git status' results
 */
-static void ParseDirectoryStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
+static void ParseDirectoryStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const FString& InDirectory, const FGitStatusIndex& InResults, TArray<FGitSourceControlState>& OutStates)
 {
-	// Iterate on each line of result of the status command
-	for(const FString& Result : InResults)
+	// The status covers other directories as well
+	FString Directory = FPaths::ConvertRelativePathToFull(InRepositoryRoot, InDirectory);
+	if(!Directory.EndsWith(TEXT("/")))
 	{
-		const FString RelativeFilename = FilenameFromGitStatus(Result);
-		const FString File = FPaths::ConvertRelativePathToFull(InRepositoryRoot, RelativeFilename);
+		Directory += TEXT("/");
+	}
 
-		FGitSourceControlState FileState(File, InUsingLfsLocking);
-		FGitStatusParser StatusParser(Result);
-		if((EWorkingCopyState::Deleted == StatusParser.State) || (EWorkingCopyState::Missing == StatusParser.State) || (EWorkingCopyState::NotControlled == StatusParser.State))
+	// Iterate on each file of result of the status command
+	for(const auto& Result : InResults)
+	{
+		const EWorkingCopyState::Type State = Result.Value.State;
+		if(Result.Key.StartsWith(Directory) && ((EWorkingCopyState::Deleted == State) || (EWorkingCopyState::Missing == State) || (EWorkingCopyState::NotControlled == State)))
 		{
-			FileState.WorkingCopyState = StatusParser.State;
+			FGitSourceControlState FileState(Result.Key, InUsingLfsLocking);
+			FileState.WorkingCopyState = State;
 			FileState.TimeStamp.Now();
 			OutStates.Add(MoveTemp(FileState));
 		}
@@ -989,10 +1637,11 @@ static void ParseDirectoryStatusResult(const FString& InPathToGitBinary, const F
  * @param[in]	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
  * @param[in]	InUsingLfsLocking	Tells if using the Git LFS file Locking workflow
  * @param[in]	InFiles				List of files in a directory, or the path to the directory itself (never empty).
- * @param[out]	InResults			Results from the "status" command
+ * @param[in]	InResults			Results from the "status" command, indexed by absolute filename
+ * @param[in]	InIndex				The parsed index of the repository, if available, to tell which files are tracked
  * @param[out]	OutStates			States of files for witch the status has been gathered (distinct than InFiles in case of a "directory status")
  */
-static void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const TMap<FString, FString>& InLockedFiles, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
+static void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const FGitStatusIndex& InResults, const FGitIndex* InIndex, FGitFileExistenceCache& InExistenceCache, TArray<FGitSourceControlState>& OutStates)
 {
 	if((InFiles.Num() == 1) && FPaths::DirectoryExists(InFiles[0]))
 	{
@@ -1005,50 +1654,25 @@ static void ParseStatusResults(const FString& InPathToGitBinary, const FString&
 		const bool bResult = ListFilesInDirectoryRecurse(InPathToGitBinary, InRepositoryRoot, Directory, Files);
 		if(bResult)
 		{
-			ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files, InLockedFiles, InResults, OutStates);
+			ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files, InResults, InIndex, InExistenceCache, OutStates);
 		}
 		// The above cannot detect deleted assets since there is no file left to enumerate (either by the Content Browser or by git ls-files)
 		// => so we also parse the status results to explicitly look for Deleted/Missing assets
-		ParseDirectoryStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InResults, OutStates);
+		ParseDirectoryStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Directory, InResults, OutStates);
 	}
 	else
 	{
 		// 2) General case for one or more files in the same directory.
 		// TODO LFS Debug Log
 		UE_LOG(LogSourceControl, Log, TEXT("ParseStatusResults: 2) General case for one or more files (%s, ...)"), *InFiles[0]);
-		ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InFiles, InLockedFiles, InResults, OutStates);
+		ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InFiles, InResults, InIndex, InExistenceCache, OutStates);
 	}
 }
 
 bool GetAllLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks)
 {
-	bool bResult = true;
-
-	TArray<FString> Locks;
-	FString FileName;
-	bResult &= GetCacheFile(FileName);
-	if (FFileHelper::LoadFileToStringArray(Locks, *FileName)) {
-		for (const auto& Lock : Locks) {
-			TArray<FString> content;
-			Lock.ParseIntoArray(content, TEXT("@"), false);
-			if (bAbsolutePaths) {
-				FString RepoRoot = FPaths::ProjectDir();
-				FindRepoRoot(content[1], RepoRoot);
-				FString AbsFileName = RepoRoot + TEXT("/") + content[1];
-				//UE_LOG(LogSourceControl, Error, TEXT("Locked File Full Path: %s"), *AbsFileName);
-				OutLocks.Add(MoveTemp(AbsFileName), MoveTemp(content[0]));
-			}
-			else {
-				OutLocks.Add(MoveTemp(content[1]), MoveTemp(content[0]));
-			}
-		}
-	}
-	else {
-		bResult = false;
-		UE_LOG(LogSourceControl, Error, TEXT("Cannot load cached locks from %s"), *FileName);
-	}
-
-	return bResult;
+	FGitLockTable::Get().GetAllLocks(bAbsolutePaths, OutLocks);
+	return true;
 }
 
 bool GetAllLocksFromRemote(const FString & InPathToGitBinary, const FString & InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks)
@@ -1057,12 +1681,38 @@ bool GetAllLocksFromRemote(const FString & InPathToGitBinary, const FString & In
 	TArray<FString> AllProjects;
 	GitSourceControlUtils::GetSubModulesRoots(AllProjects);
 	AllProjects.Add(TEXT(""));
+
+	// Requests to the locking API of the LFS servers of all the repositories at once, if they all have one
+	TArray<FString> RepositoryRoots;
+	bool bNativeClient = true;
+	FGitLfsLocksClient& LocksClient = FGitLfsLocksClient::Get();
 	for (const auto& Sub : AllProjects) {
-		FString PathToRepositoryRoot = FPaths::ProjectDir() + Sub;
-		TArray<FString> Results;
-		TArray<FString> ErrorMessages;
-		bResult &= RunCommand(TEXT("lfs locks"), InPathToGitBinary, PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), Results, ErrorMessages);
-		for (const FString& Result : Results)
+		RepositoryRoots.Add(FPaths::ProjectDir() + Sub);
+		bNativeClient &= LocksClient.IsAvailable(InPathToGitBinary, RepositoryRoots.Last());
+	}
+	if (bNativeClient) {
+		TArray<TArray<FGitLfsLock>> Locks;
+		bResult = LocksClient.ListLocks(InPathToGitBinary, RepositoryRoots, Locks);
+		for (int32 Index = 0; Index < RepositoryRoots.Num(); ++Index) {
+			for (FGitLfsLock& Lock : Locks[Index]) {
+				OutLocks.Add(bAbsolutePaths ? FPaths::ConvertRelativePathToFull(RepositoryRoots[Index], Lock.Path) : MoveTemp(Lock.Path), MoveTemp(Lock.Owner));
+			}
+		}
+		for (const auto& PathToRepositoryRoot : RepositoryRoots) {
+			// The server refused the credentials: the git lfs commands may authenticate otherwise
+			bNativeClient &= LocksClient.IsAvailable(InPathToGitBinary, PathToRepositoryRoot);
+		}
+		if (bResult || bNativeClient) {
+			return bResult;
+		}
+		OutLocks.Reset();
+		bResult = true;
+	}
+
+	for (const auto& PathToRepositoryRoot : RepositoryRoots) {
+		FGitOutputReader Reader;
+		bResult &= RunCommandInternalStreamed(TEXT("lfs locks"), InPathToGitBinary, PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), Reader, OutErrorMessages);
+		for (const FStringView& Result : Reader.GetRecords())
 		{
 			FGitLfsLocksParser LockFile(PathToRepositoryRoot, Result, bAbsolutePaths);
 			OutLocks.Add(MoveTemp(LockFile.LocalFilename), MoveTemp(LockFile.LockUser));
@@ -1071,28 +1721,141 @@ bool GetAllLocksFromRemote(const FString & InPathToGitBinary, const FString & In
 	return bResult;
 }
 
+/**
+ * Find the files that are unchanged since they were last committed or checked-out, without running "git status":
+ * their stat data match their entry in the index, and the index matches the HEAD commit (nothing staged).
+ */
+static void SplitUnchangedFiles(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FGitIndex* InIndex, const TArray<FString>& InFiles, TArray<FString>& OutUnchangedFiles, TArray<FString>& OutFilesToQuery)
+{
+	if((InIndex == nullptr) || InIndex->HasConflicts() || InIndex->GetRootTreeHash().IsEmpty())
+	{
+		OutFilesToQuery = InFiles;
+		return;
+	}
+
+	for(const auto& File : InFiles)
+	{
+		const FString RelativeFile = RelativeToRepositoryRoot(InRepositoryRoot, File);
+		if(!RelativeFile.IsEmpty() && InIndex->IsUnchanged(RelativeFile, IFileManager::Get().GetStatData(*File)))
+		{
+			OutUnchangedFiles.Add(File);
+		}
+		else
+		{
+			OutFilesToQuery.Add(File);
+		}
+	}
+
+	if(OutUnchangedFiles.Num() > 0)
+	{
+		// The cache tree of the index is the tree of HEAD only if nothing is staged (served by the "cat-file --batch-check" helper)
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--verify"));
+		Parameters.Add(TEXT("--quiet"));
+		Parameters.Add(TEXT("HEAD^{tree}"));
+		TArray<FString> Results;
+		TArray<FString> ErrorMessages;
+		const bool bIndexMatchesHead = RunCommandInternal(TEXT("rev-parse"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages) && (Results.Num() == 1) && (Results[0] == InIndex->GetRootTreeHash());
+		if(!bIndexMatchesHead)
+		{
+			OutFilesToQuery.Append(OutUnchangedFiles);
+			OutUnchangedFiles.Reset();
+		}
+	}
+}
+
+/**
+ * Get the base revision to merge of all the conflicts of a status whose records did not give it (porcelain v1),
+ * from the unmerged entries of the index, else with a single "ls-files" command for the whole repository.
+ *
+ * Example output of git ls-files --unmerged -z (one NUL-terminated record per stage of each unmerged file)
+100644 d9b33098273547b57c0af314136f35b494e16dcb 1	Content/Blueprints/BP_Test.uasset
+100644 a14347dc3b589b78fb19ba62a7e3982f343718bc 2	Content/Blueprints/BP_Test.uasset
+100644 f3137a7167c840847cd7bd2bf07eefbfb2d9bcd2 3	Content/Blueprints/BP_Test.uasset
+ *
+ * 1: The "common ancestor" of the file (the version of the file that both the current and other branch originated from).
+ * 2: The version from the current branch (the master branch in this case).
+ * 3: The version from the other branch (the test branch)
+*/
+static void RunGetConflictStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FGitIndex* InIndex, TArray<FGitSourceControlState>& InOutStates, const int32 InFirstState)
+{
+	TArray<FGitSourceControlState*> Conflicts;
+	for(int32 StateIndex = InFirstState; StateIndex < InOutStates.Num(); ++StateIndex)
+	{
+		FGitSourceControlState& State = InOutStates[StateIndex];
+		if(!State.IsConflicted() || State.PendingMergeBaseFileHash != FSHAHash())
+		{
+			continue;
+		}
+		FString MergeBaseFileHash;
+		if((InIndex != nullptr) && InIndex->FindMergeBaseFileHash(RelativeToRepositoryRoot(InRepositoryRoot, State.LocalFilename), MergeBaseFileHash))
+		{
+			State.SetPendingMergeBaseFileHash(MergeBaseFileHash);
+		}
+		else
+		{
+			Conflicts.Add(&State);
+		}
+	}
+	if(Conflicts.Num() == 0)
+	{
+		return;
+	}
+
+	// The unmerged files of the whole repository: only the conflicts are listed, whatever the number of files of the status
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("--unmerged"));
+	Parameters.Add(TEXT("-z"));
+	FGitOutputReader Reader(TEXT('\0'));
+	TArray<FString> ErrorMessages;
+	if(!RunCommandInternalStreamed(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Reader, ErrorMessages))
+	{
+		return;
+	}
+	TMap<FString, FString> MergeBaseFileHashes;
+	for(const FStringView& Record : Reader.GetRecords())
+	{
+		// "<mode> <object> <stage>\t<file>": keep the object of the stage 1, the common ancestor
+		int32 TabIndex = INDEX_NONE;
+		if(Record.FindChar(TEXT('\t'), TabIndex) && TabIndex == 49 && Record[TabIndex - 1] == TEXT('1'))
+		{
+			const FStringView RelativeFilename = Record.RightChop(TabIndex + 1);
+			MergeBaseFileHashes.Add(FPaths::ConvertRelativePathToFull(InRepositoryRoot, FString(RelativeFilename.Len(), RelativeFilename.GetData())), FString(40, Record.GetData() + 7));
+		}
+	}
+	for(FGitSourceControlState* State : Conflicts)
+	{
+		if(const FString* MergeBaseFileHash = MergeBaseFileHashes.Find(State->LocalFilename))
+		{
+			State->SetPendingMergeBaseFileHash(*MergeBaseFileHash);
+		}
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("RunGetConflictStatus: base revisions of %d conflicts from a single ls-files"), Conflicts.Num());
+}
+
 // Run a batch of Git "status" command to update status of given files and/or directories.
 bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates)
 {
 	FGitSourceControlLocksWorker::PushUpdates(0);
 
 	bool bResults = true;
-	TMap<FString, FString> LockedFiles;
 
-	// 0) Issue a "git lfs locks" command at the root of the repository
-	if(InUsingLfsLocking)
-	{
-		TArray<FString> ErrorMessages;
-		GetAllLocks(InPathToGitBinary, InRepositoryRoot, true, ErrorMessages, LockedFiles);
-	}
-	//for (const auto& Lock : LockedFiles) {
-	//	UE_LOG(LogSourceControl, Warning, TEXT("GetAllLocks returns: %s, %s"), *Lock.Key, *Lock.Value);
-	//}
+	// 0) The locks are looked up file by file in the lock table, kept up to date by the locks worker
+
+	// The index tells which files are tracked, and which ones have not been modified since they were last committed or checked-out
+	const TSharedPtr<const FGitIndex, ESPMode::ThreadSafe> Index = FGitIndexCache::Get().GetIndex(InRepositoryRoot);
+	TArray<FString> UnchangedFiles;
+	TArray<FString> FilesToQuery;
+	SplitUnchangedFiles(InPathToGitBinary, InRepositoryRoot, Index.Get(), InFiles, UnchangedFiles, FilesToQuery);
+	UE_LOG(LogSourceControl, Log, TEXT("RunUpdateStatus: %d files unchanged according to the index, %d to query"), UnchangedFiles.Num(), FilesToQuery.Num());
+
+	// Files not tracked by the index are checked on disk, one listing per directory
+	FGitFileExistenceCache ExistenceCache;
 
 	// Git status does not show any "untracked files" when called with files from different subdirectories! (issue #3)
-	// 1) So here we group files by path (ie. by subdirectory)
+	// 1) So here we group files by path (ie. by subdirectory), and use the subdirectories as pathspecs
 	TMap<FString, TArray<FString>> GroupOfFiles;
-	for(const auto& File : InFiles)
+	for(const auto& File : FilesToQuery)
 	{
 		const FString Path = FPaths::GetPath(*File);
 		TArray<FString>* Group = GroupOfFiles.Find(Path);
@@ -1108,76 +1871,67 @@ bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InReposito
 		}
 	}
 
-	// Get the current branch name, since we need origin of current branch
-	FString BranchName;
-	GitSourceControlUtils::GetBranchName(InPathToGitBinary, InRepositoryRoot, BranchName);
-
+	// Porcelain v2 gives structured records, with the base of conflicts (Git 2.11), and "-z" gives verbatim paths
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const bool bPorcelainV2 = GitSourceControl.GetProvider().GetGitVersion().bHasStatusPorcelainV2;
 	TArray<FString> Parameters;
-	Parameters.Add(TEXT("--porcelain"));
+	Parameters.Add(bPorcelainV2 ? TEXT("--porcelain=v2") : TEXT("--porcelain"));
+	Parameters.Add(TEXT("-z"));
 	Parameters.Add(TEXT("--ignored"));
 
-	// 2) then we can batch git status operation by subdirectory
+	// 2) then we run a single status operation for all the subdirectories (and single files) of the repository
+	// "git status" can only detect renamed and deleted files when it operate on a folder, so use one folder path for all files in a directory
+	TArray<FString> Pathspecs;
+	int32 PathspecsLength = 0;
 	for(const auto& Files : GroupOfFiles)
 	{
-		// "git status" can only detect renamed and deleted files when it operate on a folder, so use one folder path for all files in a directory
-		const FString Path = FPaths::GetPath(*Files.Value[0]);
-		TArray<FString> OnePath;
 		// Only one file: optim very useful for the .uproject file at the root to avoid parsing the whole repository
 		// (works only if the file exists)
-		if((Files.Value.Num() == 1) && (FPaths::FileExists(Files.Value[0])))
+		const FString& Pathspec = ((Files.Value.Num() == 1) && (ExistenceCache.FileExists(Files.Value[0]))) ? Files.Value[0] : Files.Key;
+		Pathspecs.AddUnique(Pathspec);
+		PathspecsLength += Pathspec.Len() + 3; // quotes and space
+	}
+	if(PathspecsLength > GitSourceControlConstants::MaxPathspecsLength)
+	{
+		// Too many directories for one command line: a status of the whole repository is cheaper than many status commands
+		UE_LOG(LogSourceControl, Log, TEXT("RunUpdateStatus: %d paths do not fit on the command line, get the status of the whole repository"), Pathspecs.Num());
+		Pathspecs.Reset();
+	}
+
+	FGitStatusIndex StatusIndex;
+	FGitOutputReader Reader(TEXT('\0'));
+	const int32 FirstState = OutStates.Num();
+	const bool bResult = (FilesToQuery.Num() == 0) || RunCommandInternalStreamed(TEXT("status"), InPathToGitBinary, InRepositoryRoot, Parameters, Pathspecs, Reader, OutErrorMessages);
+	if(bResult)
+	{
+		// Index the results once, so that each file lookup is a single hash search
+		if(bPorcelainV2)
 		{
-			OnePath.Add(Files.Value[0]);
+			ParseStatusV2Records(InRepositoryRoot, Reader.GetRecords(), StatusIndex);
 		}
 		else
 		{
-			OnePath.Add(Path);
+			ParseStatusV1Records(InRepositoryRoot, Reader.GetRecords(), StatusIndex);
 		}
+
+		// 3) and distribute the results to the files of each subdirectory
+		for(const auto& Files : GroupOfFiles)
 		{
-			TArray<FString> Results;
-			TArray<FString> ErrorMessages;
-			const bool bResult = RunCommand(TEXT("status"), InPathToGitBinary, InRepositoryRoot, Parameters, OnePath, Results, ErrorMessages);
-			OutErrorMessages.Append(ErrorMessages);
-			if(bResult)
-			{
-				ParseStatusResults(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files.Value, LockedFiles, Results, OutStates);
-			}
+			ParseStatusResults(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files.Value, StatusIndex, Index.Get(), ExistenceCache, OutStates);
 		}
 
-		//if (!BranchName.IsEmpty())
-		//{
-		//	// Using git diff, we can obtain a list of files that were modified between our current origin and HEAD. Assumes that fetch has been run to get accurate info.
-		//	// TODO: should do a fetch (at least periodically).
-		//	TArray<FString> Results;
-		//	TArray<FString> ErrorMessages;
-		//	TArray<FString> ParametersLsRemote;
-		//	ParametersLsRemote.Add(TEXT("origin"));
-		//	ParametersLsRemote.Add(BranchName);
-		//	const bool bResultLsRemote = RunCommand(TEXT("ls-remote"), InPathToGitBinary, InRepositoryRoot, ParametersLsRemote, OnePath, Results, ErrorMessages);
-		//	// If the command is successful and there is only 1 line on the output the branch exists on remote
-		//	const bool bDiffAgainstRemote = bResultLsRemote && Results.Num();
-
-		//	Results.Reset();
-		//	ErrorMessages.Reset();
-		//	TArray<FString> ParametersLog;
-		//	ParametersLog.Add(TEXT("--pretty=")); // this omits the commit lines, just gets us files
-		//	ParametersLog.Add(TEXT("--name-only"));
-		//	ParametersLog.Add(bDiffAgainstRemote ? TEXT("HEAD..HEAD@{upstream}") : BranchName);
-		//	const bool bResultDiff = RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, ParametersLog, OnePath, Results, ErrorMessages);
-		//	OutErrorMessages.Append(ErrorMessages);
-		//	if (bResultDiff)
-		//	{
-		//		for (const FString& NewerFileName : Results)
-		//		{
-		//			const FString NewerFilePath = FPaths::ConvertRelativePathToFull(InRepositoryRoot, NewerFileName);
-
-		//			// Find existing corresponding file state to update it (not found would mean new file or not in the current path)
-		//			if (FGitSourceControlState* FileStatePtr = OutStates.FindByPredicate([NewerFilePath](FGitSourceControlState& FileState) { return FileState.LocalFilename == NewerFilePath; }))
-		//			{
-		//				FileStatePtr->bNewerVersionOnServer = true;
-		//			}
-		//		}
-		//	}
-		//}
+		// 4) and the files found unchanged in the index (not listed in the status results)
+		if(UnchangedFiles.Num() > 0)
+		{
+			ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, UnchangedFiles, StatusIndex, Index.Get(), ExistenceCache, OutStates);
+		}
+
+		// 5) then the base revisions to merge of all the conflicts at once
+		RunGetConflictStatus(InPathToGitBinary, InRepositoryRoot, Index.Get(), OutStates, FirstState);
+	}
+	else
+	{
+		bResults = false;
 	}
 
 	return bResults;
@@ -1226,31 +1980,8 @@ bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepository
 
 	UE_LOG(LogSourceControl, Log, TEXT("RunDumpToFile: 'git %s'"), *FullCommand);
 
-    FString PathToGitOrEnvBinary = InPathToGitBinary;
-    #if PLATFORM_MAC
-        // The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
-        FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
-        FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
-
-        TArray<FString> PathArray;
-        PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
-        bool bHasGitInstallPath = false;
-        for (auto Path : PathArray)
-        {
-            if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
-            {
-                bHasGitInstallPath = true;
-                break;
-            }
-        }
-
-        if (!bHasGitInstallPath)
-        {
-            PathToGitOrEnvBinary = FString("/usr/bin/env");
-            FullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *FullCommand);
-        }
-    #endif
-    
+	const FString PathToGitOrEnvBinary = GetGitOrEnvBinary(InPathToGitBinary, FullCommand);
+	FGitProcessPool::CountProcessSpawn();
 	FProcHandle ProcessHandle = FPlatformProcess::CreateProc(*PathToGitOrEnvBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *InRepositoryRoot, PipeWrite);
 	if(ProcessHandle.IsValid())
 	{
@@ -1376,12 +2107,12 @@ Date:   2014-2015-05-12 11:28:14 +0200
 A	Content/Blueprints/Blueprint_CeilingLight.uasset
 C099	Content/Textures/T_Concrete_Poured_N.uasset Content/Textures/T_Concrete_Poured_N2.uasset
 */
-static void ParseLogResults(const TArray<FString>& InResults, TGitSourceControlHistory& OutHistory)
+static void ParseLogResults(const TArray<FStringView>& InResults, TGitSourceControlHistory& OutHistory)
 {
 	TSharedRef<FGitSourceControlRevision, ESPMode::ThreadSafe> SourceControlRevision = MakeShareable(new FGitSourceControlRevision);
-	for(const auto& Result : InResults)
+	for(const FStringView& Result : InResults)
 	{
-		if(Result.StartsWith(TEXT("commit "))) // Start of a new commit
+		if(Result.StartsWith(TEXT("commit "), ESearchCase::CaseSensitive)) // Start of a new commit
 		{
 			// End of the previous commit
 			if(SourceControlRevision->RevisionNumber != 0)
@@ -1390,41 +2121,53 @@ static void ParseLogResults(const TArray<FString>& InResults, TGitSourceControlH
 
 				SourceControlRevision = MakeShareable(new FGitSourceControlRevision);
 			}
-			SourceControlRevision->CommitId = Result.RightChop(7); // Full commit SHA1 hexadecimal string
+			const FStringView CommitId = Result.RightChop(7);
+			SourceControlRevision->CommitId = FString(CommitId.Len(), CommitId.GetData()); // Full commit SHA1 hexadecimal string
 			SourceControlRevision->ShortCommitId = SourceControlRevision->CommitId.Left(8); // Short revision ; first 8 hex characters (max that can hold a 32 bit integer)
 			SourceControlRevision->CommitIdNumber = FParse::HexNumber(*SourceControlRevision->ShortCommitId);
 			SourceControlRevision->RevisionNumber = -1; // RevisionNumber will be set at the end, based off the index in the History
 		}
-		else if(Result.StartsWith(TEXT("Author: "))) // Author name & email
+		else if(Result.StartsWith(TEXT("Author: "), ESearchCase::CaseSensitive)) // Author name & email
 		{
 			// Remove the 'email' part of the UserName
-			FString UserNameEmail = Result.RightChop(8);
+			const FStringView UserNameEmail = Result.RightChop(8);
 			int32 EmailIndex = 0;
 			if(UserNameEmail.FindLastChar('<', EmailIndex))
 			{
-				SourceControlRevision->UserName = UserNameEmail.Left(EmailIndex - 1);
+				SourceControlRevision->UserName = FString(FMath::Max(EmailIndex - 1, 0), UserNameEmail.GetData());
 			}
 		}
-		else if(Result.StartsWith(TEXT("Date:   "))) // Commit date
+		else if(Result.StartsWith(TEXT("Date:   "), ESearchCase::CaseSensitive)) // Commit date
 		{
-			FString Date = Result.RightChop(8);
-			SourceControlRevision->Date = FDateTime::FromUnixTimestamp(FCString::Atoi(*Date));
+			// Raw date: Unix timestamp followed by the timezone
+			int64 Timestamp = 0;
+			for(const TCHAR Digit : Result.RightChop(8))
+			{
+				if(!FChar::IsDigit(Digit))
+				{
+					break;
+				}
+				Timestamp = Timestamp * 10 + (Digit - TEXT('0'));
+			}
+			SourceControlRevision->Date = FDateTime::FromUnixTimestamp(Timestamp);
 		}
-	//	else if(Result.IsEmpty()) // empty line before/after commit message has already been taken care by FString::ParseIntoArray()
-		else if(Result.StartsWith(TEXT("    ")))  // Multi-lines commit message
+	//	else if(Result.IsEmpty()) // empty line before/after commit message has already been culled by the output reader
+		else if(Result.StartsWith(TEXT("    "), ESearchCase::CaseSensitive))  // Multi-lines commit message
 		{
-			SourceControlRevision->Description += Result.RightChop(4);
+			const FStringView Line = Result.RightChop(4);
+			SourceControlRevision->Description.AppendChars(Line.GetData(), Line.Len());
 			SourceControlRevision->Description += TEXT("\n");
 		}
 		else // Name of the file, starting with an uppercase status letter ("A"/"M"...)
 		{
-			const TCHAR Status = Result[0];
-			SourceControlRevision->Action = LogStatusToString(Status); // Readable action string ("Added", Modified"...) instead of "A"/"M"...
 			// Take care of special case for Renamed/Copied file: extract the second filename after second tabulation
 			int32 IdxTab;
 			if(Result.FindLastChar('\t', IdxTab))
 			{
-				SourceControlRevision->Filename = Result.RightChop(IdxTab + 1); // relative filename
+				const TCHAR Status = Result[0];
+				SourceControlRevision->Action = LogStatusToString(Status); // Readable action string ("Added", Modified"...) instead of "A"/"M"...
+				const FStringView Filename = Result.RightChop(IdxTab + 1);
+				SourceControlRevision->Filename = FString(Filename.Len(), Filename.GetData()); // relative filename
 			}
 		}
 	}
@@ -1489,7 +2232,6 @@ bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepository
 	}
 	bool bResults;
 	{
-		TArray<FString> Results;
 		TArray<FString> Parameters;
 		Parameters.Add(TEXT("--follow")); // follow file renames
 		Parameters.Add(TEXT("--date=raw"));
@@ -1504,10 +2246,31 @@ bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepository
 		}
 		TArray<FString> Files;
 		Files.Add(*InFile);
-		bResults = RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Results, OutErrorMessages);
+		FGitOutputReader Reader;
+		bResults = RunCommandInternalStreamed(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Reader, OutErrorMessages);
 		if(bResults)
 		{
-			ParseLogResults(Results, OutHistory);
+			ParseLogResults(Reader.GetRecords(), OutHistory);
+		}
+	}
+	if(bResults && OutHistory.Num() > 0)
+	{
+		// Get file (blob) sha1 id and size of all revisions at once from the long-lived "cat-file --batch-check" helper
+		TArray<FString> ObjectNames;
+		ObjectNames.Reserve(OutHistory.Num());
+		for(const auto& Revision : OutHistory)
+		{
+			ObjectNames.Add(FString::Printf(TEXT("%s:%s"), *Revision->GetRevision(), *Revision->GetFilename()));
+		}
+		TArray<FGitObjectInfo> ObjectInfos;
+		if(FGitProcessPool::Get().BatchCheck(InPathToGitBinary, RepositoryRoot, ObjectNames, ObjectInfos) && (ObjectInfos.Num() == OutHistory.Num()))
+		{
+			for(int32 RevisionIndex = 0; RevisionIndex < OutHistory.Num(); ++RevisionIndex)
+			{
+				OutHistory[RevisionIndex]->FileHash = ObjectInfos[RevisionIndex].Hash;
+				OutHistory[RevisionIndex]->FileSize = static_cast<int32>(ObjectInfos[RevisionIndex].Size);
+			}
+			return bResults;
 		}
 	}
 	for(auto& Revision : OutHistory)
@@ -1573,15 +2336,8 @@ bool UpdateCachedStates(const TArray<FGitSourceControlState>& InStates)
 	// TODO without LFS : Workaround a bug with the Source Control Module not updating file state after a simple "Save" with no "Checkout" (when not using File Lock)
 	const FDateTime Now = bUsingGitLfsLocking ? FDateTime::Now() : FDateTime();
 
-	for(const auto& InState : InStates)
-	{
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = Provider.GetStateInternal(InState.LocalFilename);
-		*State = InState;
-		//State->WorkingCopyState = InState.WorkingCopyState;
-		//State->LockState = InState.LockState;
-		//State->LockUser = InState.LockUser;
-		State->TimeStamp = Now;
-	}
+	// Applied later by the game thread, in slices, so that a status of the whole repository does not stall a single frame
+	Provider.QueueStates(InStates, Now);
 
 	return (InStates.Num() > 0);
 }
@@ -1631,182 +2387,31 @@ void RemoveRedundantErrors(FGitSourceControlCommand& InCommand, const FString& I
 	}
 }
 
-// Save locks to cache file (local user's lock)
-bool CacheLock(TArray<FString>& InFiles) {
-	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
-	FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
-
-	TArray<FString> lockedFiles;
-	FString FileName;
-	bool bResult = GetCacheFile(FileName);
-
-	if (FFileHelper::LoadFileToStringArray(lockedFiles, *FileName)) {
-		for (const auto& f : lockedFiles) {
-			UE_LOG(LogSourceControl, Log, TEXT("locked file: %s"), *f);
-		}
-		for (const auto& ad : InFiles) {
-			UE_LOG(LogSourceControl, Log, TEXT("currently locking file: %s"), *ad);
-			FString UserFile = LfsUserName + TEXT("@") + ad;
-			if (!lockedFiles.Contains(UserFile)) lockedFiles.Add(UserFile);
-		}
-		if (FFileHelper::SaveStringArrayToFile(lockedFiles, *FileName))
-		{
-			UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Successfully Written: \"%d\" FStrings to locks_cache"), lockedFiles.Num());
-		}
-		else
-		{
-			bResult = false;
-			UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Failed to write FString to file."));
-		}
-	}
-	else {
-		bResult = false;
-		UE_LOG(LogSourceControl, Log, TEXT("cannot open locks_cache"));
-	}
-	return bResult;
-}
-
-// Remove a lock from lock cache file (local user's lock)
-bool CacheLockRemove(TArray<FString>& InFiles) {
+// Record the locks of the local user in the lock table
+bool CacheLock(const FString& InRepositoryRoot, const TArray<FString>& InFiles)
+{
 	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
-	FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
-
-	TArray<FString> lockedFiles;
-	FString FileName;
-	bool bResult = GetCacheFile(FileName);
-
-	if (FFileHelper::LoadFileToStringArray(lockedFiles, *FileName)) {
-		for (auto rm : InFiles) {
-			UE_LOG(LogSourceControl, Log, TEXT("removing file: %s from local cache"), *rm);
-			FString UserFile = LfsUserName + TEXT("@") + rm;
-			lockedFiles.RemoveSwap(UserFile, true);
-		}
-		if (FFileHelper::SaveStringArrayToFile(lockedFiles, *FileName))
-		{
-			UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Successfully Written: \"%d\" FStrings to locks_cache"), lockedFiles.Num());
-		}
-		else
-		{
-			bResult = false;
-			UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Failed to write FString to file."));
-		}
-	}
-	else {
-		bResult = false;
-		UE_LOG(LogSourceControl, Log, TEXT("cannot open locks_cache"));
-	}
-	return bResult;
+	return FGitLockTable::Get().Lock(InRepositoryRoot, InFiles, GitSourceControl.AccessSettings().GetLfsUserName());
 }
 
-
-bool GetCacheFile(FString & FileName)
+// Remove locks of the local user from the lock table
+bool CacheLockRemove(const FString& InRepositoryRoot, const TArray<FString>& InFiles)
 {
-	bool bResults = true;
-	IPlatformFile& FileManager = FPlatformFileManager::Get().GetPlatformFile();
-	FileName = FPaths::ProjectDir();
-	FileName.Append(TEXT("locks_cache"));
-	UE_LOG(LogSourceControl, Log, TEXT("lockedFiles path: %s"), *FileName);
-	if (!FileManager.FileExists(*FileName)) {
-		UE_LOG(LogTemp, Warning, TEXT("FileManipulation: locks_cache not fount, Creating..."));
-		TArray<FString> temp;
-		IFileHandle* handle = FileManager.OpenWrite(*FileName);
-		if (handle) {
-			delete handle;
-			UE_LOG(LogTemp, Warning, TEXT("FileManipulation: locks_cache successfully created!"));
-
-		}
-		else {
-			UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Failed to create locks_cache!"));
-		}
-	}
-	return bResults;
+	return FGitLockTable::Get().Unlock(InRepositoryRoot, InFiles);
 }
 
 bool UpdateLockCaches(TArray<FString>& Changed, const FString& PathToGitBinary, const FString& PathToRepositoryRoot, const FString& LfsUserName)
 {
-	bool bResult = false;
-
 	TMap<FString, FString> RemoteLocks;
 	TArray<FString> ErrorMessage;
-	GetAllLocksFromRemote(PathToGitBinary, PathToRepositoryRoot, false, ErrorMessage, RemoteLocks);
-
-	while (FGitSourceControlLocksWorker::IsWrittingCache()) {}
-	FGitSourceControlLocksWorker::LockCache();
-
-	TMap<FString, FString> CacheLocks;
-	GetAllLocks(PathToGitBinary, PathToRepositoryRoot, false, ErrorMessage, CacheLocks);
-	for (const auto& Lock : RemoteLocks) {
-		if (!CacheLocks.Contains(Lock.Key)) Changed.Add(Lock.Key);
-		UE_LOG(LogSourceControl, Warning, TEXT("remote lock: %s, by %s"), *Lock.Key, *Lock.Value);
-	}
-	for (const auto& Lock : CacheLocks) {
-		if (!RemoteLocks.Contains(Lock.Key)) Changed.Add(Lock.Key);
-		UE_LOG(LogSourceControl, Warning, TEXT("cached lock: %s, by %s"), *Lock.Key, *Lock.Value);
-	}
-
-	//TArray<FString> ToBeRm;
-	//for (auto Lock : CacheLocks) {
-	//	FString* temp = RemoteLocks.Find(Lock.Key);
-	//	if (temp != nullptr && *temp != Lock.Value) {
-	//		CacheLocks[Lock.Key] = *temp;
-	//		Lock.Value = *temp;
-	//	}
-	//	if (Lock.Value == LfsUserName) {
-	//		if (!RemoteLocks.Contains(Lock.Key)) {
-	//			TArray<FString> OneFile;
-	//			OneFile.Add(Lock.Key);
-	//			FString RepoRoot = PathToRepositoryRoot;
-	//			FindRepoRoot(Lock.Key, RepoRoot);
-	//			FGitSourceControlLocksWorker::PushCommand(TEXT("lfs lock"), PathToGitBinary, RepoRoot, TArray<FString>(), OneFile);
-	//		}
-	//	}
-	//	else {
-	//		if (!RemoteLocks.Contains(Lock.Key)) {
-	//			ToBeRm.Add(Lock.Key);
-	//			bResult = true;
-	//			Changed.Add(Lock.Key);
-	//		}
-	//	}
-	//}
-	//for (const auto& Lock : RemoteLocks) {
-	//	if (Lock.Value == LfsUserName) {
-	//		if (!CacheLocks.Contains(Lock.Key)) {
-	//			TArray<FString> OneFile;
-	//			OneFile.Add(Lock.Key);
-	//			FString RepoRoot = PathToRepositoryRoot;
-	//			FindRepoRoot(Lock.Key, RepoRoot);
-	//			FGitSourceControlLocksWorker::PushCommand(TEXT("lfs unlock"), PathToGitBinary, RepoRoot, TArray<FString>(), OneFile);
-	//		}
-	//	}
-	//	else {
-	//		if (!CacheLocks.Contains(Lock.Key)) {
-	//			CacheLocks.Add(Lock.Key, Lock.Value);
-	//			bResult = true;
-	//			Changed.Add(Lock.Key);
-	//		}
-	//	}
-	//}
-	//for (const auto& Lock : ToBeRm) {
-	//	UE_LOG(LogSourceControl, Error, TEXT("removing lock: %s"), *Lock);
-	//	CacheLocks.Remove(Lock);
-	//}
-	TArray<FString> UserFileString;
-	for (const auto& Lock : RemoteLocks) {
-		FString UserFile = Lock.Value + TEXT("@") + Lock.Key;
-		UserFileString.Add(UserFile);
-	}
-	FString FileName;
-	GetCacheFile(FileName);
-	if (FFileHelper::SaveStringArrayToFile(UserFileString, *FileName))
-	{
-		UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Successfully Written: \"%d\" FStrings to the locks_cache"), UserFileString.Num());
-	}
-	else
+	if(!GetAllLocksFromRemote(PathToGitBinary, PathToRepositoryRoot, true, ErrorMessage, RemoteLocks))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("FileManipulation: Failed to write FString to locks_cache."));
+		return false;
 	}
-	FGitSourceControlLocksWorker::UnlockCache();
-	return bResult;
+
+	// Only replace the local locks by the ones of the server if it answered for all the repositories
+	FGitLockTable::Get().Reset(RemoteLocks, Changed);
+	return true;
 }
 
 bool GetSubModulesRoots(TArray<FString>& SubModules)
@@ -1846,6 +2451,12 @@ bool GetSubModulesRoots(TArray<FString>& SubModules)
 }
 
 bool FindRepoRoot(const FString & FileName, FString & RepoRoot)
+{
+	FGitFileExistenceCache ExistenceCache;
+	return FindRepoRoot(FileName, RepoRoot, ExistenceCache);
+}
+
+bool FindRepoRoot(const FString& FileName, FString& RepoRoot, FGitFileExistenceCache& InExistenceCache)
 {
 	bool bResult = true;
 	TArray<FString> AllProjects;
@@ -1856,7 +2467,7 @@ bool FindRepoRoot(const FString & FileName, FString & RepoRoot)
 		else TempRoot += TEXT("/") + Sub;
 		if (FPaths::IsRelative(FileName)) {
 			FString AbsFileName = TempRoot + TEXT("/") + FileName;
-			if (FPaths::FileExists(AbsFileName)) {
+			if (InExistenceCache.FileExists(AbsFileName)) {
 				RepoRoot = TempRoot;
 				break;
 			}
@@ -9,6 +9,8 @@
 #include "GitSourceControlState.h"
 
 class FGitSourceControlCommand;
+class FGitOutputReader;
+class FGitFileExistenceCache;
 
 /**
  * Helper struct for maintaining temporary files for passing to commands
@@ -71,6 +73,15 @@ void FindGitCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersi
  */
  void FindGitLfsCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersion);
 
+/**
+ * Get the binary to launch for a Git command, and adapt the command line if needed
+ * (on Mac, Git is launched through /usr/bin/env to add its install directory to the PATH)
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InOutFullCommand	The full command line, prefixed in place if needed
+ * @returns the path to the binary to launch
+ */
+FString GetGitOrEnvBinary(const FString& InPathToGitBinary, FString& InOutFullCommand);
+
 /**
  * Find the root of the Git repository, looking from the provided path and upward in its parent directories
  * @param InPath				The path to the Game Directory (or any path or file in any git repository)
@@ -79,6 +90,13 @@ void FindGitCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersi
  */
 bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot);
 
+/**
+ * Find the Git directory of a repository: its ".git/" subdirectory, or the directory referenced by its ".git" file for a submodule or a worktree
+ * @param InRepositoryRoot		The path to the root directory of the Git repository
+ * @returns the path to the Git directory, or an empty string if not found
+ */
+FString GetGitDirectory(const FString& InRepositoryRoot);
+
 /**
  * Get Git config user.name & user.email
  * @param	InPathToGitBinary	The path to the Git binary
@@ -88,6 +106,16 @@ bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot);
  */
 void GetUserConfig(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutUserName, FString& OutUserEmail);
 
+/**
+ * Enable the config values speeding up "git status" in the repository (file system monitor, untracked cache, many files, index v4),
+ * depending on the capabilities of Git (without measuring them: see the "Git.Benchmark.StatusAcceleration" console command)
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository (or submodule) to configure
+ * @param	InVersion			The version and capabilities of Git
+ * @returns true if the command succeeded and returned no errors
+ */
+bool ConfigureStatusAcceleration(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FGitVersion& InVersion);
+
 /**
  * Get Git current checked-out branch
  * @param	InPathToGitBinary	The path to the Git binary
@@ -131,7 +159,56 @@ bool GetRemoteUrl(const FString& InPathToGitBinary, const FString& InRepositoryR
 bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
 
 /**
- * Run a Git "commit" command by batches.
+ * Run a Git LFS "lfs lock" or "lfs unlock" command on many files, with as few requests to the LFS server as the version of Git LFS allows
+ *
+ * @param	InCommand			"lfs lock" or "lfs unlock"
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command
+ * @param	InFiles				The files to lock or unlock, relative to the repository root
+ * @param	OutFailedFiles		The files that could not be locked or unlocked
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if all the files were locked or unlocked
+ */
+bool RunLfsLockCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutFailedFiles, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git command and stream its output into a reader, that splits it into views on records without a string per line.
+ *
+ * Unlike RunCommand(), files are not batched, and error messages are mixed with the output (only the return code tells about failures).
+ *
+ * @param	InCommand			The Git command - e.g. status
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
+ * @param	InParameters		The parameters to the Git command
+ * @param	InFiles				The files to be operated on
+ * @param	OutReader			The reader accumulating the output (finished when returning)
+ * @param	OutErrorMessages	Error messages from the standard error of the command
+ * @returns true if the command succeeded
+ */
+bool RunCommandStreamed(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FGitOutputReader& OutReader, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git command on a list of files in a single invocation, whatever the number of files.
+ *
+ * The files are passed through a temporary "--pathspec-from-file" when supported by the command and the version of Git
+ * (add, checkout, reset and commit since Git 2.25, rm since Git 2.26), else it falls back to RunCommand() by batches.
+ *
+ * @param	InCommand			The Git command - e.g. add
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
+ * @param	InParameters		The parameters to the Git command
+ * @param	InFiles				The files to be operated on
+ * @param	OutResults			The results (from StdOut) as an array per-line
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+bool RunCommandWithPathspecs(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git "commit" command, creating exactly one commit whatever the number of files.
+ *
+ * Since Git 2.25 all files are passed to a single invocation through "--pathspec-from-file".
+ * Before that the commit is amended by batches of files, and rolled back to the original HEAD if any batch fails.
  *
  * @param	InPathToGitBinary	The path to the Git binary
  * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
@@ -195,7 +272,8 @@ TArray<FString> AbsoluteFilenames(const TArray<FString>& InFileNames, const FStr
 
 /**
  * Helper function for various commands to update cached states.
- * @returns true if any states were updated
+ * The states are queued to the provider, which applies them to the cache from its Tick() within the budget of each frame (thread-safe).
+ * @returns true if any states were queued
  */
 bool UpdateCachedStates(const TArray<FGitSourceControlState>& InStates);
 
@@ -219,21 +297,27 @@ bool GetAllLocks(const FString& InPathToGitBinary, const FString& InRepositoryRo
 
 bool GetAllLocksFromRemote(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks);
 /**
- * Save locks into lockFiles
+ * Record the locks of the local user (files relative to the repository root) in the lock table
  */
-bool CacheLock(TArray<FString>& InFiles);
+bool CacheLock(const FString& InRepositoryRoot, const TArray<FString>& InFiles);
 
 /**
- * Save locks into lockFiles
+ * Remove the locks of the local user (files relative to the repository root) from the lock table
  */
-bool CacheLockRemove(TArray<FString>& InFiles);
-
-bool GetCacheFile(FString& FileName);
+bool CacheLockRemove(const FString& InRepositoryRoot, const TArray<FString>& InFiles);
 
+/**
+ * Replace the lock table by the locks of the server, if they could be queried for all the repositories
+ * @param	Changed		Files (absolute paths) locked, unlocked or locked by another user since the last update
+ * @returns true if the locks of the server could be queried
+ */
 bool UpdateLockCaches(TArray<FString>& Changed, const FString& PathToGitBinary, const FString& PathToRepositoryRoot, const FString& LfsUserName);
 
 bool GetSubModulesRoots(TArray<FString>& SubModules);
 
 bool FindRepoRoot(const FString& FileName, FString& RepoRoot);
 
+/** Same as above, checking the existence of relative filenames with a cache shared by the files of an operation */
+bool FindRepoRoot(const FString& FileName, FString& RepoRoot, FGitFileExistenceCache& InExistenceCache);
+
 }
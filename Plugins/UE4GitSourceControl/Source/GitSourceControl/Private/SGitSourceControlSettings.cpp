@@ -337,6 +337,30 @@ void SGitSourceControlSettings::Construct(const FArguments& InArgs)
 					.Font(Font)
 				]
 			]
+			// Option to configure the repository and its submodules to speed up "git status" (false by default)
+			+SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(2.0f)
+			.VAlign(VAlign_Center)
+			[
+				SNew(SHorizontalBox)
+				.ToolTipText(LOCTEXT("UseStatusAcceleration_Tooltip", "At Connect, enable the file system monitor, the untracked cache, feature.manyFiles and index v4 in the repository and its submodules (depending on the version of Git)."))
+				+SHorizontalBox::Slot()
+				.FillWidth(0.1f)
+				[
+					SNew(SCheckBox)
+					.IsChecked(this, &SGitSourceControlSettings::IsUsingStatusAcceleration)
+					.OnCheckStateChanged(this, &SGitSourceControlSettings::OnCheckedUseStatusAcceleration)
+				]
+				+SHorizontalBox::Slot()
+				.FillWidth(2.9f)
+				.VAlign(VAlign_Center)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("UseStatusAcceleration", "Configure the repository for faster status (fsmonitor, untracked cache)"))
+					.Font(Font)
+				]
+			]
 			// Option to Make the initial Git commit with custom message
 			+SVerticalBox::Slot()
 			.AutoHeight()
@@ -744,6 +768,19 @@ ECheckBoxState SGitSourceControlSettings::IsUsingGitLfsLocking() const
 	return ECheckBoxState::Checked;
 }
 
+void SGitSourceControlSettings::OnCheckedUseStatusAcceleration(ECheckBoxState NewCheckedState)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	GitSourceControl.AccessSettings().SetUsingStatusAcceleration(NewCheckedState == ECheckBoxState::Checked);
+	GitSourceControl.AccessSettings().SaveSettings();
+}
+
+ECheckBoxState SGitSourceControlSettings::IsUsingStatusAcceleration() const
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	return GitSourceControl.AccessSettings().IsUsingStatusAcceleration() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
 void SGitSourceControlSettings::OnLfsUserNameCommited(const FText& InText, ETextCommit::Type InCommitType)
 {
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
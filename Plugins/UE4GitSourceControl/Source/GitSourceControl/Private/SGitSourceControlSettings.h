@@ -72,6 +72,9 @@ private:
 	ECheckBoxState IsUsingGitLfsLocking() const;
 	bool GetIsUsingGitLfsLocking() const;
 
+	void OnCheckedUseStatusAcceleration(ECheckBoxState NewCheckedState);
+	ECheckBoxState IsUsingStatusAcceleration() const;
+
 	void OnLfsUserNameCommited(const FText& InText, ETextCommit::Type InCommitType);
 	FText GetLfsUserName() const;
 